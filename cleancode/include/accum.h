@@ -0,0 +1,41 @@
+#pragma once
+#include "shape_types.h"
+
+// How the collector reductions accumulate their f32 columns
+enum accum_policy : u32 {
+    Accum_F32,       // f32 lanes, fastest; error grows with the element count
+    Accum_F64,       // f32 loads widened to f64 lanes
+    Accum_Neumaier,  // f32 lanes with a running Neumaier compensation
+    Accum_Pairwise,  // f32 kernels over fixed blocks, blocks combined pairwise
+
+    Accum_PolicyCount
+};
+
+// K-way unrolled reduction: Sum(Count, Term) adds Term(0) .. Term(Count - 1)
+// into K independent accumulator chains, so K terms are in flight at once.
+// The remainder of Count % K terms goes into the first chains, and the chains
+// are combined pairwise. The 4/8/16 variants of every engine come from here.
+template <u32 K>
+struct Accum {
+    static_assert(K > 0 && (K & (K - 1)) == 0, "K must be a power of two");
+
+    template <class Term>
+    static f32 Sum(u32 Count, Term&& term) {
+        f32 Chains[K] = {};
+        u32 i = 0;
+        for (; i + K <= Count; i += K) {
+            for (u32 k = 0; k < K; ++k) {
+                Chains[k] += term(i + k);
+            }
+        }
+        for (u32 k = 0; i < Count; ++i, ++k) {
+            Chains[k] += term(i);
+        }
+        for (u32 width = K / 2; width > 0; width /= 2) {
+            for (u32 k = 0; k < width; ++k) {
+                Chains[k] += Chains[k + width];
+            }
+        }
+        return Chains[0];
+    }
+};
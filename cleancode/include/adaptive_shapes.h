@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include "shapes.h"
+#include "shape_arena.h"
+
+// One totalArea()/cornerArea() facade over the clean code, switch, table and
+// collector engines. The shape_union records are the data; the objects of the
+// clean code engine and the collector columns are derived from them on
+// demand and go stale on every mutation. Each query picks the engine with
+// the lowest expected cost per query:
+//
+//     Query[e] + (e is built ? 0 : Build[e] / expected queries until the next mutation)
+//
+// Query and Build come from a startup calibration; the expected number of
+// queries is a running average over the past runs of queries between
+// mutations. A collector is therefore only built once the data is queried
+// often enough between changes to pay for it.
+
+enum adaptive_engine : u32 {
+    Adaptive_VTBL,
+    Adaptive_Switch,
+    Adaptive_Table,
+    Adaptive_Collector,
+    Adaptive_EngineCount,
+};
+
+const char* AdaptiveEngineName(adaptive_engine engine);
+
+// Costs in ns per shape, measured by AdaptiveShapes::calibrate()
+struct adaptive_profile {
+    double Build[Adaptive_EngineCount] = {};
+    double Total[Adaptive_EngineCount] = {};
+    double Corner[Adaptive_EngineCount] = {};
+};
+
+// Shapes timed by the calibration: the columns stay in L2, so the profile
+// ranks the engines by work per shape rather than by memory bandwidth
+constexpr u32 AdaptiveSampleSize = 64 * 1024;
+
+class AdaptiveShapes {
+public:
+    // Uses DefaultAdaptiveProfile()
+    AdaptiveShapes();
+    explicit AdaptiveShapes(const adaptive_profile& ProfileInit) : Profile(ProfileInit) { }
+    AdaptiveShapes(const AdaptiveShapes&) = delete;
+    AdaptiveShapes& operator=(const AdaptiveShapes&) = delete;
+
+    u32 add(const shape_union& shape);
+    void set(u32 index, const shape_union& shape);
+    const shape_union& get(u32 index) const { return records[index]; }
+    size_t size() const { return records.size(); }
+
+    f32 totalArea() { return query(false); }
+    f32 cornerArea() { return query(true); }
+
+    // Pins every query to one engine; Adaptive_EngineCount chooses again
+    void force(adaptive_engine engine) { Forced = engine; }
+    adaptive_engine lastEngine() const { return Last; }
+    bool built(adaptive_engine engine) const { return Built[engine]; }
+    double queriesPerMutation() const { return QueriesPerMutation; }
+    const adaptive_profile& profile() const { return Profile; }
+
+    // Build and query times of every engine over SampleCount generated shapes
+    static adaptive_profile calibrate(u32 SampleCount = AdaptiveSampleSize);
+
+private:
+    f32 query(bool Corner);
+    adaptive_engine choose(bool Corner) const;
+    void build(adaptive_engine engine);
+    f32 run(adaptive_engine engine, bool Corner);
+    void mutated();
+
+    adaptive_profile Profile;
+    std::vector<shape_union> records;
+
+    // Derived representations
+    ShapeArena arena;
+    std::vector<shape_base*> objects;
+    aligned_vector<f32> areas;
+    aligned_vector<f32> weights;
+    bool Built[Adaptive_EngineCount] = {false, true, true, false};
+
+    // Queries since the last mutation, and their running average over the
+    // earlier runs
+    u64 RunQueries = 0;
+    double QueriesPerMutation = 1.0;
+    bool Mutated = false;
+
+    adaptive_engine Forced = Adaptive_EngineCount;
+    adaptive_engine Last = Adaptive_Table;
+};
+
+// Calibrated once, on first use
+const adaptive_profile& DefaultAdaptiveProfile();
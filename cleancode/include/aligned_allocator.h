@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <vector>
+
+constexpr size_t CacheLineSize = 64;
+
+// Allocator for the collector columns: every block starts on a cache line
+// and is rounded up to whole lines, so a full-width vector load anywhere in
+// the column never splits a line and never reaches into another allocation.
+template <class T, size_t Alignment = CacheLineSize>
+struct aligned_allocator {
+    static_assert(Alignment >= alignof(T) && (Alignment & (Alignment - 1)) == 0, "alignment must be a power of two");
+    using value_type = T;
+
+    template <class U>
+    struct rebind {
+        using other = aligned_allocator<U, Alignment>;
+    };
+
+    aligned_allocator() noexcept { }
+    template <class U>
+    aligned_allocator(const aligned_allocator<U, Alignment>&) noexcept { }
+
+    static size_t PaddedBytes(size_t count) { return (count * sizeof(T) + Alignment - 1) / Alignment * Alignment; }
+
+    T* allocate(size_t count) {
+        return static_cast<T*>(::operator new(PaddedBytes(count), std::align_val_t(Alignment)));
+    }
+    void deallocate(T* p, size_t count) noexcept {
+        ::operator delete(p, PaddedBytes(count), std::align_val_t(Alignment));
+    }
+};
+
+template <class T, class U, size_t Alignment>
+bool operator==(const aligned_allocator<T, Alignment>&, const aligned_allocator<U, Alignment>&) { return true; }
+template <class T, class U, size_t Alignment>
+bool operator!=(const aligned_allocator<T, Alignment>&, const aligned_allocator<U, Alignment>&) { return false; }
+
+template <class T>
+using aligned_vector = std::vector<T, aligned_allocator<T>>;
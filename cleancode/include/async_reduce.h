@@ -0,0 +1,54 @@
+#pragma once
+#include <atomic>
+#include <future>
+#include <memory>
+#include "shapes.h"
+
+class ThreadPool;
+
+// Reductions that return at once and finish on the pool workers, so an event
+// loop never runs a pass itself. The columns are reduced in chunks, one pool
+// task per chunk: after every chunk a lane re-queues itself behind the tasks
+// submitted meanwhile, and checks its cancel_token.
+//
+//     cancel_token token;
+//     std::future<async_result> total = TotalAreaAsync(collector, pool, token);
+//     ...
+//     token.cancel();  // client went away; the future is ready within a chunk
+//
+// The collector must not change until the future is ready. On a pool without
+// workers the reduction runs inside the call.
+
+// Rows per cooperative chunk: 1 MB of areas, a few tens of microseconds of
+// pool time between two chances for other tasks to run
+constexpr size_t AsyncChunkSize = 256 * 1024;
+
+// Shared flag; copies cancel the same reduction
+class cancel_token {
+public:
+    cancel_token() : Flag(std::make_shared<std::atomic<bool>>(false)) { }
+
+    void cancel() const { Flag->store(true, std::memory_order_relaxed); }
+    bool cancelled() const { return Flag->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> Flag;
+};
+
+// Value is 0 when the reduction was cancelled before its last chunk
+struct async_result {
+    f32 Value = 0.0f;
+    bool Cancelled = false;
+};
+
+// Chunk partials are added in order in double, so a result only depends on
+// the data and the chunk size, not on the number of workers
+std::future<async_result> TotalAreaAsync(const aligned_vector<f32>& areas, ThreadPool& pool,
+                                         const cancel_token& token = cancel_token(),
+                                         size_t chunk_size = AsyncChunkSize);
+std::future<async_result> TotalAreaAsync(const AreaCollector& collector, ThreadPool& pool,
+                                         const cancel_token& token = cancel_token(),
+                                         size_t chunk_size = AsyncChunkSize);
+std::future<async_result> CornerAreaAsync(const CornerCollector& collector, ThreadPool& pool,
+                                          const cancel_token& token = cancel_token(),
+                                          size_t chunk_size = AsyncChunkSize);
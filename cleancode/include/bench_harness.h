@@ -0,0 +1,143 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "shape_types.h"
+
+// Forces value to be materialized, so a computation whose result is unused
+// is not removed
+template <class T>
+inline void DoNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// The compiler must assume any memory was read or written here, so calls
+// that only depend on unchanged memory cannot be hoisted out of the loop
+inline void ClobberMemory() {
+    asm volatile("" : : : "memory");
+}
+
+struct bench_options {
+    u32 warmup = 10;        // untimed runs before the samples
+    u32 samples = 1000;     // timed runs, one sample each
+    int cpu = -1;           // CPU to pin the benchmark thread to, -1 = not pinned
+    bool counters = false;  // read hardware counters around the samples
+};
+
+// Hardware counters, averaged per run
+struct bench_counters {
+    double cycles = 0.0;
+    double instructions = 0.0;
+    double llc_misses = 0.0;
+    double branch_misses = 0.0;
+};
+
+struct bench_stats {
+    u32 samples = 0;
+    u32 outliers = 0;       // samples more than 3 scaled MADs above the median
+    double median_ms = 0.0;
+    double p99_ms = 0.0;
+    double min_ms = 0.0;
+    double mean_ms = 0.0;   // mean and stddev exclude the outliers
+    double stddev_ms = 0.0;
+    bool has_counters = false;
+    bench_counters counters;
+};
+
+// perf_event group of cycles, instructions, LLC misses and branch misses for
+// the calling thread. available() is false where the kernel refuses the
+// events (perf_event_paranoid, no PMU in a VM) or on non-Linux systems.
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const { return fds[0] >= 0; }
+    void start();
+    // Totals since start()
+    bench_counters stop();
+
+private:
+    int fds[4];
+};
+
+// Pins the calling thread to one CPU; returns false if that is not possible
+bool PinToCpu(int cpu);
+// Restores the affinity the thread had before the first PinToCpu
+void UnpinThread();
+
+// Sorts samples_ms in place
+bench_stats ComputeBenchStats(std::vector<double>& samples_ms);
+void PrintBenchStats(const char* name, const bench_stats& stats, f32 result);
+
+// Warm-up, one clock sample per run and optional hardware counters. fn is
+// called as f32 fn(); the memory clobber before every call keeps the compiler
+// from reusing the previous result.
+class BenchHarness {
+public:
+    BenchHarness() { }
+
+    void configure(const bench_options& options);
+    const bench_options& options() const { return opts; }
+
+    // Never warms up for more runs than it samples
+    template <class F>
+    bench_stats measure(u32 count, F&& fn, f32& result) {
+        for (u32 i = 0; i < std::min(opts.warmup, count); ++i) {
+            ClobberMemory();
+            DoNotOptimize(fn());
+        }
+
+        samples.clear();
+        samples.reserve(count);
+        const bool counting = counters && counters->available();
+        if (counting) {
+            counters->start();
+        }
+        for (u32 i = 0; i < count; ++i) {
+            ClobberMemory();
+            auto start = std::chrono::steady_clock::now();
+            result = fn();
+            DoNotOptimize(result);
+            auto end = std::chrono::steady_clock::now();
+            samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        bench_counters totals;
+        if (counting) {
+            totals = counters->stop();
+        }
+
+        bench_stats stats = ComputeBenchStats(samples);
+        if (counting && count > 0) {
+            stats.has_counters = true;
+            stats.counters.cycles = totals.cycles / count;
+            stats.counters.instructions = totals.instructions / count;
+            stats.counters.llc_misses = totals.llc_misses / count;
+            stats.counters.branch_misses = totals.branch_misses / count;
+        }
+        return stats;
+    }
+
+    template <class F>
+    bench_stats measure(F&& fn, f32& result) {
+        return measure(opts.samples, fn, result);
+    }
+
+    // measure() and one report line
+    template <class F>
+    f32 run(const char* name, F&& fn) {
+        f32 result = 0.0f;
+        bench_stats stats = measure(fn, result);
+        PrintBenchStats(name, stats, result);
+        return result;
+    }
+
+private:
+    bench_options opts;
+    std::unique_ptr<PerfCounters> counters;
+    std::vector<double> samples;
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include "shapes.h"
+#include "simd_kernels.h"
+
+// Storage of the area column of a CompactCornerCollector
+enum column_encoding : u32 {
+    Encoding_F32,   // 4 bytes, exact
+    Encoding_F16,   // 2 bytes, IEEE half: 11-bit significand, max 65504
+    Encoding_BF16,  // 2 bytes, f32 exponent range with an 8-bit significand
+
+    Encoding_Count
+};
+
+// Round-to-nearest-even conversions. Halves overflow to infinity; bf16
+// keeps NaNs quiet.
+u16 FloatToHalf(f32 value);
+f32 HalfToFloat(u16 value);
+u16 FloatToBFloat16(f32 value);
+f32 BFloat16ToFloat(u16 value);
+
+// Read-only, bandwidth-reduced copy of a CornerCollector for the reductions:
+// the area column in one of the column_encodings, and the weight column as a
+// u8 index per shape into a table of the weights of the distinct corner counts. An f16 column with
+// indices streams 3 bytes per shape for CornerArea instead of 8.
+class CompactCornerCollector {
+public:
+    CompactCornerCollector() { }
+
+    // Re-encodes the collector from its area and corner count columns; false
+    // and left empty if it holds more than CompactWeightLutSize distinct
+    // corner counts
+    bool encode(const CornerCollector& collector, column_encoding encoding);
+
+    column_encoding encoding() const { return Encoding; }
+    size_t size() const { return weight_index.size(); }
+    // Bytes read by TotalAreaCollector / CornerAreaCollector
+    size_t areaBytes() const;
+    size_t cornerBytes() const { return areaBytes() + weight_index.size() * sizeof(u8); }
+
+    std::vector<f32> float_areas;  // Encoding_F32
+    std::vector<u16> half_areas;   // Encoding_F16 and Encoding_BF16
+    std::vector<u8> weight_index;
+    f32 weight_lut[CompactWeightLutSize] = {};
+
+private:
+    column_encoding Encoding = Encoding_F32;
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include "shapes.h"
+
+// Corner collector that producers append to while readers reduce, without a
+// lock on either side. Each producer thread owns a lane: append-only area and
+// weight columns in fixed segments that never move, and an atomic published
+// size. A row is written first and published with a release store after, so
+// a reader that loads the size sees every row below it complete.
+//
+//     concurrent_lane* lane = collector.addLane();   // once per producer
+//     lane->addShape(shape);
+//     ...
+//     ConcurrentSnapshot view = collector.snapshot(); // any thread
+//     f32 total = TotalAreaCollector(view);
+
+// Rows per segment: 256 KB per column, reduced by one aligned kernel call
+constexpr size_t ConcurrentSegmentRows = 64 * 1024;
+// Segments per lane, so a lane holds up to 256M rows
+constexpr size_t ConcurrentMaxSegments = 4096;
+constexpr u32 ConcurrentMaxLanes = 64;
+
+struct concurrent_segment {
+    alignas(CacheLineSize) f32 Areas[ConcurrentSegmentRows];
+    alignas(CacheLineSize) f32 Weights[ConcurrentSegmentRows];
+};
+
+// Columns of one producer. Only the owning thread may call the add functions;
+// published() and segment() may be called from any thread.
+class concurrent_lane {
+public:
+    concurrent_lane() { }
+    ~concurrent_lane();
+    concurrent_lane(const concurrent_lane&) = delete;
+    concurrent_lane& operator=(const concurrent_lane&) = delete;
+
+    // false once the lane holds ConcurrentMaxSegments full segments
+    bool addShape(shape_base* shape) {
+        size_t row = Size.load(std::memory_order_relaxed);
+        concurrent_segment* segment = writable(row);
+        if (!segment) {
+            return false;
+        }
+        size_t r = row % ConcurrentSegmentRows;
+        segment->Areas[r] = shape->Area();
+        segment->Weights[r] = CornerWeight(shape->CornerCount());
+        Size.store(row + 1, std::memory_order_release);
+        return true;
+    }
+    // Type-run ingest of the whole batch, published with one store; false
+    // and nothing published if the batch does not fit
+    bool addShapes(u32 ShapeCount, shape_base** Shapes);
+
+    size_t published() const { return Size.load(std::memory_order_acquire); }
+    // Segment holding row s * ConcurrentSegmentRows; set for every row below published()
+    const concurrent_segment* segment(size_t s) const { return Segments[s]; }
+
+private:
+    concurrent_segment* writable(size_t row);
+
+    // The published size gets its own line, apart from the directory the
+    // writer updates
+    alignas(CacheLineSize) std::atomic<size_t> Size{0};
+    alignas(CacheLineSize) concurrent_segment* Segments[ConcurrentMaxSegments] = {};
+};
+
+// Published rows of every lane as of ConcurrentCornerCollector::snapshot().
+// Rows never move or change, so the snapshot stays valid while the collector
+// lives, and later appends do not show up in it.
+class ConcurrentSnapshot {
+public:
+    struct lane_rows {
+        const concurrent_lane* Lane;
+        size_t Rows;
+    };
+
+    size_t size() const;
+    const std::vector<lane_rows>& lanes() const { return Lanes; }
+
+private:
+    friend class ConcurrentCornerCollector;
+    std::vector<lane_rows> Lanes;
+};
+
+class ConcurrentCornerCollector {
+public:
+    ConcurrentCornerCollector() { }
+    ~ConcurrentCornerCollector();
+    ConcurrentCornerCollector(const ConcurrentCornerCollector&) = delete;
+    ConcurrentCornerCollector& operator=(const ConcurrentCornerCollector&) = delete;
+
+    // New lane for one producer thread; null once ConcurrentMaxLanes exist
+    concurrent_lane* addLane();
+
+    ConcurrentSnapshot snapshot() const;
+
+private:
+    std::atomic<concurrent_lane*> Lanes[ConcurrentMaxLanes] = {};
+    std::atomic<u32> LaneCount{0};
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "shapes.h"
+
+class ShapeStore;
+
+// Collector columns resident on a compute device. upload() copies the area
+// and weight columns (or expands a ShapeStore into them) once; every later
+// reduction runs on the device and returns only the result.
+//
+//     std::unique_ptr<DeviceCollector> device = MakeDeviceCollector("auto");
+//     device->upload(collector);
+//     f32 total = TotalAreaCollector(*device);
+//
+// The "cpu" backend keeps the columns in host memory and reduces them with
+// the SIMD kernels, so it is always available.
+
+// Both metrics of one fused pass over the resident columns
+struct device_reduction {
+    f32 TotalArea = 0.0f;
+    f32 CornerArea = 0.0f;
+};
+
+class DeviceCollector {
+public:
+    virtual ~DeviceCollector() { }
+
+    virtual const char* backend() const = 0;
+
+    // Replace the resident columns; false if the device is out of memory, in
+    // which case the collector is left empty
+    bool upload(const CornerCollector& collector);
+    virtual bool upload(const f32* areas, const f32* weights, size_t size) = 0;
+    virtual bool upload(const ShapeStore& store) = 0;
+    virtual void release() = 0;
+
+    virtual size_t size() const = 0;
+    virtual f32 totalArea() const = 0;
+    virtual f32 cornerArea() const = 0;
+    // Total and corner area in one read of the area column
+    virtual device_reduction reduce() const = 0;
+};
+
+// Backend by name: "cuda", "cpu", or "auto" for the first usable one in that
+// order. A backend that is not built or finds no device falls back to "cpu".
+std::unique_ptr<DeviceCollector> MakeDeviceCollector(const std::string& backend = "auto");
+
+// Names of the backends usable on this host, best first; always ends in "cpu"
+std::vector<std::string> AvailableDeviceBackends();
+
+// Per-backend factories; nullptr when not built or no device is present
+std::unique_ptr<DeviceCollector> MakeCpuDeviceCollector();
+std::unique_ptr<DeviceCollector> MakeCudaDeviceCollector();
@@ -0,0 +1,159 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <vector>
+#include "shape_types.h"
+
+// Hot-path probes for the engines, compiled in with -DCLEANCODE_INSTRUMENT=ON
+// and removed completely otherwise:
+//
+//     f32 TotalAreaSwitch(u32 ShapeCount, shape_union* Shapes) {
+//         INSTRUMENT_SCOPE("TotalAreaSwitch", ShapeCount, ShapeCount * sizeof(shape_union));
+//         ...
+//
+// A probe reads the timestamp counter on entry and exit and adds the call,
+// its ticks, elements and bytes, and a log2 histogram bucket of the ticks to
+// the calling thread's counters. Call sites of the same name share one
+// probe, so every name is exported once. Each thread writes only its own counters,
+// so recording takes no lock and no atomic read-modify-write; snapshots sum
+// all threads. With CLEANCODE_TRACY or CLEANCODE_ITT every probe also opens
+// a Tracy zone or an ITT task of the same name.
+//
+// The export functions exist in every build and report no probes when the
+// instrumentation is compiled out.
+
+#ifndef CLEANCODE_INSTRUMENT
+#define CLEANCODE_INSTRUMENT 0
+#endif
+
+constexpr bool MetricsEnabled = CLEANCODE_INSTRUMENT != 0;
+
+// Distinct probe names; registering more prints one warning to stderr, and
+// the calls of the names beyond the limit are dropped
+constexpr u32 MetricsMaxProbes = 128;
+// Histogram bucket b counts calls of [2^b, 2^(b+1)) ticks; the last one is open
+constexpr u32 MetricsBuckets = 40;
+
+// Raw timestamp: TSC on x86, the virtual counter on aarch64, steady_clock
+// nanoseconds elsewhere
+inline u64 ReadTimestamp();
+// Timestamp ticks per nanosecond, measured once against steady_clock
+double TimestampTicksPerNs();
+
+struct probe_snapshot {
+    std::string Name;
+    u64 Calls = 0;
+    u64 Ticks = 0;
+    u64 Elements = 0;
+    u64 Bytes = 0;
+    u64 Buckets[MetricsBuckets] = {};
+};
+
+// Totals of every probe over all threads, in registration order
+std::vector<probe_snapshot> SnapshotMetrics();
+// Prometheus text exposition: counters per probe and a call duration histogram
+std::string MetricsPrometheus();
+std::string MetricsJson();
+
+#if defined(__x86_64__) || defined(__i386__)
+inline u64 ReadTimestamp() { return __builtin_ia32_rdtsc(); }
+#elif defined(__aarch64__)
+inline u64 ReadTimestamp() {
+    u64 ticks;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+}
+#else
+u64 SteadyTimestamp();
+inline u64 ReadTimestamp() { return SteadyTimestamp(); }
+#endif
+
+#if CLEANCODE_INSTRUMENT
+
+// Counters of one probe on one thread. Single writer: updated with a relaxed
+// load and store, read by snapshots with relaxed loads.
+struct probe_counters {
+    std::atomic<u64> Calls{0};
+    std::atomic<u64> Ticks{0};
+    std::atomic<u64> Elements{0};
+    std::atomic<u64> Bytes{0};
+    std::atomic<u64> Buckets[MetricsBuckets] = {};
+};
+
+struct thread_metrics {
+    probe_counters Probes[MetricsMaxProbes];
+};
+
+// Id of the probe called name, added on its first registration
+u32 RegisterProbe(const char* name);
+// Counters of the calling thread, registered on its first probe. They are
+// freed at thread exit, after being added to the totals of finished threads.
+thread_metrics& LocalMetrics();
+
+inline void AddCounter(std::atomic<u64>& counter, u64 value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+inline void RecordProbe(u32 Id, u64 Ticks, u64 Elements, u64 Bytes) {
+    if (Id >= MetricsMaxProbes) {
+        return;
+    }
+    thread_local thread_metrics& metrics = LocalMetrics();
+    probe_counters& probe = metrics.Probes[Id];
+    AddCounter(probe.Calls, 1);
+    AddCounter(probe.Ticks, Ticks);
+    AddCounter(probe.Elements, Elements);
+    AddCounter(probe.Bytes, Bytes);
+    u32 bucket = 63u - static_cast<u32>(__builtin_clzll(Ticks | 1));
+    AddCounter(probe.Buckets[bucket < MetricsBuckets ? bucket : MetricsBuckets - 1], 1);
+}
+
+class scoped_probe {
+public:
+    scoped_probe(u32 IdInit, u64 ElementsInit, u64 BytesInit)
+        : Id(IdInit), Elements(ElementsInit), Bytes(BytesInit), Start(ReadTimestamp()) { }
+    ~scoped_probe() { RecordProbe(Id, ReadTimestamp() - Start, Elements, Bytes); }
+    scoped_probe(const scoped_probe&) = delete;
+    scoped_probe& operator=(const scoped_probe&) = delete;
+
+private:
+    u32 Id;
+    u64 Elements;
+    u64 Bytes;
+    u64 Start;
+};
+
+#define INSTRUMENT_CONCAT2(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT2(a, b)
+#define INSTRUMENT_ID(prefix) INSTRUMENT_CONCAT(prefix, __LINE__)
+
+#if defined(CLEANCODE_TRACY)
+#include <tracy/Tracy.hpp>
+#define INSTRUMENT_ZONE(name) ZoneScopedN(name)
+#elif defined(CLEANCODE_ITT)
+#include <ittnotify.h>
+__itt_domain* InstrumentDomain();
+class itt_zone {
+public:
+    explicit itt_zone(__itt_string_handle* name) { __itt_task_begin(InstrumentDomain(), __itt_null, __itt_null, name); }
+    ~itt_zone() { __itt_task_end(InstrumentDomain()); }
+};
+#define INSTRUMENT_ZONE(name)                                                                      \
+    static __itt_string_handle* const INSTRUMENT_ID(instrument_itt_) = __itt_string_handle_create(name); \
+    itt_zone INSTRUMENT_ID(instrument_zone_)(INSTRUMENT_ID(instrument_itt_))
+#else
+#define INSTRUMENT_ZONE(name) ((void)0)
+#endif
+
+// name must be a string literal; elements and bytes are only evaluated in
+// instrumented builds
+#define INSTRUMENT_SCOPE(name, elements, bytes)                                            \
+    static const u32 INSTRUMENT_ID(instrument_probe_) = RegisterProbe(name);                \
+    scoped_probe INSTRUMENT_ID(instrument_scope_)(INSTRUMENT_ID(instrument_probe_), (elements), (bytes)); \
+    INSTRUMENT_ZONE(name)
+
+#else
+
+#define INSTRUMENT_SCOPE(name, elements, bytes) ((void)0)
+
+#endif
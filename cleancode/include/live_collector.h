@@ -0,0 +1,189 @@
+#pragma once
+#include "shapes.h"
+
+using shape_handle = u32;
+
+// Maps stable handles to slots of densely packed collector columns.
+// Slots are compacted by swap-and-pop, handles are recycled after removal.
+class handle_table {
+public:
+    static constexpr u32 InvalidSlot = ~0u;
+
+    shape_handle acquire(u32 slot) {
+        shape_handle handle;
+        if (!free_handles.empty()) {
+            handle = free_handles.back();
+            free_handles.pop_back();
+            handle_slots[handle] = slot;
+        } else {
+            handle = static_cast<shape_handle>(handle_slots.size());
+            handle_slots.push_back(slot);
+        }
+        slot_handles.push_back(handle);
+        return handle;
+    }
+
+    u32 slot(shape_handle handle) const { return handle_slots[handle]; }
+    bool valid(shape_handle handle) const {
+        return handle < handle_slots.size() && handle_slots[handle] != InvalidSlot;
+    }
+
+    // Frees the handle and moves the last slot into its place; returns the
+    // vacated slot so the caller can apply the same move to its columns, or
+    // InvalidSlot and no change for a stale or already released handle
+    u32 release(shape_handle handle) {
+        if (!valid(handle)) {
+            return InvalidSlot;
+        }
+        u32 slot = handle_slots[handle];
+        shape_handle last = slot_handles.back();
+        slot_handles[slot] = last;
+        handle_slots[last] = slot;
+        slot_handles.pop_back();
+        handle_slots[handle] = InvalidSlot;
+        free_handles.push_back(handle);
+        return slot;
+    }
+
+private:
+    std::vector<u32> handle_slots;           // slot per handle
+    std::vector<shape_handle> slot_handles;  // handle per slot
+    std::vector<shape_handle> free_handles;
+};
+
+// Overwrites column[slot] with its last element and drops the last element
+template <class T, class Allocator>
+void SwapAndPop(std::vector<T, Allocator>& column, u32 slot) {
+    column[slot] = column.back();
+    column.pop_back();
+}
+
+// AreaCollector whose entries can be refreshed and removed after insertion.
+// The running total is adjusted in O(1) per change and kept in double so the
+// deltas do not drift; resync() recomputes it from the column. The base is
+// private: every change goes through the handle table and the total, and
+// readers only get the const area view. updateShape() and removeShape()
+// return false and leave the collector untouched for a handle that is not
+// contained, e.g. one removed before.
+class LiveAreaCollector : private AreaCollector {
+public:
+    LiveAreaCollector() { }
+
+    shape_handle addShape(shape_base* shape) {
+        f32 area = shape->Area();
+        shape_handle handle = handles.acquire(static_cast<u32>(area_column.size()));
+        area_column.push_back(area);
+        shapes.push_back(shape);
+        total += area;
+        return handle;
+    }
+
+    // Re-reads the area after the shape behind the handle changed
+    bool updateShape(shape_handle handle) {
+        if (!contains(handle)) {
+            return false;
+        }
+        u32 slot = handles.slot(handle);
+        f32 area = shapes[slot]->Area();
+        total += double(area) - double(area_column[slot]);
+        area_column[slot] = area;
+        return true;
+    }
+
+    bool removeShape(shape_handle handle) {
+        if (!contains(handle)) {
+            return false;
+        }
+        u32 slot = handles.release(handle);
+        total -= area_column[slot];
+        SwapAndPop(area_column, slot);
+        SwapAndPop(shapes, slot);
+        return true;
+    }
+
+    shape_base* shape(shape_handle handle) const { return contains(handle) ? shapes[handles.slot(handle)] : nullptr; }
+    bool contains(shape_handle handle) const { return handles.valid(handle); }
+    using AreaCollector::areas;
+    using AreaCollector::size;
+
+    f32 totalArea() const { return static_cast<f32>(total); }
+    void resync() {
+        total = 0.0;
+        for (f32 area : area_column) {
+            total += area;
+        }
+    }
+
+private:
+    handle_table handles;
+    std::vector<shape_base*> shapes;
+    double total = 0.0;
+};
+
+// CornerCollector counterpart of LiveAreaCollector; every change reads the
+// old weight from the weight column.
+class LiveCornerCollector : private CornerCollector {
+public:
+    LiveCornerCollector() { }
+
+    shape_handle addShape(shape_base* shape) {
+        f32 area = shape->Area();
+        u32 corner_count = shape->CornerCount();
+        f32 weight = CornerWeight(corner_count);
+        shape_handle handle = handles.acquire(static_cast<u32>(area_column.size()));
+        area_column.push_back(area);
+        addCornerCount(corner_count);
+        shapes.push_back(shape);
+        total += area * weight;
+        return handle;
+    }
+
+    bool updateShape(shape_handle handle) {
+        if (!contains(handle)) {
+            return false;
+        }
+        u32 slot = handles.slot(handle);
+        shape_base* shape = shapes[slot];
+        f32 area = shape->Area();
+        u32 corner_count = shape->CornerCount();
+        f32 weight = CornerWeight(corner_count);
+        total += double(area * weight) - double(area_column[slot] * weight_column[slot]);
+        area_column[slot] = area;
+        corner_counts[slot] = static_cast<u8>(corner_count);
+        weight_column[slot] = weight;
+        return true;
+    }
+
+    bool removeShape(shape_handle handle) {
+        if (!contains(handle)) {
+            return false;
+        }
+        u32 slot = handles.release(handle);
+        total -= area_column[slot] * weight_column[slot];
+        SwapAndPop(area_column, slot);
+        SwapAndPop(corner_counts, slot);
+        SwapAndPop(weight_column, slot);
+        SwapAndPop(shapes, slot);
+        return true;
+    }
+
+    shape_base* shape(shape_handle handle) const { return contains(handle) ? shapes[handles.slot(handle)] : nullptr; }
+    bool contains(shape_handle handle) const { return handles.valid(handle); }
+    using CornerCollector::areas;
+    using CornerCollector::size;
+    using CornerCollector::cornerCounts;
+    using CornerCollector::weights;
+
+    f32 cornerArea() const { return static_cast<f32>(total); }
+    void resync() {
+        total = 0.0;
+        for (size_t i = 0; i < area_column.size(); ++i) {
+            total += area_column[i] * weight_column[i];
+        }
+    }
+
+private:
+    handle_table handles;
+    std::vector<shape_base*> shapes;
+    double total = 0.0;
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <vector>
+#include "shapes.h"
+#include "thread_pool.h"
+
+// CPUs of one NUMA node
+struct numa_node {
+    u32 Id;
+    std::vector<int> Cpus;
+};
+
+// Nodes that have CPUs, from /sys/devices/system/node; a single node holding
+// every CPU where the topology is not exposed
+std::vector<numa_node> NumaNodes();
+
+// Page-granular f32 buffer that is mapped but not touched on allocation, so
+// the first thread writing a page decides the node it lands on
+class page_buffer {
+public:
+    page_buffer() { }
+    explicit page_buffer(size_t count);
+    ~page_buffer();
+    page_buffer(page_buffer&& other) noexcept;
+    page_buffer& operator=(page_buffer&& other) noexcept;
+    page_buffer(const page_buffer&) = delete;
+    page_buffer& operator=(const page_buffer&) = delete;
+
+    f32* data() const { return Data; }
+
+private:
+    f32* Data = nullptr;
+    size_t Bytes = 0;
+};
+
+// CornerCollector partitioned over NUMA nodes. Every node owns a contiguous
+// segment of the shapes and a pool whose workers are bound to its CPUs. Those
+// workers write the segment first, which places its pages on the node, and
+// reduce it later, so no read after ingest crosses the interconnect.
+class NumaCornerCollector {
+public:
+    explicit NumaCornerCollector(const std::vector<numa_node>& nodes = NumaNodes());
+
+    // Replaces the contents. Each node takes a share proportional to its CPU count.
+    void assign(u32 ShapeCount, shape_base** Shapes);
+
+    size_t size() const { return Size; }
+    u32 nodeCount() const { return static_cast<u32>(segments.size()); }
+    const numa_node& node(u32 n) const { return segments[n].Node; }
+    size_t segmentSize(u32 n) const { return segments[n].Count; }
+
+    // All nodes reduce their own segments concurrently. Partials are combined
+    // in node and chunk order, so the result does not depend on scheduling.
+    f32 totalArea();
+    f32 cornerArea();
+
+    // Segment n reduced by the workers of node reader; reader != n reads remotely
+    f32 segmentTotalArea(u32 n, u32 reader);
+    f32 segmentCornerArea(u32 n, u32 reader);
+
+private:
+    struct segment {
+        numa_node Node;
+        std::unique_ptr<ThreadPool> Pool;
+        page_buffer Areas;
+        page_buffer Weights;
+        size_t Count = 0;
+    };
+
+    // fn(segment, begin, count) for every chunk of the listed segments, each on
+    // the pool of reader, or of its own node when reader is AllNodes
+    static constexpr u32 AllNodes = ~0u;
+    void run(const std::vector<u32>& which, u32 reader, const std::function<void(u32, size_t, size_t)>& fn);
+    f32 reduce(const std::vector<u32>& which, u32 reader, bool weighted);
+
+    std::vector<segment> segments;
+    size_t Size = 0;
+};
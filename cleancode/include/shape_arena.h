@@ -0,0 +1,99 @@
+#pragma once
+#include <memory>
+#include <new>
+#include <tuple>
+#include <utility>
+#include "shapes.h"
+
+// Chunked storage for objects of one shape class. Objects never move, so the
+// returned pointers stay valid until reset(). reset() destroys all objects at
+// once and keeps the chunks for the next batch.
+template <class T>
+class ShapePool {
+public:
+    static constexpr size_t ChunkObjects = 4096;
+
+    ShapePool() { }
+    ~ShapePool() { reset(); }
+    ShapePool(const ShapePool&) = delete;
+    ShapePool& operator=(const ShapePool&) = delete;
+
+    template <class... Args>
+    T* make(Args&&... args) {
+        size_t chunk = count / ChunkObjects;
+        if (chunk == chunks.size()) {
+            chunks.emplace_back(new storage[ChunkObjects]);
+        }
+        void* slot = &chunks[chunk][count % ChunkObjects];
+        T* object = new (slot) T(std::forward<Args>(args)...);
+        ++count;
+        return object;
+    }
+
+    void reset() {
+        for (size_t i = 0; i < count; ++i) {
+            // Qualified call: the dynamic type is known, skip the vtable
+            get(i)->T::~T();
+        }
+        count = 0;
+    }
+
+    // Returns the chunks to the heap
+    void release() {
+        reset();
+        chunks.clear();
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return chunks.size() * ChunkObjects; }
+
+private:
+    struct storage {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    T* get(size_t i) {
+        return reinterpret_cast<T*>(&chunks[i / ChunkObjects][i % ChunkObjects]);
+    }
+
+    std::vector<std::unique_ptr<storage[]>> chunks;
+    size_t count = 0;
+};
+
+// One pool per shape class. Use one arena per producer thread - local()
+// returns the calling thread's arena, so concurrent producers never contend.
+// Objects from the thread-local arena die with their thread.
+class ShapeArena {
+public:
+    ShapeArena() { }
+    ShapeArena(const ShapeArena&) = delete;
+    ShapeArena& operator=(const ShapeArena&) = delete;
+
+    template <class T, class... Args>
+    T* make(Args&&... args) {
+        return pool<T>().make(std::forward<Args>(args)...);
+    }
+
+    template <class T>
+    ShapePool<T>& pool() { return std::get<ShapePool<T>>(pools); }
+
+    void reset() {
+        std::apply([](auto&... pool) { (pool.reset(), ...); }, pools);
+    }
+
+    void release() {
+        std::apply([](auto&... pool) { (pool.release(), ...); }, pools);
+    }
+
+    size_t size() const {
+        return std::apply([](const auto&... pool) { return (pool.size() + ...); }, pools);
+    }
+
+    static ShapeArena& local() {
+        thread_local ShapeArena arena;
+        return arena;
+    }
+
+private:
+    std::tuple<ShapePool<square>, ShapePool<rectangle>, ShapePool<triangle>, ShapePool<circle>> pools;
+};
@@ -0,0 +1,18 @@
+#pragma once
+#include "shapes.h"
+
+// Opt-in batching stage for the OOP path: the shape_base* array is regrouped
+// by dynamic type once, and steady-state passes then make one virtual call
+// per type run through shape_base::AreaBatch instead of one per shape.
+class ShapeBatches {
+public:
+    struct run {
+        u32 Begin;
+        u32 Count;
+    };
+
+    ShapeBatches(u32 ShapeCount, shape_base** Shapes);
+
+    std::vector<shape_base*> shapes;   // input pointers, grouped by type
+    std::vector<run> runs;             // one run per dynamic type
+};
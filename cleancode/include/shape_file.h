@@ -0,0 +1,96 @@
+#pragma once
+#include <string>
+#include "shapes.h"
+
+class ShapeStore;
+
+// Columnar shape file: the collector layout written to disk, so a mapping of
+// the file is a ready collector. Native byte order; every column starts on a
+// ShapeFileAlignment boundary:
+//
+//     shape_file_header | u8 types[N] | f32 areas[N] | f32 weights[N]
+constexpr u32 ShapeFileVersion = 1;
+constexpr size_t ShapeFileAlignment = 64;
+
+struct shape_file_header {
+    char Magic[8];       // "SHAPECOL"
+    u32 Version;         // ShapeFileVersion; also fails for a byte-swapped file
+    u32 HeaderBytes;     // sizeof(shape_file_header)
+    u64 ShapeCount;
+    u64 TypesOffset;     // byte offsets from the start of the file
+    u64 AreasOffset;
+    u64 WeightsOffset;
+    u64 FileBytes;
+    u8 Reserved[8];
+};
+static_assert(sizeof(shape_file_header) == ShapeFileAlignment, "header fills one aligned block");
+
+// Writes the columns of the collector with one type tag per shape; false on
+// an I/O error
+bool WriteShapeFile(const std::string& path, const CornerCollector& collector, const u8* types);
+bool WriteShapeFile(const std::string& path, const ShapeStore& store);
+
+// Read-only collector over a mapped shape file. Opening validates the header
+// and maps the file; the reductions then read the page cache directly, with
+// nothing parsed or copied.
+class MappedCollector {
+public:
+    MappedCollector() { }
+    ~MappedCollector() { close(); }
+    MappedCollector(const MappedCollector&) = delete;
+    MappedCollector& operator=(const MappedCollector&) = delete;
+
+    // false if the file is missing, truncated or not a shape file
+    bool open(const std::string& path);
+    void close();
+    bool isOpen() const { return Base != nullptr; }
+
+    size_t size() const { return Count; }
+    size_t bytes() const { return Bytes; }
+    const u8* types() const { return Types; }
+    const f32* areas() const { return Areas; }
+    const f32* weights() const { return Weights; }
+
+    // Paging hints for the area and weight rows [begin, begin + count):
+    // read-ahead for a scan, start reading a range now, drop a consumed range
+    // from the process (the page cache keeps it). No-ops where unsupported.
+    void adviseSequential() const;
+    void willNeed(size_t begin, size_t count) const;
+    void dontNeed(size_t begin, size_t count) const;
+
+private:
+    enum page_advice { Advice_Sequential, Advice_WillNeed, Advice_DontNeed };
+    void advise(size_t begin, size_t count, page_advice advice) const;
+
+    const u8* Base = nullptr;
+    size_t Bytes = 0;
+    size_t Count = 0;
+    const u8* Types = nullptr;
+    const f32* Areas = nullptr;
+    const f32* Weights = nullptr;
+};
+
+// Sequential reader of the area and weight columns of a shape file, for
+// inputs that are not to be mapped. Every read() is one pread per column.
+class ShapeFileReader {
+public:
+    ShapeFileReader() { }
+    ~ShapeFileReader() { close(); }
+    ShapeFileReader(const ShapeFileReader&) = delete;
+    ShapeFileReader& operator=(const ShapeFileReader&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+    size_t size() const { return Count; }
+
+    // Reads up to capacity rows from the current position; weights may be
+    // null. Returns the row count, 0 at the end or on an error.
+    size_t read(f32* areas, f32* weights, size_t capacity);
+
+private:
+    int File = -1;
+    size_t Count = 0;
+    size_t Position = 0;
+    u64 AreasOffset = 0;
+    u64 WeightsOffset = 0;
+};
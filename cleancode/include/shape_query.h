@@ -0,0 +1,124 @@
+#pragma once
+#include <limits>
+#include <vector>
+#include "shape_store.h"
+
+// Lazy aggregate queries over a ShapeStore. A query collects filters and
+// aggregates, and run() evaluates all of them in a single pass over the
+// columns, so five aggregates cost one read of the data instead of five:
+//
+//     query_result r = Query(store).filter(QueryType == Shape_Circle)
+//                          .sum(QueryArea).sum(QueryArea * QueryWeight).count().run();
+//
+// Every aggregate is the sum of a product of fields. Per type, the weight and
+// corner count are constants and area is Coefficient * Width * Height, so a
+// product reduces to a per-type constant times Width^p * Height^q.
+
+// Highest power of Width or Height one product may reach; QueryArea counts
+// once towards both
+constexpr u32 QueryMaxPower = 4;
+
+// Product of fields; the members are the exponents
+struct query_expr {
+    u8 Area = 0;
+    u8 Weight = 0;
+    u8 Corners = 0;
+    u8 Width = 0;
+    u8 Height = 0;
+};
+
+inline query_expr operator*(query_expr a, const query_expr& b) {
+    a.Area += b.Area;
+    a.Weight += b.Weight;
+    a.Corners += b.Corners;
+    a.Width += b.Width;
+    a.Height += b.Height;
+    return a;
+}
+
+// Shapes a query looks at: a set of types and a half-open area range
+struct query_filter {
+    u32 TypeMask = (1u << Shape_Count) - 1;
+    f32 AreaMin = -std::numeric_limits<f32>::infinity();
+    f32 AreaMax = std::numeric_limits<f32>::infinity();
+};
+
+// Both filters must hold
+inline query_filter operator&&(query_filter a, const query_filter& b) {
+    a.TypeMask &= b.TypeMask;
+    a.AreaMin = a.AreaMin > b.AreaMin ? a.AreaMin : b.AreaMin;
+    a.AreaMax = a.AreaMax < b.AreaMax ? a.AreaMax : b.AreaMax;
+    return a;
+}
+
+struct query_type_field { };
+
+inline query_filter operator==(query_type_field, shape_type Type) {
+    query_filter f;
+    f.TypeMask = 1u << Type;
+    return f;
+}
+
+inline query_filter operator!=(query_type_field, shape_type Type) {
+    query_filter f;
+    f.TypeMask &= ~(1u << Type);
+    return f;
+}
+
+// QueryArea is both a product factor and a filter field
+struct query_area_field : query_expr {
+    constexpr query_area_field() : query_expr{1, 0, 0, 0, 0} { }
+};
+
+inline query_filter operator>=(query_area_field, f32 Value) {
+    query_filter f;
+    f.AreaMin = Value;
+    return f;
+}
+
+inline query_filter operator<(query_area_field, f32 Value) {
+    query_filter f;
+    f.AreaMax = Value;
+    return f;
+}
+
+inline constexpr query_type_field QueryType;
+inline constexpr query_area_field QueryArea;
+inline constexpr query_expr QueryWeight{0, 1, 0, 0, 0};
+inline constexpr query_expr QueryCorners{0, 0, 1, 0, 0};
+inline constexpr query_expr QueryWidth{0, 0, 0, 1, 0};
+inline constexpr query_expr QueryHeight{0, 0, 0, 0, 1};
+inline constexpr query_expr QueryOne{};
+
+// Aggregates in the order they were added; one group per shape type after
+// groupByType(), a single group otherwise
+struct query_result {
+    u32 groups = 0;
+    u32 aggregates = 0;
+    std::vector<f32> values;  // values[group * aggregates + aggregate]
+
+    f32 operator()(u32 aggregate, u32 group = 0) const { return values[group * aggregates + aggregate]; }
+};
+
+class ShapeQuery {
+public:
+    explicit ShapeQuery(const ShapeStore& StoreInit) : Store(&StoreInit) { }
+
+    ShapeQuery& filter(const query_filter& f) { Filter = Filter && f; return *this; }
+    ShapeQuery& sum(const query_expr& expr);
+    ShapeQuery& count() { return sum(QueryOne); }
+    ShapeQuery& groupByType() { Grouped = true; return *this; }
+
+    // false once an aggregate exceeded QueryMaxPower; run() then returns no values
+    bool valid() const { return Valid; }
+    query_result run() const;
+
+private:
+    const ShapeStore* Store;
+    query_filter Filter;
+    std::vector<query_expr> Aggregates;
+    bool Grouped = false;
+    bool Valid = true;
+};
+
+inline ShapeQuery Query(const ShapeStore& store) { return ShapeQuery(store); }
@@ -0,0 +1,58 @@
+#pragma once
+#include "shapes.h"
+
+class ShapeStore;
+
+// shape_base facade over one entry of a ShapeStore, so OOP callers can keep
+// working on shape_base* while the data stays in columns
+class shape_view : public shape_base {
+public:
+    shape_view(const ShapeStore* StoreInit, u32 IndexInit) : Store(StoreInit), Index(IndexInit) { }
+    f32 Area() override;
+    u32 CornerCount() override;
+    f32 Perimeter() override;
+    shape_bounds Bounds() override;
+
+private:
+    const ShapeStore* Store;
+    u32 Index;
+};
+
+// Contiguous dimensions of all shapes of one type. Square and circle have a
+// single parameter and leave Height empty.
+struct shape_column {
+    std::vector<f32> Width;
+    std::vector<f32> Height;
+};
+
+// Structure-of-arrays shape storage: a type tag per shape plus one column set
+// per shape type. Handles are insertion indices and stay valid. The columns
+// only change through add(); readers get const views.
+class ShapeStore {
+public:
+    ShapeStore() { }
+
+    u32 add(const shape_union& shape);
+    // Room for count shapes, split evenly over the type columns
+    void reserve(size_t count);
+    // Room for TypeCounts[t] more shapes of every type t
+    void reserve(const size_t (&TypeCounts)[Shape_Count]);
+
+    size_t size() const { return type_tags.size(); }
+    shape_union get(u32 handle) const;
+    shape_view view(u32 handle) const { return shape_view(this, handle); }
+
+    // Type tag per shape, insertion order
+    const std::vector<u8>& types() const { return type_tags; }
+    // Position of every shape in its type column
+    const std::vector<u32>& slots() const { return type_slots; }
+    const shape_column& column(u32 Type) const { return columns[Type]; }
+
+    // true for types whose Height column is stored separately
+    static bool HasHeight(shape_type Type) { return ShapeHasHeight[Type]; }
+
+private:
+    std::vector<u8> type_tags;
+    std::vector<u32> type_slots;
+    shape_column columns[Shape_Count];
+};
@@ -0,0 +1,64 @@
+#pragma once
+#include <cmath>
+#include "shape_types.h"
+
+// Corner weighting of the CornerArea metric
+constexpr f32 CornerWeight(u32 CornerCount) { return 1.0f / (1.0f + static_cast<f32>(CornerCount)); }
+
+// Compile-time description of one shape kind, generated from SHAPE_LIST
+template <shape_type Type>
+struct shape_traits;
+
+#define SHAPE_TRAITS_ENTRY(Name, AreaCoefficientInit, CornerCountInit, HasHeightInit,                        \
+                           PerimeterCoefficientInit, DiagonalCoefficientInit, BoundsCoefficientInit)         \
+    template <>                                                                                              \
+    struct shape_traits<Shape_##Name> {                                                                      \
+        static constexpr f32 AreaCoefficient = AreaCoefficientInit;                                          \
+        static constexpr u32 CornerCount = CornerCountInit;                                                  \
+        static constexpr bool HasHeight = HasHeightInit;                                                     \
+        static constexpr f32 CornerWeight = ::CornerWeight(CornerCountInit);                                 \
+        static constexpr f32 CornerAreaCoefficient = CornerWeight * AreaCoefficient;                         \
+        static constexpr f32 PerimeterCoefficient = PerimeterCoefficientInit;                                \
+        static constexpr f32 DiagonalCoefficient = DiagonalCoefficientInit;                                  \
+        static constexpr f32 BoundsCoefficient = BoundsCoefficientInit;                                      \
+        static constexpr f32 Area(f32 Width, f32 Height) { return AreaCoefficient * Width * Height; }        \
+        static f32 Perimeter(f32 Width, f32 Height) {                                                        \
+            f32 Diagonal = DiagonalCoefficient != 0.0f ? std::sqrt(Width * Width + Height * Height) : 0.0f;  \
+            return PerimeterCoefficient * (Width + Height) + DiagonalCoefficient * Diagonal;                 \
+        }                                                                                                    \
+        static constexpr shape_bounds Bounds(f32 Width, f32 Height) {                                        \
+            return {BoundsCoefficient * Width, BoundsCoefficient * Height};                                  \
+        }                                                                                                    \
+    };
+SHAPE_LIST(SHAPE_TRAITS_ENTRY)
+#undef SHAPE_TRAITS_ENTRY
+
+// Per-type tables indexed by shape_type, built from the traits
+#define SHAPE_AREA_COEFFICIENT(Name, ...) shape_traits<Shape_##Name>::AreaCoefficient,
+#define SHAPE_CORNER_AREA_COEFFICIENT(Name, ...) shape_traits<Shape_##Name>::CornerAreaCoefficient,
+#define SHAPE_CORNER_COUNT(Name, ...) shape_traits<Shape_##Name>::CornerCount,
+#define SHAPE_CORNER_WEIGHT(Name, ...) shape_traits<Shape_##Name>::CornerWeight,
+#define SHAPE_HAS_HEIGHT(Name, ...) shape_traits<Shape_##Name>::HasHeight,
+#define SHAPE_PERIMETER_COEFFICIENT(Name, ...) shape_traits<Shape_##Name>::PerimeterCoefficient,
+#define SHAPE_DIAGONAL_COEFFICIENT(Name, ...) shape_traits<Shape_##Name>::DiagonalCoefficient,
+#define SHAPE_BOUNDS_COEFFICIENT(Name, ...) shape_traits<Shape_##Name>::BoundsCoefficient,
+constexpr f32 ShapeAreaCoefficients[Shape_Count] = {SHAPE_LIST(SHAPE_AREA_COEFFICIENT)};
+constexpr f32 ShapeCornerAreaCoefficients[Shape_Count] = {SHAPE_LIST(SHAPE_CORNER_AREA_COEFFICIENT)};
+constexpr u32 ShapeCornerCounts[Shape_Count] = {SHAPE_LIST(SHAPE_CORNER_COUNT)};
+constexpr f32 ShapeCornerWeights[Shape_Count] = {SHAPE_LIST(SHAPE_CORNER_WEIGHT)};
+constexpr bool ShapeHasHeight[Shape_Count] = {SHAPE_LIST(SHAPE_HAS_HEIGHT)};
+constexpr f32 ShapePerimeterCoefficients[Shape_Count] = {SHAPE_LIST(SHAPE_PERIMETER_COEFFICIENT)};
+constexpr f32 ShapeDiagonalCoefficients[Shape_Count] = {SHAPE_LIST(SHAPE_DIAGONAL_COEFFICIENT)};
+constexpr f32 ShapeBoundsCoefficients[Shape_Count] = {SHAPE_LIST(SHAPE_BOUNDS_COEFFICIENT)};
+#undef SHAPE_AREA_COEFFICIENT
+#undef SHAPE_CORNER_AREA_COEFFICIENT
+#undef SHAPE_CORNER_COUNT
+#undef SHAPE_CORNER_WEIGHT
+#undef SHAPE_HAS_HEIGHT
+#undef SHAPE_PERIMETER_COEFFICIENT
+#undef SHAPE_DIAGONAL_COEFFICIENT
+#undef SHAPE_BOUNDS_COEFFICIENT
+
+// Traits of a shape class through its static Type member
+template <class T>
+using shape_traits_of = shape_traits<T::Type>;
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstdint>
+
+// Plain data types shared by every engine, including the per-ISA kernel
+// translation units, which must not pull in any inline code of their own.
+using f32 = float;
+using u8 = uint8_t;
+using u16 = uint16_t;
+using u32 = uint32_t;
+using u64 = uint64_t;
+constexpr f32 Pi32 = 3.14159265359f;
+
+// Every shape kind of the flat engines, in shape_type order:
+// X(Name, AreaCoefficient, CornerCount, HasHeight, PerimeterCoefficient,
+//   DiagonalCoefficient, BoundsCoefficient). Area is always
+// AreaCoefficient * Width * Height; single-parameter kinds (HasHeight false)
+// store their parameter in Width and repeat it in Height. The perimeter is
+// PerimeterCoefficient * (Width + Height) + DiagonalCoefficient *
+// sqrt(Width^2 + Height^2), with triangles taken as right triangles over
+// their base and height, and the axis-aligned bounds are BoundsCoefficient *
+// Width by BoundsCoefficient * Height. shape_traits.h derives the
+// coefficient tables, the switch cases and the corner weights from this
+// list, so a new kind is one more line here.
+#define SHAPE_LIST(X)                                 \
+    X(Square,    1.0f,  4, false, 2.0f, 0.0f, 1.0f)   \
+    X(Rectangle, 1.0f,  4, true,  2.0f, 0.0f, 1.0f)   \
+    X(Triangle,  0.5f,  3, true,  1.0f, 1.0f, 1.0f)   \
+    X(Circle,    Pi32,  0, false, Pi32, 0.0f, 2.0f)
+
+// Enum for switch/table versions
+#define SHAPE_ENUM_ENTRY(Name, ...) Shape_##Name,
+enum shape_type : u32 {
+    SHAPE_LIST(SHAPE_ENUM_ENTRY)
+    Shape_Count
+};
+#undef SHAPE_ENUM_ENTRY
+
+// Flat struct for switch/table versions
+struct shape_union {
+    shape_type Type;
+    f32 Width;
+    f32 Height;
+};
+
+// Axis-aligned extent of one shape in its own frame, anchored at the origin
+struct shape_bounds {
+    f32 Width;
+    f32 Height;
+};
+
+// Metrics of the multi-metric passes, in this order: a pass over the first N
+// computes N of them
+constexpr u32 ShapeMetricCount = 3;
+
+struct shape_totals {
+    f32 Area = 0.0f;
+    f32 CornerArea = 0.0f;
+    f32 Perimeter = 0.0f;
+};
+
+// Per-column sums behind every metric of a single-type column: sum of
+// Width*Height, of Width+Height and of sqrt(Width^2+Height^2)
+struct shape_moments {
+    f32 Product;
+    f32 Sum;
+    f32 Diagonal;
+};
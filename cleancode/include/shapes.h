@@ -1,27 +1,15 @@
 #pragma once
+#include <algorithm>
 #include <cstdint>
 #include <cmath>
 #include <vector>
+#include "aligned_allocator.h"
+#include "instrumentation.h"
+#include "shape_types.h"
+#include "shape_traits.h"
 
-using f32 = float;
-using u32 = uint32_t;
-constexpr f32 Pi32 = 3.14159265359f;
-
-// Enum for switch/table versions
-enum shape_type : u32 {
-    Shape_Square,
-    Shape_Rectangle,
-    Shape_Triangle,
-    Shape_Circle,
-    Shape_Count
-};
-
-// Flat struct for switch/table versions
-struct shape_union {
-    shape_type Type;
-    f32 Width;
-    f32 Height;
-};
+class ShapeStore;
+class ThreadPool;
 
 // Base class for OOP version
 class shape_base {
@@ -30,13 +18,84 @@ public:
     virtual ~shape_base() {}
     virtual f32 Area() { return 0.0f; };
     virtual u32 CornerCount() { return 0; };
+    virtual f32 Perimeter() { return 0.0f; };
+    // Axis-aligned extent in the shape's own frame
+    virtual shape_bounds Bounds() { return {0.0f, 0.0f}; };
+
+    // Batch hooks: sum over ShapeCount shapes that all share the dynamic type
+    // of *this. Subclasses override them with a devirtualized loop; the
+    // defaults stay correct for any subclass by calling through the vtable.
+    virtual f32 AreaBatch(u32 ShapeCount, shape_base** Shapes) {
+        f32 Accum = 0.0f;
+        for (u32 i = 0; i < ShapeCount; ++i) {
+            Accum += Shapes[i]->Area();
+        }
+        return Accum;
+    }
+    virtual f32 CornerAreaBatch(u32 ShapeCount, shape_base** Shapes) {
+        f32 Accum = 0.0f;
+        for (u32 i = 0; i < ShapeCount; ++i) {
+            Accum += (1.0f / (1.0f + (f32)Shapes[i]->CornerCount())) * Shapes[i]->Area();
+        }
+        return Accum;
+    }
+    // Bulk ingest hook: writes the area, and the corner count unless
+    // CornerCounts is null, of every shape
+    virtual void CollectBatch(u32 ShapeCount, shape_base** Shapes, f32* Areas, u8* CornerCounts) {
+        for (u32 i = 0; i < ShapeCount; ++i) {
+            Areas[i] = Shapes[i]->Area();
+            if (CornerCounts) {
+                CornerCounts[i] = static_cast<u8>(Shapes[i]->CornerCount());
+            }
+        }
+    }
 };
 
+// Devirtualized batch loops shared by the subclass overrides; T::Area() is a
+// qualified call and inlines
+template <class T>
+f32 AreaBatchOf(u32 ShapeCount, shape_base** Shapes) {
+    f32 Accum = 0.0f;
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        Accum += static_cast<T*>(Shapes[i])->T::Area();
+    }
+    return Accum;
+}
+
+template <class T>
+f32 CornerAreaBatchOf(u32 ShapeCount, shape_base** Shapes) {
+    f32 Accum = 0.0f;
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        T* Shape = static_cast<T*>(Shapes[i]);
+        Accum += (1.0f / (1.0f + (f32)Shape->T::CornerCount())) * Shape->T::Area();
+    }
+    return Accum;
+}
+
+// The corner count of a run is one constant
+template <class T>
+void CollectBatchOf(u32 ShapeCount, shape_base** Shapes, f32* Areas, u8* CornerCounts) {
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        Areas[i] = static_cast<T*>(Shapes[i])->T::Area();
+    }
+    if (CornerCounts) {
+        std::fill(CornerCounts, CornerCounts + ShapeCount, static_cast<u8>(shape_traits<T::Type>::CornerCount));
+    }
+}
+
 class square : public shape_base {
 public:
+    static constexpr shape_type Type = Shape_Square;
     square(f32 SideInit) : Side(SideInit) {  }
-    f32 Area() override { return Side * Side; }
-    u32 CornerCount() override { return 4; }
+    f32 Area() override { return shape_traits<Type>::Area(Side, Side); }
+    u32 CornerCount() override { return shape_traits<Type>::CornerCount; }
+    f32 Perimeter() override { return shape_traits<Type>::Perimeter(Side, Side); }
+    shape_bounds Bounds() override { return shape_traits<Type>::Bounds(Side, Side); }
+    f32 AreaBatch(u32 ShapeCount, shape_base** Shapes) override { return AreaBatchOf<square>(ShapeCount, Shapes); }
+    f32 CornerAreaBatch(u32 ShapeCount, shape_base** Shapes) override { return CornerAreaBatchOf<square>(ShapeCount, Shapes); }
+    void CollectBatch(u32 ShapeCount, shape_base** Shapes, f32* Areas, u8* CornerCounts) override {
+        CollectBatchOf<square>(ShapeCount, Shapes, Areas, CornerCounts);
+    }
     
 private:
     f32 Side;
@@ -44,58 +103,178 @@ private:
 
 class rectangle : public shape_base {
 public:
+    static constexpr shape_type Type = Shape_Rectangle;
     rectangle(f32 WidthInit, f32 HeightInit) : Width(WidthInit), Height(HeightInit) {  }
-    f32 Area() override { return Width * Height; }
-    u32 CornerCount() override { return 4; }
+    f32 Area() override { return shape_traits<Type>::Area(Width, Height); }
+    u32 CornerCount() override { return shape_traits<Type>::CornerCount; }
+    f32 Perimeter() override { return shape_traits<Type>::Perimeter(Width, Height); }
+    shape_bounds Bounds() override { return shape_traits<Type>::Bounds(Width, Height); }
+    f32 AreaBatch(u32 ShapeCount, shape_base** Shapes) override { return AreaBatchOf<rectangle>(ShapeCount, Shapes); }
+    f32 CornerAreaBatch(u32 ShapeCount, shape_base** Shapes) override { return CornerAreaBatchOf<rectangle>(ShapeCount, Shapes); }
+    void CollectBatch(u32 ShapeCount, shape_base** Shapes, f32* Areas, u8* CornerCounts) override {
+        CollectBatchOf<rectangle>(ShapeCount, Shapes, Areas, CornerCounts);
+    }
 private:
     f32 Width, Height;
 };
 
 class triangle : public shape_base {
 public:
+    static constexpr shape_type Type = Shape_Triangle;
     triangle(f32 BaseInit, f32 HeightInit) : Base(BaseInit), Height(HeightInit) {  }
-    f32 Area() override { return 0.5f * Base * Height; }
-    u32 CornerCount() override { return 3; }
+    f32 Area() override { return shape_traits<Type>::Area(Base, Height); }
+    u32 CornerCount() override { return shape_traits<Type>::CornerCount; }
+    f32 Perimeter() override { return shape_traits<Type>::Perimeter(Base, Height); }
+    shape_bounds Bounds() override { return shape_traits<Type>::Bounds(Base, Height); }
+    f32 AreaBatch(u32 ShapeCount, shape_base** Shapes) override { return AreaBatchOf<triangle>(ShapeCount, Shapes); }
+    f32 CornerAreaBatch(u32 ShapeCount, shape_base** Shapes) override { return CornerAreaBatchOf<triangle>(ShapeCount, Shapes); }
+    void CollectBatch(u32 ShapeCount, shape_base** Shapes, f32* Areas, u8* CornerCounts) override {
+        CollectBatchOf<triangle>(ShapeCount, Shapes, Areas, CornerCounts);
+    }
 private:
     f32 Base, Height;
 };
 
 class circle : public shape_base {
 public:
+    static constexpr shape_type Type = Shape_Circle;
     circle(f32 RadiusInit) : Radius(RadiusInit) {  }
-    f32 Area() override { return Pi32 * Radius * Radius; }
-    u32 CornerCount() override { return 0; }
+    f32 Area() override { return shape_traits<Type>::Area(Radius, Radius); }
+    u32 CornerCount() override { return shape_traits<Type>::CornerCount; }
+    f32 Perimeter() override { return shape_traits<Type>::Perimeter(Radius, Radius); }
+    shape_bounds Bounds() override { return shape_traits<Type>::Bounds(Radius, Radius); }
+    f32 AreaBatch(u32 ShapeCount, shape_base** Shapes) override { return AreaBatchOf<circle>(ShapeCount, Shapes); }
+    f32 CornerAreaBatch(u32 ShapeCount, shape_base** Shapes) override { return CornerAreaBatchOf<circle>(ShapeCount, Shapes); }
+    void CollectBatch(u32 ShapeCount, shape_base** Shapes, f32* Areas, u8* CornerCounts) override {
+        CollectBatchOf<circle>(ShapeCount, Shapes, Areas, CornerCounts);
+    }
 private:
     f32 Radius;
 };
 
+// Slot size of the fixed-stride inline shape buffer traversed by the
+// OptVTBL kernels; every shape class fits into one slot
+constexpr size_t InlineShapeStride = std::max({sizeof(shape_base), sizeof(square), sizeof(rectangle),
+                                               sizeof(triangle), sizeof(circle), sizeof(shape_union)});
+
+// CRTP counterpart of shape_base, see static_shapes.h
+template <class Derived>
+class shape;
+
+// Area collector, and the area backbone of CornerCollector. The columns are
+// only appended to by the collector that owns them; readers get const views.
+// A perimeter column can be attached on demand: attachPerimeters() fills it
+// for the shapes collected so far, and later ingest keeps it in step.
 class AreaCollector {
 public:
     AreaCollector() { }
     shape_base* addShape(shape_base* shape) {
-        areas.push_back(shape->Area());
+        INSTRUMENT_SCOPE("AreaCollector::addShape", 1, sizeof(shape_base*));
+        addArea(shape);
         return shape;
     }
+    // Statically dispatched ingest, no virtual call
+    template <class Derived>
+    void addShape(const shape<Derived>& shape) {
+        area_column.push_back(shape.Area());
+        if (perimeters_attached) {
+            perimeter_column.push_back(shape.Perimeter());
+        }
+    }
+
+    // Bulk ingest, appended in input order with one allocation. Runs of
+    // shapes of one dynamic type take one virtual call through
+    // shape_base::CollectBatch; a store needs no dispatch at all. The pool
+    // overloads fill disjoint ranges in parallel.
+    void addShapes(u32 ShapeCount, shape_base** Shapes);
+    void addShapes(u32 ShapeCount, shape_base** Shapes, ThreadPool& pool);
+    void addShapes(const ShapeStore& store);
+    void addShapes(const ShapeStore& store, ThreadPool& pool);
+
+    const aligned_vector<f32>& areas() const { return area_column; }
+    size_t size() const { return area_column.size(); }
+
+    // Shapes must be the size() shapes collected so far, in order; false
+    // and no column otherwise
+    bool attachPerimeters(u32 ShapeCount, shape_base** Shapes);
+    bool attachPerimeters(const ShapeStore& store);
+    bool hasPerimeters() const { return perimeters_attached; }
+    const aligned_vector<f32>& perimeters() const { return perimeter_column; }
+    void dropPerimeters() {
+        aligned_vector<f32>().swap(perimeter_column);
+        perimeters_attached = false;
+    }
+
+protected:
+    void addArea(shape_base* shape) {
+        area_column.push_back(shape->Area());
+        if (perimeters_attached) {
+            perimeter_column.push_back(shape->Perimeter());
+        }
+    }
+    // Fills the perimeters of the last count rows after a bulk ingest
+    void extendPerimeters(size_t count, shape_base** Shapes, ThreadPool* pool);
+    void extendPerimeters(const ShapeStore& store, ThreadPool* pool);
 
-    std::vector<f32> areas;
+    aligned_vector<f32> area_column;
+    aligned_vector<f32> perimeter_column;
+    bool perimeters_attached = false;
 };
 
-// Collector that precomputes weights
-class CornerCollector {
+// Type-run ingest behind addShapes, writing into caller-owned columns;
+// CornerCounts may be null
+void CollectShapes(u32 ShapeCount, shape_base** Shapes, f32* Areas, u8* CornerCounts);
+
+// Corner-weighted collector on the area backbone: one instance feeds both
+// the area and the corner reductions, and the area column exists once. The
+// backbone is a protected base, so the area column cannot be grown behind
+// the corner columns through an AreaCollector reference. Ingest stores one
+// corner count byte and one f32 weight per shape, so every read is const.
+class CornerCollector : protected AreaCollector {
 public:
     CornerCollector() { }
     shape_base* addShape(shape_base* shape) {
-        f32 area = shape->Area();
-        u32 corner_count = shape->CornerCount();
-        f32 weight = 1.0f / (1.0f + static_cast<f32>(corner_count));
-        
-        // Store area and precomputed weight
-        areas.push_back(area);
-        weights.push_back(weight);
-        
+        INSTRUMENT_SCOPE("CornerCollector::addShape", 1, sizeof(shape_base*));
+        addArea(shape);
+        addCornerCount(shape->CornerCount());
         return shape;
     }
+    template <class Derived>
+    void addShape(const shape<Derived>& shape) {
+        AreaCollector::addShape(shape);
+        addCornerCount(shape.CornerCount());
+    }
+
+    void addShapes(u32 ShapeCount, shape_base** Shapes);
+    void addShapes(u32 ShapeCount, shape_base** Shapes, ThreadPool& pool);
+    void addShapes(const ShapeStore& store);
+    void addShapes(const ShapeStore& store, ThreadPool& pool);
+
+    using AreaCollector::areas;
+    using AreaCollector::size;
+    using AreaCollector::attachPerimeters;
+    using AreaCollector::hasPerimeters;
+    using AreaCollector::perimeters;
+    using AreaCollector::dropPerimeters;
+
+    const std::vector<u8>& cornerCounts() const { return corner_counts; }
+    const aligned_vector<f32>& weights() const { return weight_column; }
+
+protected:
+    // Brings the weight column up to the corner counts after a bulk ingest
+    void extendWeights() {
+        size_t begin = weight_column.size();
+        weight_column.resize(corner_counts.size());
+        for (size_t i = begin; i < corner_counts.size(); ++i) {
+            weight_column[i] = CornerWeight(corner_counts[i]);
+        }
+    }
+
+    void addCornerCount(u32 corner_count) {
+        corner_counts.push_back(static_cast<u8>(corner_count));
+        weight_column.push_back(CornerWeight(corner_count));
+    }
 
-    std::vector<f32> areas;
-    std::vector<f32> weights;
+    std::vector<u8> corner_counts;
+    aligned_vector<f32> weight_column;
 };
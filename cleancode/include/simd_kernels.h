@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "shape_types.h"
+
+// One set of vectorized reduction kernels, built for a single instruction set.
+// Every kernel accepts any length and unaligned pointers.
+struct simd_kernels {
+    const char* name;
+    // sum of values[0..size)
+    f32 (*sum)(const f32* values, size_t size);
+    // sum of a[i] * b[i] over [0..size)
+    f32 (*dot)(const f32* a, const f32* b, size_t size);
+    // sum of coefficients[Type] * Width * Height over a shape_union array;
+    // coefficients holds Shape_Count entries
+    f32 (*union_sum)(const shape_union* shapes, size_t size, const f32* coefficients);
+
+    // sum/dot for the Accum_F64 and Accum_Neumaier policies. A per-ISA table
+    // may leave them null; the dispatched tables fill in portable versions.
+    f32 (*sum_f64)(const f32* values, size_t size);
+    f32 (*dot_f64)(const f32* a, const f32* b, size_t size);
+    f32 (*sum_neumaier)(const f32* values, size_t size);
+    f32 (*dot_neumaier)(const f32* a, const f32* b, size_t size);
+
+    // Compact columns (compact_columns.h): sums of f16 / bf16 values, and dot
+    // products of f32 / f16 / bf16 areas with weights looked up through u8
+    // indices in a CompactWeightLutSize-entry table. A per-ISA table may
+    // leave them null; the dispatched tables take them from the next lower
+    // variant, or from portable versions.
+    f32 (*sum_f16)(const u16* values, size_t size);
+    f32 (*sum_bf16)(const u16* values, size_t size);
+    f32 (*dot_lut)(const f32* areas, const u8* index, const f32* lut, size_t size);
+    f32 (*dot_f16_lut)(const u16* areas, const u8* index, const f32* lut, size_t size);
+    f32 (*dot_bf16_lut)(const u16* areas, const u8* index, const f32* lut, size_t size);
+
+    // sum/dot for columns starting on a CacheLineSize boundary, such as the
+    // collector columns and mapped shape files; aligned loads only. A null
+    // entry falls back to the unaligned kernel of the same table.
+    f32 (*sum_aligned)(const f32* values, size_t size);
+    f32 (*dot_aligned)(const f32* a, const f32* b, size_t size);
+
+    // Multi-metric pass over one Width/Height column pair (shape_moments);
+    // height may be width for single-parameter types. A per-ISA table may
+    // leave it null; the dispatched tables take it from the next lower
+    // variant, or from a portable version.
+    shape_moments (*column_moments)(const f32* width, const f32* height, size_t size);
+};
+
+// Entries of the weight table of the *_lut kernels; one 256-bit register
+constexpr u32 CompactWeightLutSize = 8;
+
+// The kernels deinterleave shape_union as three packed 32-bit fields
+static_assert(sizeof(shape_union) == 3 * sizeof(f32), "shape_union must stay 12 bytes");
+static_assert(Shape_Count <= 4, "union_sum kernels hold the coefficient table in one 128-bit lane");
+
+// Software prefetch distance of the sum/dot kernels, in elements ahead of
+// the current block; 0 disables the prefetches. The AVX-512 kernels, whose
+// blocks are twice as wide, prefetch at twice the distance. Read once per
+// kernel call, so it can be tuned at run time.
+constexpr size_t DefaultPrefetchDistance = 128;
+size_t PrefetchDistance();
+void SetPrefetchDistance(size_t elements);
+
+// Per-ISA tables. Each returns nullptr when the variant is not built for this
+// architecture; it does not check whether the running CPU supports it.
+const simd_kernels* SimdKernelsSSE2();
+const simd_kernels* SimdKernelsAVX2();
+const simd_kernels* SimdKernelsAVX512();
+const simd_kernels* SimdKernelsNEON();
+
+// Best variant for the running CPU, detected once on first use. Every entry
+// of the returned tables is set.
+const simd_kernels& SimdKernels();
+
+// Every variant the running CPU can execute, from the most basic to the best
+std::vector<const simd_kernels*> AvailableSimdKernels();
@@ -0,0 +1,101 @@
+#pragma once
+#include <tuple>
+#include <variant>
+#include <vector>
+#include "shapes.h"
+
+// Closed set of the shape classes held by value. std::visit dispatches on the
+// index, and the visitors make qualified calls, so the vtable pointer every
+// alternative still carries is never read.
+using shape_variant = std::variant<square, rectangle, triangle, circle>;
+
+shape_variant MakeShapeVariant(const shape_union& Shape);
+
+// Static-polymorphism base: the interface of shape_base, resolved at compile
+// time. Derived provides AreaImpl(), PerimeterImpl() and a static Type for
+// its traits.
+template <class Derived>
+class shape {
+public:
+    f32 Area() const { return static_cast<const Derived&>(*this).AreaImpl(); }
+    f32 Perimeter() const { return static_cast<const Derived&>(*this).PerimeterImpl(); }
+    u32 CornerCount() const { return shape_traits_of<Derived>::CornerCount; }
+    f32 CornerWeight() const { return shape_traits_of<Derived>::CornerWeight; }
+};
+
+class static_square : public shape<static_square> {
+public:
+    static constexpr shape_type Type = Shape_Square;
+    static_square(f32 SideInit) : Side(SideInit) { }
+    f32 AreaImpl() const { return shape_traits<Type>::Area(Side, Side); }
+    f32 PerimeterImpl() const { return shape_traits<Type>::Perimeter(Side, Side); }
+private:
+    f32 Side;
+};
+
+class static_rectangle : public shape<static_rectangle> {
+public:
+    static constexpr shape_type Type = Shape_Rectangle;
+    static_rectangle(f32 WidthInit, f32 HeightInit) : Width(WidthInit), Height(HeightInit) { }
+    f32 AreaImpl() const { return shape_traits<Type>::Area(Width, Height); }
+    f32 PerimeterImpl() const { return shape_traits<Type>::Perimeter(Width, Height); }
+private:
+    f32 Width, Height;
+};
+
+class static_triangle : public shape<static_triangle> {
+public:
+    static constexpr shape_type Type = Shape_Triangle;
+    static_triangle(f32 BaseInit, f32 HeightInit) : Base(BaseInit), Height(HeightInit) { }
+    f32 AreaImpl() const { return shape_traits<Type>::Area(Base, Height); }
+    f32 PerimeterImpl() const { return shape_traits<Type>::Perimeter(Base, Height); }
+private:
+    f32 Base, Height;
+};
+
+class static_circle : public shape<static_circle> {
+public:
+    static constexpr shape_type Type = Shape_Circle;
+    static_circle(f32 RadiusInit) : Radius(RadiusInit) { }
+    f32 AreaImpl() const { return shape_traits<Type>::Area(Radius, Radius); }
+    f32 PerimeterImpl() const { return shape_traits<Type>::Perimeter(Radius, Radius); }
+private:
+    f32 Radius;
+};
+
+// One contiguous vector per static shape class. Every loop is over a single
+// concrete type, so it inlines and vectorizes like hand-written code.
+template <class... Shapes>
+class StaticShapeSet {
+public:
+    StaticShapeSet() { }
+
+    template <class T>
+    void add(const T& Shape) { std::get<std::vector<T>>(columns).push_back(Shape); }
+
+    template <class T>
+    const std::vector<T>& of() const { return std::get<std::vector<T>>(columns); }
+
+    size_t size() const { return (of<Shapes>().size() + ... + 0); }
+
+    f32 TotalArea() const { return (SumOf<Shapes>([](const Shapes& s) { return s.Area(); }) + ... + 0.0f); }
+    f32 CornerArea() const {
+        return (SumOf<Shapes>([](const Shapes& s) { return s.CornerWeight() * s.Area(); }) + ... + 0.0f);
+    }
+
+private:
+    template <class T, class Term>
+    f32 SumOf(Term term) const {
+        f32 Accum = 0.0f;
+        for (const T& s : of<T>()) {
+            Accum += term(s);
+        }
+        return Accum;
+    }
+
+    std::tuple<std::vector<Shapes>...> columns;
+};
+
+using StaticShapes = StaticShapeSet<static_square, static_rectangle, static_triangle, static_circle>;
+
+void AddStaticShape(StaticShapes& Set, const shape_union& Shape);
@@ -0,0 +1,34 @@
+#pragma once
+#include <functional>
+#include "shapes.h"
+
+class MappedCollector;
+
+// Streaming reductions for inputs larger than memory. A producer fills
+// fixed-size chunks on a reader thread while the SIMD kernels reduce the
+// previous chunk, so at most two chunks are resident at any time.
+//
+//     ShapeFileReader reader;
+//     reader.open("shapes.col");
+//     f32 total = TotalAreaStream([&](f32* areas, f32* weights, size_t capacity) {
+//         return reader.read(areas, weights, capacity);
+//     });
+
+// Rows per chunk: 4 MB of areas, large enough to amortize a read call and
+// the hand-off between the threads
+constexpr size_t StreamChunkSize = 1 << 20;
+
+// Fills up to capacity rows and returns the count; 0 ends the stream.
+// weights is null when the reduction needs areas only.
+using shape_chunk_source = std::function<size_t(f32* areas, f32* weights, size_t capacity)>;
+
+// Chunk partials are added in stream order in double, so a result only
+// depends on the data and the chunk size
+f32 TotalAreaStream(const shape_chunk_source& source, size_t chunk_size = StreamChunkSize);
+f32 CornerAreaStream(const shape_chunk_source& source, size_t chunk_size = StreamChunkSize);
+
+// Chunked scan of a mapped file: the kernel reads the next chunk ahead
+// (MADV_WILLNEED) while the current one is reduced, and every consumed chunk
+// is released (MADV_DONTNEED), bounding the resident set the same way
+f32 TotalAreaStream(const MappedCollector& collector, size_t chunk_size = StreamChunkSize);
+f32 CornerAreaStream(const MappedCollector& collector, size_t chunk_size = StreamChunkSize);
@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent worker pool used by the parallel reductions.
+// A pool of size N runs N-1 worker threads; the thread calling parallelFor
+// participates as the N-th lane, so ThreadPool(1) is purely serial.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threadCount = std::thread::hardware_concurrency());
+    // Workers restricted to the given CPUs, e.g. those of one NUMA node; the
+    // calling thread keeps its own affinity
+    ThreadPool(unsigned threadCount, const std::vector<int>& cpus);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Queue a task for any worker; runs inline when the pool has no workers
+    void submit(std::function<void()> task);
+
+    // Run fn(i) for every i in [0, count) and return once all calls finished.
+    // Indices are claimed dynamically, so callers must not depend on which
+    // lane runs which index.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+private:
+    void start(unsigned threadCount, const std::vector<int>& cpus);
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
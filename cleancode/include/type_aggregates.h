@@ -0,0 +1,56 @@
+#pragma once
+#include "shapes.h"
+
+// Running per-type sums of Width * Height over shape_union records. Every
+// metric of the table engine is a per-type coefficient times Width * Height,
+// so with these sums it becomes a Shape_Count-entry dot product with its
+// coefficient table, independent of the number of shapes. The sums are kept
+// in double, like the live collector totals, so add/remove deltas do not
+// drift; rebuild() recomputes them from the records.
+class TypeAggregates {
+public:
+    TypeAggregates() { }
+
+    void add(const shape_union& shape) {
+        Sums[shape.Type] += double(shape.Width) * double(shape.Height);
+        ++Counts[shape.Type];
+    }
+    void remove(const shape_union& shape) {
+        Sums[shape.Type] -= double(shape.Width) * double(shape.Height);
+        --Counts[shape.Type];
+    }
+    // The record changed from old_shape to new_shape, possibly its type too
+    void update(const shape_union& old_shape, const shape_union& new_shape) {
+        remove(old_shape);
+        add(new_shape);
+    }
+
+    void addShapes(u32 ShapeCount, const shape_union* Shapes) {
+        for (u32 i = 0; i < ShapeCount; ++i) {
+            add(Shapes[i]);
+        }
+    }
+    void clear() { *this = TypeAggregates(); }
+    void rebuild(u32 ShapeCount, const shape_union* Shapes) {
+        clear();
+        addShapes(ShapeCount, Shapes);
+    }
+
+    // sum over all shapes of Coefficients[Type] * Width * Height
+    f32 metric(const f32* Coefficients) const {
+        double Accum = 0.0;
+        for (u32 t = 0; t < Shape_Count; ++t) {
+            Accum += Coefficients[t] * Sums[t];
+        }
+        return static_cast<f32>(Accum);
+    }
+    f32 totalArea() const { return metric(ShapeAreaCoefficients); }
+    f32 cornerArea() const { return metric(ShapeCornerAreaCoefficients); }
+
+    double productSum(shape_type Type) const { return Sums[Type]; }
+    u64 count(shape_type Type) const { return Counts[Type]; }
+
+private:
+    double Sums[Shape_Count] = {};
+    u64 Counts[Shape_Count] = {};
+};
@@ -0,0 +1,158 @@
+#include "adaptive_shapes.h"
+#include <chrono>
+#include "simd_kernels.h"
+
+// Declarations from other files
+f32 TotalAreaVTBL4(u32 ShapeCount, shape_base **Shapes);
+f32 CornerAreaVTBL4(u32 ShapeCount, shape_base **Shapes);
+f32 TotalAreaSwitch4(u32 ShapeCount, shape_union* Shapes);
+f32 CornerAreaSwitch4(u32 ShapeCount, shape_union* Shapes);
+f32 TotalAreaUnionSIMD(u32 ShapeCount, shape_union* Shapes);
+f32 CornerAreaUnionSIMD(u32 ShapeCount, shape_union* Shapes);
+
+// Best of this many timings per engine and phase
+constexpr u32 AdaptiveCalibrationRounds = 3;
+
+// Weight of the latest run in the queries-per-mutation average
+constexpr double AdaptiveRunWeight = 0.25;
+
+static const char* const AdaptiveEngineNames[Adaptive_EngineCount] = {"vtbl", "switch", "table", "collector"};
+
+const char* AdaptiveEngineName(adaptive_engine engine) { return AdaptiveEngineNames[engine]; }
+
+AdaptiveShapes::AdaptiveShapes() : Profile(DefaultAdaptiveProfile()) { }
+
+u32 AdaptiveShapes::add(const shape_union& shape) {
+    records.push_back(shape);
+    mutated();
+    return static_cast<u32>(records.size() - 1);
+}
+
+void AdaptiveShapes::set(u32 index, const shape_union& shape) {
+    records[index] = shape;
+    mutated();
+}
+
+// The record engines read the data itself and never go stale
+void AdaptiveShapes::mutated() {
+    Built[Adaptive_VTBL] = false;
+    Built[Adaptive_Collector] = false;
+    Mutated = true;
+}
+
+f32 AdaptiveShapes::query(bool Corner) {
+    // Mutations with no query in between end a single run
+    if (Mutated && RunQueries > 0) {
+        QueriesPerMutation += AdaptiveRunWeight * (double(RunQueries) - QueriesPerMutation);
+        RunQueries = 0;
+    }
+    Mutated = false;
+    ++RunQueries;
+    Last = Forced != Adaptive_EngineCount ? Forced : choose(Corner);
+    if (!Built[Last]) {
+        build(Last);
+    }
+    return run(Last, Corner);
+}
+
+// A run that already lasted longer than the average is expected to go on at
+// least as long again
+adaptive_engine AdaptiveShapes::choose(bool Corner) const {
+    const double queries = std::max(QueriesPerMutation, double(RunQueries));
+    const double* cost = Corner ? Profile.Corner : Profile.Total;
+    adaptive_engine best = Adaptive_Table;
+    double best_cost = 0.0;
+    for (u32 e = 0; e < Adaptive_EngineCount; ++e) {
+        double expected = cost[e] + (Built[e] ? 0.0 : Profile.Build[e] / queries);
+        if (e == 0 || expected < best_cost) {
+            best = static_cast<adaptive_engine>(e);
+            best_cost = expected;
+        }
+    }
+    return best;
+}
+
+void AdaptiveShapes::build(adaptive_engine engine) {
+    if (engine == Adaptive_VTBL) {
+        arena.reset();
+        objects.resize(records.size());
+        for (size_t i = 0; i < records.size(); ++i) {
+            const shape_union& shape = records[i];
+            switch (shape.Type) {
+                case Shape_Square: objects[i] = arena.make<square>(shape.Width); break;
+                case Shape_Rectangle: objects[i] = arena.make<rectangle>(shape.Width, shape.Height); break;
+                case Shape_Triangle: objects[i] = arena.make<triangle>(shape.Width, shape.Height); break;
+                default: objects[i] = arena.make<circle>(shape.Width); break;
+            }
+        }
+    } else if (engine == Adaptive_Collector) {
+        areas.resize(records.size());
+        weights.resize(records.size());
+        for (size_t i = 0; i < records.size(); ++i) {
+            const shape_union& shape = records[i];
+            areas[i] = ShapeAreaCoefficients[shape.Type] * shape.Width * shape.Height;
+            weights[i] = ShapeCornerWeights[shape.Type];
+        }
+    }
+    Built[engine] = true;
+}
+
+f32 AdaptiveShapes::run(adaptive_engine engine, bool Corner) {
+    const u32 count = static_cast<u32>(records.size());
+    switch (engine) {
+        case Adaptive_VTBL:
+            return Corner ? CornerAreaVTBL4(count, objects.data()) : TotalAreaVTBL4(count, objects.data());
+        case Adaptive_Switch:
+            return Corner ? CornerAreaSwitch4(count, records.data()) : TotalAreaSwitch4(count, records.data());
+        case Adaptive_Table:
+            return Corner ? CornerAreaUnionSIMD(count, records.data()) : TotalAreaUnionSIMD(count, records.data());
+        default:
+            return Corner ? SimdKernels().dot_aligned(areas.data(), weights.data(), count)
+                          : SimdKernels().sum_aligned(areas.data(), count);
+    }
+}
+
+adaptive_profile AdaptiveShapes::calibrate(u32 SampleCount) {
+    AdaptiveShapes sample{adaptive_profile()};
+    sample.records.reserve(SampleCount);
+    for (u32 i = 0; i < SampleCount; ++i) {
+        shape_type Type = static_cast<shape_type>(i % Shape_Count);
+        f32 Width = 1.0f + f32(i % 7), Height = ShapeHasHeight[Type] ? 1.0f + f32(i % 5) : Width;
+        sample.records.push_back({Type, Width, Height});
+    }
+
+    using clock = std::chrono::steady_clock;
+    auto ns_per_shape = [&](clock::time_point begin, clock::time_point end) {
+        return std::chrono::duration<double, std::nano>(end - begin).count() / std::max(1u, SampleCount);
+    };
+    adaptive_profile profile;
+    volatile f32 sink = 0.0f;
+    for (u32 e = 0; e < Adaptive_EngineCount; ++e) {
+        adaptive_engine engine = static_cast<adaptive_engine>(e);
+        double build = 0.0, total = 0.0, corner = 0.0;
+        for (u32 round = 0; round < AdaptiveCalibrationRounds; ++round) {
+            auto start = clock::now();
+            if (engine == Adaptive_VTBL || engine == Adaptive_Collector) {
+                sample.build(engine);
+            }
+            auto built = clock::now();
+            sink = sink + sample.run(engine, false);
+            auto totalled = clock::now();
+            sink = sink + sample.run(engine, true);
+            auto cornered = clock::now();
+            double b = ns_per_shape(start, built), t = ns_per_shape(built, totalled), c = ns_per_shape(totalled, cornered);
+            build = round == 0 ? b : std::min(build, b);
+            total = round == 0 ? t : std::min(total, t);
+            corner = round == 0 ? c : std::min(corner, c);
+        }
+        profile.Build[e] = build;
+        profile.Total[e] = total;
+        profile.Corner[e] = corner;
+    }
+    return profile;
+}
+
+const adaptive_profile& DefaultAdaptiveProfile() {
+    static const adaptive_profile profile = AdaptiveShapes::calibrate();
+    return profile;
+}
@@ -0,0 +1,120 @@
+#include "async_reduce.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include <vector>
+#include "simd_kernels.h"
+#include "thread_pool.h"
+
+namespace {
+
+// Shared by the lanes of one reduction; the last lane to leave sets the result
+struct async_job {
+    const f32* areas;
+    const f32* weights;  // null for the total area
+    size_t size;
+    size_t chunk_size;
+    size_t chunks;
+    cancel_token token;
+    ThreadPool* pool;
+    std::vector<f32> partials;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> reduced{0};
+    std::atomic<size_t> lanes{0};
+    std::promise<async_result> promise;
+
+    // Claims and reduces one chunk; false once the chunks ran out or the
+    // reduction was cancelled
+    bool step() {
+        if (token.cancelled()) {
+            return false;
+        }
+        size_t chunk = next.fetch_add(1);
+        if (chunk >= chunks) {
+            return false;
+        }
+        const simd_kernels& kernels = SimdKernels();
+        size_t begin = chunk * chunk_size;
+        size_t count = std::min(chunk_size, size - begin);
+        if (weights) {
+            INSTRUMENT_SCOPE("CornerAreaAsync/chunk", count, count * 2 * sizeof(f32));
+            partials[chunk] = kernels.dot_aligned(areas + begin, weights + begin, count);
+        } else {
+            INSTRUMENT_SCOPE("TotalAreaAsync/chunk", count, count * sizeof(f32));
+            partials[chunk] = kernels.sum_aligned(areas + begin, count);
+        }
+        reduced.fetch_add(1);
+        return true;
+    }
+
+    void finish() {
+        async_result result;
+        if (reduced.load() < chunks) {
+            result.Cancelled = true;
+        } else {
+            double total = 0.0;
+            for (f32 partial : partials) {
+                total += partial;
+            }
+            result.Value = static_cast<f32>(total);
+        }
+        promise.set_value(result);
+    }
+};
+
+void RunLane(const std::shared_ptr<async_job>& job) {
+    if (job->step()) {
+        job->pool->submit([job] { RunLane(job); });
+    } else if (job->lanes.fetch_sub(1) == 1) {
+        job->finish();
+    }
+}
+
+std::future<async_result> StartReduction(const f32* areas, const f32* weights, size_t size, ThreadPool& pool,
+                                         const cancel_token& token, size_t chunk_size) {
+    auto job = std::make_shared<async_job>();
+    job->areas = areas;
+    job->weights = weights;
+    job->size = size;
+    // Chunks start on whole cache lines for the aligned kernels
+    constexpr size_t LineElements = CacheLineSize / sizeof(f32);
+    job->chunk_size = std::max(LineElements, chunk_size / LineElements * LineElements);
+    job->chunks = (size + job->chunk_size - 1) / job->chunk_size;
+    job->token = token;
+    job->pool = &pool;
+    job->partials.resize(job->chunks);
+    std::future<async_result> result = job->promise.get_future();
+
+    // submit() would run a lane inline on a pool without workers, and every
+    // re-queue would nest one call deeper, so that case loops here instead
+    if (pool.size() == 1) {
+        while (job->step()) {
+        }
+        job->finish();
+        return result;
+    }
+    // One lane per worker; the calling thread takes no part
+    const size_t lanes = std::max<size_t>(1, std::min<size_t>(pool.size() - 1, job->chunks));
+    job->lanes = lanes;
+    for (size_t i = 0; i < lanes; ++i) {
+        pool.submit([job] { RunLane(job); });
+    }
+    return result;
+}
+
+} // namespace
+
+std::future<async_result> TotalAreaAsync(const aligned_vector<f32>& areas, ThreadPool& pool, const cancel_token& token,
+                                         size_t chunk_size) {
+    return StartReduction(areas.data(), nullptr, areas.size(), pool, token, chunk_size);
+}
+
+std::future<async_result> TotalAreaAsync(const AreaCollector& collector, ThreadPool& pool, const cancel_token& token,
+                                         size_t chunk_size) {
+    return TotalAreaAsync(collector.areas(), pool, token, chunk_size);
+}
+
+std::future<async_result> CornerAreaAsync(const CornerCollector& collector, ThreadPool& pool,
+                                          const cancel_token& token, size_t chunk_size) {
+    return StartReduction(collector.areas().data(), collector.weights().data(), collector.size(), pool, token,
+                          chunk_size);
+}
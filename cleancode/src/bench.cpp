@@ -1,18 +1,74 @@
 #include <iostream>
 #include <vector>
-#include <chrono>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
 #include "shapes.h"
+#include "accum.h"
+#include "adaptive_shapes.h"
+#include "async_reduce.h"
+#include "bench_harness.h"
+#include "compact_columns.h"
+#include "concurrent_collector.h"
+#include "device_collector.h"
+#include "instrumentation.h"
+#include "live_collector.h"
+#include "numa_collector.h"
+#include "shape_arena.h"
+#include "shape_batches.h"
+#include "shape_file.h"
+#include "shape_query.h"
+#include "shape_store.h"
+#include "static_shapes.h"
+#include "stream_reduce.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+#include "type_aggregates.h"
 
 // Declarations from other files
 f32 TotalAreaVTBL(u32 ShapeCount, shape_base **Shapes);
 f32 TotalAreaVTBL4(u32 ShapeCount, shape_base **Shapes);
+f32 TotalAreaVTBL8(u32 ShapeCount, shape_base **Shapes);
+f32 TotalAreaVTBL16(u32 ShapeCount, shape_base **Shapes);
 f32 CornerAreaVTBL(u32 ShapeCount, shape_base **Shapes);
 f32 CornerAreaVTBL4(u32 ShapeCount, shape_base **Shapes);
+f32 CornerAreaVTBL8(u32 ShapeCount, shape_base **Shapes);
+f32 CornerAreaVTBL16(u32 ShapeCount, shape_base **Shapes);
+
+// First Metrics of area, corner area and perimeter in one pass
+shape_totals TotalMetricsVTBL(u32 ShapeCount, shape_base **Shapes, u32 Metrics);
+
+// Type-batched OOP versions
+f32 TotalAreaBatched(ShapeBatches& Batches);
+f32 CornerAreaBatched(ShapeBatches& Batches);
 
 // Optimized buffer-based versions
-f32 TotalAreaCollector(AreaCollector& acollector);
-f32 CornerAreaCollector(CornerCollector& collector);
+f32 TotalAreaCollector(const aligned_vector<f32>& areas);
+f32 CornerAreaCollector(const CornerCollector& collector);
+f32 TotalPerimeterCollector(const CornerCollector& collector);
+f32 TotalAreaCollector(LiveAreaCollector& collector);
+f32 CornerAreaCollector(LiveCornerCollector& collector);
+f32 TotalAreaCollector(const aligned_vector<f32>& areas, ThreadPool& pool);
+f32 CornerAreaCollector(const CornerCollector& collector, ThreadPool& pool);
+f32 TotalAreaCollector(const aligned_vector<f32>& areas, accum_policy policy);
+f32 CornerAreaCollector(const CornerCollector& collector, accum_policy policy);
+f32 TotalAreaCollector(CompactCornerCollector& collector);
+f32 CornerAreaCollector(CompactCornerCollector& collector);
+f32 TotalAreaCollector(const MappedCollector& collector);
+f32 CornerAreaCollector(const MappedCollector& collector);
+f32 TotalAreaCollector(const DeviceCollector& collector);
+f32 TotalAreaCollector(const ConcurrentSnapshot& view);
+f32 CornerAreaCollector(const ConcurrentSnapshot& view);
+f32 CornerAreaCollector(const DeviceCollector& collector);
 
 // Buffer traversal optimized versions
 f32 TotalAreaOptVTBL(u32 ShapeCount, char* buffer);
@@ -20,53 +76,572 @@ f32 TotalAreaOptVTBL4(u32 ShapeCount, char* buffer);
 f32 CornerAreaOptVTBL(u32 ShapeCount, char* buffer);
 f32 CornerAreaOptVTBL4(u32 ShapeCount, char* buffer);
 
+// Structure-of-arrays store
+f32 TotalAreaStore(const ShapeStore& store);
+f32 CornerAreaStore(const ShapeStore& store);
+shape_totals TotalMetricsStore(const ShapeStore& store, u32 Metrics);
+
+// Closed-set static dispatch
+f32 TotalAreaVariant(u32 ShapeCount, shape_variant* Shapes);
+f32 TotalAreaVariant4(u32 ShapeCount, shape_variant* Shapes);
+f32 CornerAreaVariant(u32 ShapeCount, shape_variant* Shapes);
+f32 CornerAreaVariant4(u32 ShapeCount, shape_variant* Shapes);
+f32 TotalAreaStatic(const StaticShapes& Set);
+f32 CornerAreaStatic(const StaticShapes& Set);
+
 f32 TotalAreaSwitch(u32 ShapeCount, shape_union* Shapes);
 f32 TotalAreaSwitch4(u32 ShapeCount, shape_union* Shapes);
+f32 TotalAreaSwitch8(u32 ShapeCount, shape_union* Shapes);
+f32 TotalAreaSwitch16(u32 ShapeCount, shape_union* Shapes);
 f32 CornerAreaSwitch(u32 ShapeCount, shape_union* Shapes);
 f32 CornerAreaSwitch4(u32 ShapeCount, shape_union* Shapes);
+f32 CornerAreaSwitch8(u32 ShapeCount, shape_union* Shapes);
+f32 CornerAreaSwitch16(u32 ShapeCount, shape_union* Shapes);
+shape_totals TotalMetricsSwitch(u32 ShapeCount, shape_union* Shapes, u32 Metrics);
 
 f32 TotalAreaUnion(u32 ShapeCount, shape_union* Shapes);
 f32 TotalAreaUnion4(u32 ShapeCount, shape_union* Shapes);
+f32 TotalAreaUnion8(u32 ShapeCount, shape_union* Shapes);
+f32 TotalAreaUnion16(u32 ShapeCount, shape_union* Shapes);
 f32 CornerAreaUnion(u32 ShapeCount, shape_union* Shapes);
 f32 CornerAreaUnion4(u32 ShapeCount, shape_union* Shapes);
+f32 CornerAreaUnion8(u32 ShapeCount, shape_union* Shapes);
+f32 CornerAreaUnion16(u32 ShapeCount, shape_union* Shapes);
+f32 TotalAreaUnionSIMD(u32 ShapeCount, shape_union* Shapes);
+f32 CornerAreaUnionSIMD(u32 ShapeCount, shape_union* Shapes);
+f32 TotalAreaUnion(const TypeAggregates& aggregates);
+f32 CornerAreaUnion(const TypeAggregates& aggregates);
+shape_totals TotalMetricsUnion(u32 ShapeCount, shape_union* Shapes, u32 Metrics);
+const f32* AreaCoefficients();
+const f32* CornerAreaCoefficients();
 
 constexpr u32 N = 1000000;
-constexpr u32 COUNT = 1000;
 
-// Benchmark function for general use
+// Warm-up, sample count, pinning and counters come from the command line
+static BenchHarness harness;
+
 void bench(const char* name, f32(*func)(u32, void*), u32 count, void* shapes) {
-    auto start = std::chrono::high_resolution_clock::now();
-    f32 result = 0.0f;
-    for (u32 i = 0; i < COUNT; ++i) {
-        result = func(count, shapes);
+    harness.run(name, [&] { return func(count, shapes); });
+}
+
+void bench_total_collector(const char* name, f32(*func)(const aligned_vector<f32>&), const aligned_vector<f32>& areas) {
+    harness.run(name, [&] { return func(areas); });
+}
+
+void bench_corner_collector(const char* name, const CornerCollector& collector) {
+    harness.run(name, [&] { return CornerAreaCollector(collector); });
+}
+
+// Bytes held by the collector columns
+static size_t CollectorBytes(const CornerCollector& collector) {
+    return collector.areas().capacity() * sizeof(f32) + collector.cornerCounts().capacity() * sizeof(u8) +
+           collector.weights().capacity() * sizeof(f32);
+}
+
+// Aligned against unaligned loads over the collector columns, then the dot
+// product per software prefetch distance. With --tune-prefetch the fastest
+// distance stays in effect for the remaining sections.
+void bench_alignment_prefetch(const CornerCollector& collector, bool tune) {
+    const simd_kernels& kernels = SimdKernels();
+    const f32* areas = collector.areas().data();
+    const f32* weights = collector.weights().data();
+    const size_t size = collector.size();
+    harness.run("Sum, aligned column, unaligned loads", [&] { return kernels.sum(areas, size); });
+    harness.run("Sum, aligned column, aligned loads", [&] { return kernels.sum_aligned(areas, size); });
+    harness.run("Sum, column 4 bytes off a line", [&] { return kernels.sum(areas + 1, size - 1); });
+    harness.run("Dot, aligned column, unaligned loads", [&] { return kernels.dot(areas, weights, size); });
+    harness.run("Dot, aligned column, aligned loads", [&] { return kernels.dot_aligned(areas, weights, size); });
+    harness.run("Dot, column 4 bytes off a line", [&] { return kernels.dot(areas + 1, weights + 1, size - 1); });
+
+    const size_t configured = PrefetchDistance();
+    size_t best = configured;
+    double best_ms = 0.0;
+    for (size_t distance : {0, 32, 64, 128, 256, 512, 1024, 2048}) {
+        SetPrefetchDistance(distance);
+        f32 result = 0.0f;
+        double ms = harness.measure([&] { return kernels.dot_aligned(areas, weights, size); }, result).median_ms;
+        std::cout << "Prefetch distance " << distance << ": median " << ms << " ms, result = " << result << std::endl;
+        if (best_ms == 0.0 || ms < best_ms) {
+            best = distance;
+            best_ms = ms;
+        }
     }
-    auto end = std::chrono::high_resolution_clock::now();
-    double ms = std::chrono::duration<double, std::milli>(end - start).count();
-    std::cout << name << ": " << ms / COUNT << " ms avg (" << COUNT << " runs), result = " << result << std::endl;
+    SetPrefetchDistance(tune ? best : configured);
+    std::cout << "Fastest prefetch distance: " << best << (tune ? " (applied)" : "") << ", in effect: "
+              << PrefetchDistance() << std::endl;
 }
 
-// Specialized benchmark function for AreaCollector
-void bench_total_collector(const char* name, f32(*func)(AreaCollector&), AreaCollector& collector) {
-    auto start = std::chrono::high_resolution_clock::now();
-    f32 result = 0.0f;
-    for (u32 i = 0; i < COUNT; ++i) {
-        result = func(collector);
+// Thread scaling of the parallel collector reductions: 1, 2, 4, ... up to
+// the hardware thread count. Throughput counts the bytes of the columns read.
+void bench_parallel_collectors(const aligned_vector<f32>& areas, const CornerCollector& corner_collector) {
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<unsigned> thread_counts;
+    for (unsigned t = 1; t < max_threads; t *= 2) {
+        thread_counts.push_back(t);
+    }
+    thread_counts.push_back(max_threads);
+
+    const double area_bytes = double(areas.size()) * sizeof(f32);
+    const double corner_bytes = double(corner_collector.size()) * 2 * sizeof(f32);
+    double total_base = 0.0, corner_base = 0.0;
+
+    // Workers inherit the affinity of the thread that starts them
+    if (harness.options().cpu >= 0) {
+        UnpinThread();
+    }
+
+    for (unsigned threads : thread_counts) {
+        ThreadPool pool(threads);
+
+        f32 total = 0.0f, corner = 0.0f;
+        double total_ms = harness.measure([&] { return TotalAreaCollector(areas, pool); }, total).median_ms;
+        double corner_ms = harness.measure([&] { return CornerAreaCollector(corner_collector, pool); }, corner).median_ms;
+        if (threads == 1) {
+            total_base = total_ms;
+            corner_base = corner_ms;
+        }
+        std::cout << "TotalAreaCollector x" << threads << ": median " << total_ms << " ms, "
+                  << area_bytes / (total_ms * 1e6) << " GB/s, speedup " << total_base / total_ms
+                  << ", result = " << total << std::endl;
+        std::cout << "CornerCollector x" << threads << ": median " << corner_ms << " ms, "
+                  << corner_bytes / (corner_ms * 1e6) << " GB/s, speedup " << corner_base / corner_ms
+                  << ", result = " << corner << std::endl;
+    }
+
+    if (harness.options().cpu >= 0) {
+        PinToCpu(harness.options().cpu);
+    }
+}
+
+// Async reductions on a pool with at least one worker: the latency of a
+// whole pass, how long a short task queued behind a pass waits per chunk
+// size, and how quickly a cancelled pass releases its future
+void bench_async_reductions(const aligned_vector<f32>& areas, const CornerCollector& corner_collector) {
+    // Workers inherit the affinity of the thread that starts them
+    if (harness.options().cpu >= 0) {
+        UnpinThread();
+    }
+    {
+        ThreadPool pool(std::max(2u, std::thread::hardware_concurrency()));
+        harness.run("TotalAreaAsync", [&] { return TotalAreaAsync(areas, pool).get().Value; });
+        harness.run("CornerAreaAsync", [&] { return CornerAreaAsync(corner_collector, pool).get().Value; });
+
+        const size_t chunk_sizes[] = {areas.size(), AsyncChunkSize, 32 * 1024};
+        for (size_t chunk_size : chunk_sizes) {
+            std::vector<double> waits;
+            f32 total = 0.0f;
+            bench_stats stats = harness.measure([&] {
+                std::future<async_result> pass = TotalAreaAsync(areas, pool, cancel_token(), chunk_size);
+                std::promise<double> ran;
+                auto queued = std::chrono::high_resolution_clock::now();
+                pool.submit([&] {
+                    ran.set_value(std::chrono::duration<double, std::milli>(
+                        std::chrono::high_resolution_clock::now() - queued).count());
+                });
+                waits.push_back(ran.get_future().get());
+                return pass.get().Value;
+            }, total);
+            std::nth_element(waits.begin(), waits.begin() + waits.size() / 2, waits.end());
+            std::cout << "Task behind a pass, chunk " << chunk_size << ": wait median " << waits[waits.size() / 2]
+                      << " ms, pass median " << stats.median_ms << " ms, result = " << total << std::endl;
+        }
+
+        harness.run("Cancelled TotalAreaAsync", [&] {
+            cancel_token token;
+            std::future<async_result> pass = TotalAreaAsync(areas, pool, token, 32 * 1024);
+            token.cancel();
+            return f32(pass.get().Cancelled);
+        });
+    }
+    if (harness.options().cpu >= 0) {
+        PinToCpu(harness.options().cpu);
+    }
+}
+
+// The calibrated profile, then two workloads over the facade - one mutation
+// per query, and a hundred queries per mutation - adaptive against every
+// engine forced. Each mutation rewrites one record with its own value.
+void bench_adaptive_engines(const std::vector<shape_union>& flat_shapes) {
+    constexpr u32 ROUNDS = 5;
+    AdaptiveShapes shapes;
+    for (const shape_union& shape : flat_shapes) {
+        shapes.add(shape);
+    }
+    const adaptive_profile& profile = shapes.profile();
+    for (u32 e = 0; e < Adaptive_EngineCount; ++e) {
+        std::cout << "Profile " << AdaptiveEngineName(adaptive_engine(e)) << ": build " << profile.Build[e]
+                  << " ns/shape, total " << profile.Total[e] << " ns/shape, corner " << profile.Corner[e]
+                  << " ns/shape" << std::endl;
+    }
+
+    struct workload {
+        const char* name;
+        u32 mutations;
+        u32 queries_per_mutation;
+    };
+    const workload workloads[] = {{"1 query/mutation", 20, 1}, {"100 queries/mutation", 3, 100}};
+    for (const workload& w : workloads) {
+        for (u32 e = 0; e <= Adaptive_EngineCount; ++e) {
+            shapes.force(adaptive_engine(e));
+            u32 next = 0;
+            f32 total = 0.0f;
+            bench_stats stats = harness.measure(ROUNDS, [&] {
+                f32 Accum = 0.0f;
+                for (u32 m = 0; m < w.mutations; ++m) {
+                    next = (next + 7919) % static_cast<u32>(flat_shapes.size());
+                    shapes.set(next, flat_shapes[next]);
+                    for (u32 q = 0; q < w.queries_per_mutation; ++q) {
+                        Accum = shapes.totalArea();
+                    }
+                }
+                return Accum;
+            }, total);
+            std::string name = std::string(w.name) + ", " +
+                               (e == Adaptive_EngineCount ? "adaptive" : AdaptiveEngineName(adaptive_engine(e)));
+            PrintBenchStats(name.c_str(), stats, total);
+        }
+        std::cout << "    adaptive picked " << AdaptiveEngineName(shapes.lastEngine()) << ", "
+                  << shapes.queriesPerMutation() << " queries/mutation tracked" << std::endl;
     }
-    auto end = std::chrono::high_resolution_clock::now();
-    double ms = std::chrono::duration<double, std::milli>(end - start).count();
-    std::cout << name << ": " << ms / COUNT << " ms avg (" << COUNT << " runs), result = " << result << std::endl;
 }
 
-// Simplified benchmark function for CornerCollector
-void bench_corner_collector(const char* name, CornerCollector& collector) {
+// Probe cost: the switch engine called on short slices, where the two
+// timestamp reads and the counter updates are a visible share of each call.
+// Compare against a build without -DCLEANCODE_INSTRUMENT=ON.
+void bench_instrumentation(std::vector<shape_union>& flat_shapes) {
+    constexpr u32 SLICE = 256;
+    const u32 count = static_cast<u32>(flat_shapes.size()) / SLICE * SLICE;
+    std::cout << "Probes " << (MetricsEnabled ? "compiled in" : "compiled out") << ", timestamp "
+              << TimestampTicksPerNs() << " ticks/ns" << std::endl;
+    harness.run("Switch TotalArea, 256-shape calls", [&] {
+        f32 Accum = 0.0f;
+        for (u32 i = 0; i < count; i += SLICE) {
+            Accum += TotalAreaSwitch(SLICE, flat_shapes.data() + i);
+        }
+        return Accum;
+    });
+}
+
+// Per-type aggregates over the flat records: a query against the SIMD table
+// scan, and the per-frame cost when 1% of the records change, rescanning
+// versus updating the aggregates with the old and new record
+void bench_type_aggregates(const std::vector<shape_union>& flat_shapes) {
+    const u32 stride = 100;
+    std::vector<shape_union> shapes = flat_shapes;
+    const u32 count = static_cast<u32>(shapes.size());
+
+    TypeAggregates aggregates;
     auto start = std::chrono::high_resolution_clock::now();
-    f32 result = 0.0f;
-    for (u32 i = 0; i < COUNT; ++i) {
-        result = CornerAreaCollector(collector);
+    aggregates.addShapes(count, shapes.data());
+    double build_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "Aggregate build: " << build_ms << " ms (once)" << std::endl;
+
+    harness.run("Aggregate TotalArea", [&] { return TotalAreaUnion(aggregates); });
+    harness.run("Aggregate CornerArea", [&] { return CornerAreaUnion(aggregates); });
+    harness.run("Table SIMD TotalArea", [&] { return TotalAreaUnionSIMD(count, shapes.data()); });
+
+    // Each frame toggles the width of every stride-th record between two
+    // values. The rescan works on its own copy; the aggregates stay in step
+    // with shapes.
+    u32 frame = 0;
+    auto change = [&](u32 i) {
+        shape_union updated = flat_shapes[i];
+        updated.Width = ((frame / stride) & 1) ? flat_shapes[i].Width : flat_shapes[i].Width * 1.5f;
+        return updated;
+    };
+    std::vector<shape_union> scanned = flat_shapes;
+    harness.run("Rescan per frame", [&] {
+        for (u32 i = frame % stride; i < count; i += stride) {
+            scanned[i] = change(i);
+        }
+        ++frame;
+        return TotalAreaUnionSIMD(count, scanned.data());
+    });
+    frame = 0;
+    harness.run("Aggregate update per frame", [&] {
+        for (u32 i = frame % stride; i < count; i += stride) {
+            shape_union updated = change(i);
+            aggregates.update(shapes[i], updated);
+            shapes[i] = updated;
+        }
+        ++frame;
+        return TotalAreaUnion(aggregates);
+    });
+
+    f32 drifted = TotalAreaUnion(aggregates);
+    aggregates.rebuild(count, shapes.data());
+    std::cout << "After updates: " << drifted << ", rebuilt: " << TotalAreaUnion(aggregates)
+              << ", rescan: " << TotalAreaUnionSIMD(count, shapes.data()) << std::endl;
+}
+
+// Per-node bandwidth of the NUMA-partitioned collector: every segment read by
+// the workers of every node (the diagonal is local, the rest remote), then all
+// nodes reducing their own segments at once
+void bench_numa_collectors(std::vector<shape_base*>& shapes) {
+    NumaCornerCollector collector;
+    collector.assign(static_cast<u32>(shapes.size()), shapes.data());
+    for (u32 n = 0; n < collector.nodeCount(); ++n) {
+        std::cout << "Node " << collector.node(n).Id << ": " << collector.node(n).Cpus.size() << " CPUs, "
+                  << collector.segmentSize(n) << " shapes" << std::endl;
+    }
+
+    for (u32 n = 0; n < collector.nodeCount(); ++n) {
+        const double bytes = double(collector.segmentSize(n)) * 2 * sizeof(f32);
+        for (u32 reader = 0; reader < collector.nodeCount(); ++reader) {
+            f32 result = 0.0f;
+            double ms = harness.measure([&] { return collector.segmentCornerArea(n, reader); }, result).median_ms;
+            std::cout << "Segment " << collector.node(n).Id << " read by node " << collector.node(reader).Id
+                      << (n == reader ? " (local)" : " (remote)") << ": median " << ms << " ms, "
+                      << bytes / (ms * 1e6) << " GB/s, result = " << result << std::endl;
+        }
+    }
+
+    const double area_bytes = double(collector.size()) * sizeof(f32);
+    f32 total = 0.0f, corner = 0.0f;
+    double total_ms = harness.measure([&] { return collector.totalArea(); }, total).median_ms;
+    double corner_ms = harness.measure([&] { return collector.cornerArea(); }, corner).median_ms;
+    std::cout << "NUMA TotalArea, all nodes: median " << total_ms << " ms, " << area_bytes / (total_ms * 1e6)
+              << " GB/s, result = " << total << std::endl;
+    std::cout << "NUMA CornerArea, all nodes: median " << corner_ms << " ms, " << 2 * area_bytes / (corner_ms * 1e6)
+              << " GB/s, result = " << corner << std::endl;
+}
+
+// Per-frame cost when 1% of the shapes change: rebuilding the collectors from
+// the shape list versus refreshing the live collectors in place, one sample
+// per frame
+void bench_live_collectors(std::vector<shape_base*>& shapes) {
+    constexpr u32 FRAMES = 100;
+    const u32 stride = 100;
+
+    f32 rebuilt_corner = 0.0f, rebuilt_total = 0.0f;
+    bench_stats rebuilt = harness.measure(FRAMES, [&] {
+        CornerCollector collector;
+        for (shape_base* shape : shapes) {
+            collector.addShape(shape);
+        }
+        rebuilt_corner = CornerAreaCollector(collector);
+        return TotalAreaCollector(collector.areas());
+    }, rebuilt_total);
+    PrintBenchStats("Rebuild per frame", rebuilt, rebuilt_total);
+    std::cout << "    corner = " << rebuilt_corner << std::endl;
+
+    LiveAreaCollector live_area;
+    LiveCornerCollector live_corner;
+    std::vector<shape_handle> area_handles, corner_handles;
+    for (shape_base* shape : shapes) {
+        area_handles.push_back(live_area.addShape(shape));
+        corner_handles.push_back(live_corner.addShape(shape));
+    }
+
+    u32 frame = 0;
+    f32 live_corner_total = 0.0f, live_total = 0.0f;
+    bench_stats live = harness.measure(FRAMES, [&] {
+        // Refresh every stride-th shape, and remove and re-insert a few more
+        u32 phase = frame++ % (stride * stride);
+        for (size_t i = phase % stride; i < shapes.size(); i += stride) {
+            live_area.updateShape(area_handles[i]);
+            live_corner.updateShape(corner_handles[i]);
+        }
+        for (size_t i = phase; i < shapes.size(); i += stride * stride) {
+            live_area.removeShape(area_handles[i]);
+            live_corner.removeShape(corner_handles[i]);
+            area_handles[i] = live_area.addShape(shapes[i]);
+            corner_handles[i] = live_corner.addShape(shapes[i]);
+        }
+        live_corner_total = CornerAreaCollector(live_corner);
+        return TotalAreaCollector(live_area);
+    }, live_total);
+    PrintBenchStats("Live update per frame", live, live_total);
+    std::cout << "    corner = " << live_corner_total << std::endl;
+
+    // A second remove of the same handle must be refused and leave the
+    // totals as they were after the first
+    live_area.removeShape(area_handles[0]);
+    live_corner.removeShape(corner_handles[0]);
+    const f32 removed_total = TotalAreaCollector(live_area), removed_corner = CornerAreaCollector(live_corner);
+    const bool refused = !live_area.removeShape(area_handles[0]) && !live_corner.removeShape(corner_handles[0]) &&
+                         !live_area.updateShape(area_handles[0]) && !live_corner.updateShape(corner_handles[0]);
+    const bool unchanged = TotalAreaCollector(live_area) == removed_total &&
+                           CornerAreaCollector(live_corner) == removed_corner;
+    std::cout << "Stale handle: " << (refused && unchanged ? "refused" : "ACCEPTED") << ", size " << live_area.size()
+              << ", total = " << TotalAreaCollector(live_area) << std::endl;
+}
+
+// Producers appending batches while this thread reports in a loop: one
+// CornerCollector behind a mutex against lock-free lanes read through
+// snapshots. A run is the whole ingest; the reports are those completed
+// while it lasted.
+void bench_concurrent_ingest(std::vector<shape_base*>& shapes) {
+    constexpr u32 ROUNDS = 10;
+    constexpr u32 BATCH = 1024;
+    const unsigned producers = std::min(ConcurrentMaxLanes, std::max(2u, std::thread::hardware_concurrency()));
+    const u32 count = static_cast<u32>(shapes.size());
+    const u32 share = (count + producers - 1) / producers;
+
+    // produce(begin, end) on every producer thread, report() here until all
+    // of them finished; returns the number of reports
+    auto ingest = [&](const auto& produce, const auto& report) {
+        std::atomic<unsigned> running{producers};
+        std::vector<std::thread> threads;
+        for (unsigned p = 0; p < producers; ++p) {
+            threads.emplace_back([&, p] {
+                u32 begin = std::min(count, p * share);
+                produce(begin, std::min(count, begin + share));
+                running.fetch_sub(1);
+            });
+        }
+        u32 reports = 0;
+        while (running.load() > 0) {
+            report();
+            ++reports;
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        return reports;
+    };
+
+    // Producers inherit the affinity of this thread
+    if (harness.options().cpu >= 0) {
+        UnpinThread();
+    }
+    u32 reports = 0;
+    f32 corner = 0.0f;
+    bench_stats stats = harness.measure(ROUNDS, [&] {
+        CornerCollector collector;
+        std::mutex mutex;
+        reports = ingest([&](u32 begin, u32 end) {
+            for (u32 i = begin; i < end; i += BATCH) {
+                std::lock_guard<std::mutex> lock(mutex);
+                collector.addShapes(std::min(BATCH, end - i), shapes.data() + i);
+            }
+        }, [&] {
+            std::lock_guard<std::mutex> lock(mutex);
+            DoNotOptimize(CornerAreaCollector(collector));
+        });
+        return CornerAreaCollector(collector);
+    }, corner);
+    PrintBenchStats(("Mutex collector x" + std::to_string(producers)).c_str(), stats, corner);
+    std::cout << "    " << reports << " reports during ingest" << std::endl;
+
+    stats = harness.measure(ROUNDS, [&] {
+        ConcurrentCornerCollector collector;
+        reports = ingest([&](u32 begin, u32 end) {
+            concurrent_lane* lane = collector.addLane();
+            for (u32 i = begin; i < end; i += BATCH) {
+                lane->addShapes(std::min(BATCH, end - i), shapes.data() + i);
+            }
+        }, [&] { DoNotOptimize(CornerAreaCollector(collector.snapshot())); });
+        return CornerAreaCollector(collector.snapshot());
+    }, corner);
+    PrintBenchStats(("Concurrent lanes x" + std::to_string(producers)).c_str(), stats, corner);
+    std::cout << "    " << reports << " reports during ingest" << std::endl;
+    if (harness.options().cpu >= 0) {
+        PinToCpu(harness.options().cpu);
+    }
+
+    ConcurrentCornerCollector collector;
+    collector.addLane()->addShapes(count, shapes.data());
+    ConcurrentSnapshot view = collector.snapshot();
+    harness.run("Snapshot TotalArea", [&] { return TotalAreaCollector(view); });
+    harness.run("Snapshot CornerArea", [&] { return CornerAreaCollector(view); });
+}
+
+// Throughput and relative error of every accumulation policy; the reference
+// is accumulated in long double
+void bench_accum_policies(const aligned_vector<f32>& areas, const CornerCollector& corner_collector) {
+    static const char* const PolicyNames[Accum_PolicyCount] = {"f32", "f64", "neumaier", "pairwise"};
+
+    long double exact_total = 0.0L, exact_corner = 0.0L;
+    for (size_t i = 0; i < areas.size(); ++i) {
+        exact_total += areas[i];
+    }
+    for (size_t i = 0; i < corner_collector.size(); ++i) {
+        exact_corner += (long double)corner_collector.areas()[i] * corner_collector.weights()[i];
+    }
+
+    for (u32 p = 0; p < Accum_PolicyCount; ++p) {
+        accum_policy policy = static_cast<accum_policy>(p);
+        f32 total = 0.0f, corner = 0.0f;
+        double total_ms = harness.measure([&] { return TotalAreaCollector(areas, policy); }, total).median_ms;
+        double corner_ms = harness.measure([&] { return CornerAreaCollector(corner_collector, policy); }, corner).median_ms;
+        double total_error = std::fabs(double(total - exact_total) / double(exact_total));
+        double corner_error = std::fabs(double(corner - exact_corner) / double(exact_corner));
+        std::cout << "TotalAreaCollector [" << PolicyNames[p] << "]: median " << total_ms
+                  << " ms, result = " << total << ", rel. error = " << total_error << std::endl;
+        std::cout << "CornerCollector [" << PolicyNames[p] << "]: median " << corner_ms
+                  << " ms, result = " << corner << ", rel. error = " << corner_error << std::endl;
+    }
+}
+
+// Time, bytes per shape and relative error of the compact encodings; the
+// reference is the f32 collector accumulated in long double
+void bench_compact_columns(const CornerCollector& corner_collector) {
+    static const char* const EncodingNames[Encoding_Count] = {"f32", "f16", "bf16"};
+
+    long double exact_total = 0.0L, exact_corner = 0.0L;
+    const aligned_vector<f32>& areas = corner_collector.areas();
+    const aligned_vector<f32>& weights = corner_collector.weights();
+    for (size_t i = 0; i < areas.size(); ++i) {
+        exact_total += areas[i];
+        exact_corner += (long double)areas[i] * weights[i];
+    }
+
+    for (u32 e = 0; e < Encoding_Count; ++e) {
+        CompactCornerCollector compact;
+        if (!compact.encode(corner_collector, static_cast<column_encoding>(e))) {
+            std::cout << "Compact [" << EncodingNames[e] << "]: too many distinct weights" << std::endl;
+            continue;
+        }
+        f32 total = 0.0f, corner = 0.0f;
+        double total_ms = harness.measure([&] { return TotalAreaCollector(compact); }, total).median_ms;
+        double corner_ms = harness.measure([&] { return CornerAreaCollector(compact); }, corner).median_ms;
+        const double shapes = double(compact.size());
+        std::cout << "Compact TotalArea [" << EncodingNames[e] << "]: median " << total_ms << " ms, "
+                  << compact.areaBytes() / shapes << " B/shape, result = " << total
+                  << ", rel. error = " << std::fabs(double(total - exact_total) / double(exact_total)) << std::endl;
+        std::cout << "Compact CornerArea [" << EncodingNames[e] << " + u8 weights]: median " << corner_ms << " ms, "
+                  << compact.cornerBytes() / shapes << " B/shape, result = " << corner
+                  << ", rel. error = " << std::fabs(double(corner - exact_corner) / double(exact_corner)) << std::endl;
     }
-    auto end = std::chrono::high_resolution_clock::now();
-    double ms = std::chrono::duration<double, std::milli>(end - start).count();
-    std::cout << name << ": " << ms / COUNT << " ms avg (" << COUNT << " runs), result = " << result << std::endl;
+}
+
+// One row per SIMD kernel variant the running CPU supports
+void bench_simd_variants(const aligned_vector<f32>& areas, const CornerCollector& corner_collector,
+                         std::vector<shape_union>& flat_shapes) {
+    std::cout << "Selected variant: " << SimdKernels().name << std::endl;
+    for (const simd_kernels* kernels : AvailableSimdKernels()) {
+        std::string suffix = std::string(" [") + kernels->name + "]";
+        harness.run(("TotalAreaCollector" + suffix).c_str(), [&] {
+            return kernels->sum(areas.data(), areas.size());
+        });
+        harness.run(("CornerCollector" + suffix).c_str(), [&] {
+            return kernels->dot(corner_collector.areas().data(), corner_collector.weights().data(),
+                                corner_collector.size());
+        });
+        harness.run(("Table TotalArea" + suffix).c_str(), [&] {
+            return kernels->union_sum(flat_shapes.data(), flat_shapes.size(), AreaCoefficients());
+        });
+        harness.run(("Table CornerArea" + suffix).c_str(), [&] {
+            return kernels->union_sum(flat_shapes.data(), flat_shapes.size(), CornerAreaCoefficients());
+        });
+    }
+}
+
+// Adapters from the typed kernel signatures to bench()
+template <f32 (*Func)(u32, shape_base**)>
+f32 vtbl_kernel(u32 count, void* shapes) {
+    return Func(count, (shape_base**)shapes);
+}
+
+template <f32 (*Func)(u32, shape_union*)>
+f32 union_kernel(u32 count, void* shapes) {
+    return Func(count, (shape_union*)shapes);
+}
+
+template <class T, f32 (*Func)(u32, T*)>
+f32 union_kernel_of(u32 count, void* shapes) {
+    return Func(count, (T*)shapes);
 }
 
 // Function pointer wrappers for compatibility
@@ -102,6 +677,30 @@ f32 switch_corner4(u32 count, void* shapes) {
     return CornerAreaSwitch4(count, (shape_union*)shapes); 
 }
 
+f32 batched_area(u32, void* batches) {
+    return TotalAreaBatched(*(ShapeBatches*)batches);
+}
+
+f32 batched_corner(u32, void* batches) {
+    return CornerAreaBatched(*(ShapeBatches*)batches);
+}
+
+f32 optvtbl_area(u32 count, void* buffer) {
+    return TotalAreaOptVTBL(count, (char*)buffer);
+}
+
+f32 optvtbl_area4(u32 count, void* buffer) {
+    return TotalAreaOptVTBL4(count, (char*)buffer);
+}
+
+f32 optvtbl_corner(u32 count, void* buffer) {
+    return CornerAreaOptVTBL(count, (char*)buffer);
+}
+
+f32 optvtbl_corner4(u32 count, void* buffer) {
+    return CornerAreaOptVTBL4(count, (char*)buffer);
+}
+
 f32 table_area(u32 count, void* shapes) { 
     return TotalAreaUnion(count, (shape_union*)shapes); 
 }
@@ -118,19 +717,736 @@ f32 table_corner4(u32 count, void* shapes) {
     return CornerAreaUnion4(count, (shape_union*)shapes); 
 }
 
-int main() {
+f32 table_area_simd(u32 count, void* shapes) {
+    return TotalAreaUnionSIMD(count, (shape_union*)shapes);
+}
+
+f32 table_corner_simd(u32 count, void* shapes) {
+    return CornerAreaUnionSIMD(count, (shape_union*)shapes);
+}
+
+f32 static_area(u32, void* set) {
+    return TotalAreaStatic(*(StaticShapes*)set);
+}
+
+f32 static_corner(u32, void* set) {
+    return CornerAreaStatic(*(StaticShapes*)set);
+}
+
+f32 store_area(u32, void* store) {
+    return TotalAreaStore(*(ShapeStore*)store);
+}
+
+f32 store_corner(u32, void* store) {
+    return CornerAreaStore(*(ShapeStore*)store);
+}
+
+// Variant storage and CRTP shapes, plus collector ingest from CRTP shapes
+// (no virtual call per shape) against ingest from the shape_base objects
+void bench_static_dispatch(std::vector<shape_union>& flat_shapes, std::vector<shape_base*>& vtbl_shapes) {
+    std::vector<shape_variant> variants;
+    StaticShapes static_shapes;
+    variants.reserve(flat_shapes.size());
+    for (const shape_union& shape : flat_shapes) {
+        variants.push_back(MakeShapeVariant(shape));
+        AddStaticShape(static_shapes, shape);
+    }
+
+    const u32 count = static_cast<u32>(variants.size());
+    bench("Variant TotalArea", union_kernel_of<shape_variant, TotalAreaVariant>, count, variants.data());
+    bench("Variant TotalArea4", union_kernel_of<shape_variant, TotalAreaVariant4>, count, variants.data());
+    bench("Variant CornerArea", union_kernel_of<shape_variant, CornerAreaVariant>, count, variants.data());
+    bench("Variant CornerArea4", union_kernel_of<shape_variant, CornerAreaVariant4>, count, variants.data());
+    bench("CRTP TotalArea", static_area, count, &static_shapes);
+    bench("CRTP CornerArea", static_corner, count, &static_shapes);
+
+    constexpr u32 ROUNDS = 20;
+    f32 filled = 0.0f;
+    bench_stats virtual_fill = harness.measure(ROUNDS, [&] {
+        CornerCollector collector;
+        for (shape_base* shape : vtbl_shapes) {
+            collector.addShape(shape);
+        }
+        return f32(collector.size());
+    }, filled);
+    PrintBenchStats("Collector fill, virtual", virtual_fill, filled);
+    bench_stats static_fill = harness.measure(ROUNDS, [&] {
+        CornerCollector collector;
+        for (const static_square& shape : static_shapes.of<static_square>()) collector.addShape(shape);
+        for (const static_rectangle& shape : static_shapes.of<static_rectangle>()) collector.addShape(shape);
+        for (const static_triangle& shape : static_shapes.of<static_triangle>()) collector.addShape(shape);
+        for (const static_circle& shape : static_shapes.of<static_circle>()) collector.addShape(shape);
+        return f32(collector.size());
+    }, filled);
+    PrintBenchStats("Collector fill, CRTP", static_fill, filled);
+}
+
+// Collector fill per shape against the bulk ingest: from the interleaved
+// objects (runs of length one), from the objects sorted by type (a few long
+// runs), from the store (no dispatch), and the store ingest on the pool
+void bench_bulk_ingest(std::vector<shape_base*>& shapes, ShapeBatches& batches, const ShapeStore& store) {
+    constexpr u32 ROUNDS = 20;
+    const u32 count = static_cast<u32>(shapes.size());
+    f32 filled = 0.0f;
+
+    auto fill = [&](const char* name, auto&& add) {
+        bench_stats stats = harness.measure(ROUNDS, [&] {
+            CornerCollector collector;
+            add(collector);
+            return CornerAreaCollector(collector);
+        }, filled);
+        PrintBenchStats(name, stats, filled);
+    };
+
+    fill("Fill per shape", [&](CornerCollector& collector) {
+        for (shape_base* shape : shapes) {
+            collector.addShape(shape);
+        }
+    });
+    fill("Bulk fill, interleaved", [&](CornerCollector& collector) { collector.addShapes(count, shapes.data()); });
+    fill("Bulk fill, sorted", [&](CornerCollector& collector) {
+        collector.addShapes(static_cast<u32>(batches.shapes.size()), batches.shapes.data());
+    });
+    fill("Bulk fill, store", [&](CornerCollector& collector) { collector.addShapes(store); });
+
+    // Workers inherit the affinity of the thread that starts them
+    if (harness.options().cpu >= 0) {
+        UnpinThread();
+    }
+    {
+        ThreadPool pool;
+        std::string suffix = " x" + std::to_string(pool.size());
+        fill(("Bulk fill, interleaved" + suffix).c_str(),
+             [&](CornerCollector& collector) { collector.addShapes(count, shapes.data(), pool); });
+        fill(("Bulk fill, store" + suffix).c_str(), [&](CornerCollector& collector) { collector.addShapes(store, pool); });
+    }
+    if (harness.options().cpu >= 0) {
+        PinToCpu(harness.options().cpu);
+    }
+}
+
+// Writing the store as a shape file, opening it (the whole startup cost of a
+// mapped dataset), reducing straight over the mapping and streaming it.
+// Without a path the file goes to the temp directory and is removed afterwards.
+void bench_shape_file(const ShapeStore& store, const std::string& path) {
+    std::string file = path.empty() ? (std::filesystem::temp_directory_path() / "bench_shapes.col").string() : path;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    bool written = WriteShapeFile(file, store);
+    double write_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    if (!written) {
+        std::cout << "cannot write " << file << std::endl;
+        return;
+    }
+
+    MappedCollector collector;
+    start = std::chrono::high_resolution_clock::now();
+    bool opened = collector.open(file);
+    double open_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    if (!opened) {
+        std::cout << "cannot map " << file << std::endl;
+        return;
+    }
+    std::cout << "Shape file: " << collector.bytes() / double(1 << 20) << " MB, write " << write_ms << " ms, open "
+              << open_ms << " ms" << std::endl;
+    harness.run("Mapped TotalArea", [&] { return TotalAreaCollector(collector); });
+    harness.run("Mapped CornerArea", [&] { return CornerAreaCollector(collector); });
+
+    // Bounded-memory scans of the same file: chunks of the mapping with paging
+    // hints, and pread into two buffers on a reader thread
+    harness.run("Streamed mapping TotalArea", [&] { return TotalAreaStream(collector); });
+    harness.run("Streamed mapping CornerArea", [&] { return CornerAreaStream(collector); });
+    auto stream_file = [&](f32 (*reduce)(const shape_chunk_source&, size_t)) {
+        ShapeFileReader reader;
+        if (!reader.open(file)) {
+            return 0.0f;
+        }
+        return reduce([&](f32* areas, f32* weights, size_t capacity) { return reader.read(areas, weights, capacity); },
+                      StreamChunkSize);
+    };
+    harness.run("Streamed reader TotalArea", [&] { return stream_file(TotalAreaStream); });
+    harness.run("Streamed reader CornerArea", [&] { return stream_file(CornerAreaStream); });
+
+    collector.close();
+    if (path.empty()) {
+        std::remove(file.c_str());
+    }
+}
+
+// Per backend usable on this host: the one-time upload of the collector
+// columns and of the store, then the reductions over the resident columns
+void bench_device_collectors(CornerCollector& collector, const ShapeStore& store, const std::string& backend) {
+    constexpr u32 ROUNDS = 20;
+    std::cout << "Device backends:";
+    for (const std::string& name : AvailableDeviceBackends()) {
+        std::cout << " " << name;
+    }
+    std::cout << ", --backend=" << backend << " selects " << MakeDeviceCollector(backend)->backend() << std::endl;
+
+    for (const std::string& name : AvailableDeviceBackends()) {
+        std::unique_ptr<DeviceCollector> device = MakeDeviceCollector(name);
+        f32 uploaded = 0.0f;
+        bench_stats stats = harness.measure(ROUNDS, [&] {
+            return device->upload(collector) ? f32(device->size()) : 0.0f;
+        }, uploaded);
+        PrintBenchStats((name + " upload collector").c_str(), stats, uploaded);
+        harness.run((name + " TotalArea").c_str(), [&] { return TotalAreaCollector(*device); });
+        harness.run((name + " CornerArea").c_str(), [&] { return CornerAreaCollector(*device); });
+        harness.run((name + " fused Total+Corner").c_str(), [&] {
+            device_reduction r = device->reduce();
+            return r.TotalArea + r.CornerArea;
+        });
+
+        stats = harness.measure(ROUNDS, [&] { return device->upload(store) ? f32(device->size()) : 0.0f; }, uploaded);
+        PrintBenchStats((name + " upload store").c_str(), stats, uploaded);
+        harness.run((name + " store CornerArea").c_str(), [&] { return CornerAreaCollector(*device); });
+    }
+}
+
+// Area, then area + corner area, then all three metrics in one pass, under
+// each code style: the clean code pays one more virtual call per shape and
+// metric, the switch and the table one more switch or lookup, and the store
+// reads its two columns once whatever the metric count
+void bench_shape_metrics(std::vector<shape_base*>& vtbl_shapes, std::vector<shape_union>& flat_shapes,
+                         const ShapeStore& store) {
+    struct style {
+        const char* name;
+        std::function<shape_totals(u32)> totals;
+    };
+    const u32 count = static_cast<u32>(flat_shapes.size());
+    const style styles[] = {
+        {"VTBL", [&](u32 metrics) { return TotalMetricsVTBL(count, vtbl_shapes.data(), metrics); }},
+        {"Switch", [&](u32 metrics) { return TotalMetricsSwitch(count, flat_shapes.data(), metrics); }},
+        {"Table", [&](u32 metrics) { return TotalMetricsUnion(count, flat_shapes.data(), metrics); }},
+        {"Store SIMD", [&](u32 metrics) { return TotalMetricsStore(store, metrics); }},
+    };
+    for (const style& s : styles) {
+        double median_ms[ShapeMetricCount] = {};
+        for (u32 metrics = 1; metrics <= ShapeMetricCount; ++metrics) {
+            f32 result = 0.0f;
+            bench_stats stats = harness.measure([&] {
+                shape_totals totals = s.totals(metrics);
+                return totals.Area + totals.CornerArea + totals.Perimeter;
+            }, result);
+            std::string name = std::string(s.name) + ", " + std::to_string(metrics) + (metrics > 1 ? " metrics" : " metric");
+            PrintBenchStats(name.c_str(), stats, result);
+            median_ms[metrics - 1] = stats.median_ms;
+        }
+        shape_totals totals = s.totals(ShapeMetricCount);
+        std::cout << "    area = " << totals.Area << ", corner area = " << totals.CornerArea
+                  << ", perimeter = " << totals.Perimeter << "; +corner area "
+                  << (median_ms[1] - median_ms[0]) * 1e6 / count << " ns/shape, +perimeter "
+                  << (median_ms[2] - median_ms[1]) * 1e6 / count << " ns/shape" << std::endl;
+    }
+}
+
+// Five dashboard aggregates as five single-aggregate queries (five reads of
+// the columns) against one fused query (one read); then the same under a
+// filter and grouped by type
+void bench_fused_queries(const ShapeStore& store) {
+    const query_expr aggregates[] = {QueryArea, QueryArea * QueryWeight, QueryOne, QueryWidth, QueryArea * QueryArea};
+
+    harness.run("Query 5 separate passes", [&] {
+        f32 Accum = 0.0f;
+        for (const query_expr& expr : aggregates) {
+            Accum += Query(store).sum(expr).run()(0);
+        }
+        return Accum;
+    });
+    harness.run("Query 5 fused", [&] {
+        ShapeQuery query(store);
+        for (const query_expr& expr : aggregates) {
+            query.sum(expr);
+        }
+        query_result result = query.run();
+        f32 Accum = 0.0f;
+        for (f32 value : result.values) {
+            Accum += value;
+        }
+        return Accum;
+    });
+    harness.run("Query area, filtered", [&] {
+        return Query(store).filter(QueryType != Shape_Circle && QueryArea >= 5.0f).sum(QueryArea).run()(0);
+    });
+    query_result grouped = Query(store).groupByType().sum(QueryArea).sum(QueryArea * QueryWeight).count().run();
+    for (u32 t = 0; t < Shape_Count; ++t) {
+        std::cout << "    type " << t << ": area = " << grouped(0, t) << ", corner area = " << grouped(1, t)
+                  << ", count = " << grouped(2, t) << std::endl;
+    }
+}
+
+// Allocation and traversal of the i % 4 shape mix: one heap object per shape
+// versus the per-type pools of a ShapeArena
+void bench_shape_allocation() {
+    constexpr u32 ROUNDS = 20;
+    std::vector<shape_base*> shapes(N);
+
+    // Each run returns the number of objects it made
+    f32 made = 0.0f;
+    bench_stats heap = harness.measure(ROUNDS, [&] {
+        for (u32 i = 0; i < N; ++i) {
+            switch (i % 4) {
+                case 0: shapes[i] = new square(3.0f); break;
+                case 1: shapes[i] = new rectangle(3.0f, 4.0f); break;
+                case 2: shapes[i] = new triangle(3.0f, 4.0f); break;
+                case 3: shapes[i] = new circle(3.0f); break;
+            }
+        }
+        for (shape_base* shape : shapes) {
+            delete shape;
+        }
+        return f32(N);
+    }, made);
+    PrintBenchStats("Heap new/delete", heap, made);
+
+    ShapeArena& arena = ShapeArena::local();
+    bench_stats pooled = harness.measure(ROUNDS, [&] {
+        arena.reset();
+        for (u32 i = 0; i < N; ++i) {
+            switch (i % 4) {
+                case 0: shapes[i] = arena.make<square>(3.0f); break;
+                case 1: shapes[i] = arena.make<rectangle>(3.0f, 4.0f); break;
+                case 2: shapes[i] = arena.make<triangle>(3.0f, 4.0f); break;
+                case 3: shapes[i] = arena.make<circle>(3.0f); break;
+            }
+        }
+        return f32(arena.size());
+    }, made);
+    PrintBenchStats("Arena make/reset", pooled, made);
+
+    // shapes now holds the last arena batch
+    bench("Arena TotalArea", vtbl_area, N, shapes.data());
+    bench("Arena CornerArea", vtbl_corner, N, shapes.data());
+
+    // Pool objects of one type are contiguous, so the batched type runs
+    // stream memory instead of revisiting the interleaved heap per type
+    ShapeBatches batches(N, shapes.data());
+    bench("Arena Batched TotalArea", batched_area, N, &batches);
+    bench("Arena Batched CornerArea", batched_corner, N, &batches);
+    arena.release();
+}
+
+// Type and dimension distributions for the sweep
+enum shape_mix : u32 {
+    Mix_Periodic,  // i % 4, constant dimensions: the default section's data
+    Mix_Uniform,   // uniformly random types
+    Mix_Skewed,    // 70% squares, 20% rectangles, 7% triangles, 3% circles
+    Mix_Sorted,    // uniformly random types, grouped by type
+    Mix_Single,    // rectangles only
+
+    Mix_Count
+};
+
+static const char* const MixNames[Mix_Count] = {"periodic", "uniform", "skewed", "sorted", "single"};
+
+// Every representation of one sweep configuration. The heap objects are
+// allocated in array order, like the ones of the default section.
+struct sweep_dataset {
+    std::vector<shape_union> flat;
+    std::vector<shape_base*> shapes;
+    CornerCollector collector;  // both collector engines
+    ShapeStore store;
+    std::vector<shape_variant> variants;
+    StaticShapes static_shapes;
+    TypeAggregates aggregates;
+
+    sweep_dataset() { }
+    sweep_dataset(const sweep_dataset&) = delete;
+    sweep_dataset& operator=(const sweep_dataset&) = delete;
+    ~sweep_dataset() {
+        for (shape_base* shape : shapes) {
+            delete shape;
+        }
+    }
+};
+
+static shape_base* NewShape(const shape_union& shape) {
+    switch (shape.Type) {
+        case Shape_Square: return new square(shape.Width);
+        case Shape_Rectangle: return new rectangle(shape.Width, shape.Height);
+        case Shape_Triangle: return new triangle(shape.Width, shape.Height);
+        default: return new circle(shape.Width);
+    }
+}
+
+// Fixed seed, so every run and every engine sees the same shapes
+static void FillDataset(sweep_dataset& data, size_t count, shape_mix mix) {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<f32> dimension(1.0f, 4.0f);
+    std::discrete_distribution<u32> skewed({70.0, 20.0, 7.0, 3.0});
+
+    data.flat.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        shape_type Type;
+        switch (mix) {
+            case Mix_Periodic: Type = shape_type(i % 4); break;
+            case Mix_Skewed: Type = shape_type(skewed(rng)); break;
+            case Mix_Single: Type = Shape_Rectangle; break;
+            default: Type = shape_type(rng() % Shape_Count); break;
+        }
+        f32 Width = mix == Mix_Periodic ? 3.0f : dimension(rng);
+        f32 Height = mix == Mix_Periodic ? 4.0f : dimension(rng);
+        if (!ShapeStore::HasHeight(Type)) {
+            Height = Width;
+        }
+        data.flat[i] = {Type, Width, Height};
+    }
+    if (mix == Mix_Sorted) {
+        std::stable_sort(data.flat.begin(), data.flat.end(),
+                         [](const shape_union& a, const shape_union& b) { return a.Type < b.Type; });
+    }
+
+    // The skewed and single mixes would outgrow an even split of the store
+    size_t type_counts[Shape_Count] = {};
+    for (const shape_union& shape : data.flat) {
+        ++type_counts[shape.Type];
+    }
+    data.shapes.reserve(count);
+    data.store.reserve(type_counts);
+    data.variants.reserve(count);
+    for (const shape_union& shape : data.flat) {
+        data.shapes.push_back(NewShape(shape));
+        data.collector.addShape(data.shapes.back());
+        data.store.add(shape);
+        data.variants.push_back(MakeShapeVariant(shape));
+        AddStaticShape(data.static_shapes, shape);
+        data.aggregates.add(shape);
+    }
+}
+
+// One sweep engine: its TotalArea and CornerArea over a dataset, and the
+// bytes each of them streams
+struct sweep_engine {
+    const char* name;
+    f32 (*total)(sweep_dataset& data);
+    f32 (*corner)(sweep_dataset& data);
+    size_t (*total_bytes)(const sweep_dataset& data);
+    size_t (*corner_bytes)(const sweep_dataset& data);
+};
+
+static size_t ObjectBytes(const sweep_dataset& data) {
+    size_t bytes = data.shapes.size() * sizeof(shape_base*);
+    for (const shape_union& shape : data.flat) {
+        switch (shape.Type) {
+            case Shape_Square: bytes += sizeof(square); break;
+            case Shape_Rectangle: bytes += sizeof(rectangle); break;
+            case Shape_Triangle: bytes += sizeof(triangle); break;
+            default: bytes += sizeof(circle); break;
+        }
+    }
+    return bytes;
+}
+
+static size_t UnionBytes(const sweep_dataset& data) { return data.flat.size() * sizeof(shape_union); }
+static size_t AreaColumnBytes(const sweep_dataset& data) { return data.flat.size() * sizeof(f32); }
+static size_t CornerColumnBytes(const sweep_dataset& data) { return data.flat.size() * 2 * sizeof(f32); }
+
+static size_t VariantBytes(const sweep_dataset& data) { return data.variants.size() * sizeof(shape_variant); }
+
+static size_t StaticBytes(const sweep_dataset& data) {
+    const StaticShapes& set = data.static_shapes;
+    return set.of<static_square>().size() * sizeof(static_square) +
+           set.of<static_rectangle>().size() * sizeof(static_rectangle) +
+           set.of<static_triangle>().size() * sizeof(static_triangle) +
+           set.of<static_circle>().size() * sizeof(static_circle);
+}
+
+static size_t AggregateBytes(const sweep_dataset&) { return Shape_Count * sizeof(double); }
+
+static size_t StoreBytes(const sweep_dataset& data) {
+    size_t bytes = 0;
+    for (u32 t = 0; t < Shape_Count; ++t) {
+        const shape_column& column = data.store.column(t);
+        bytes += (column.Width.size() + column.Height.size()) * sizeof(f32);
+    }
+    return bytes;
+}
+
+static u32 Count(const sweep_dataset& data) { return static_cast<u32>(data.flat.size()); }
+static shape_base** Objects(sweep_dataset& data) { return data.shapes.data(); }
+static shape_union* Unions(sweep_dataset& data) { return data.flat.data(); }
+
+static const sweep_engine SweepEngines[] = {
+    {"vtbl", [](sweep_dataset& d) { return TotalAreaVTBL(Count(d), Objects(d)); },
+     [](sweep_dataset& d) { return CornerAreaVTBL(Count(d), Objects(d)); }, ObjectBytes, ObjectBytes},
+    {"vtbl4", [](sweep_dataset& d) { return TotalAreaVTBL4(Count(d), Objects(d)); },
+     [](sweep_dataset& d) { return CornerAreaVTBL4(Count(d), Objects(d)); }, ObjectBytes, ObjectBytes},
+    {"switch", [](sweep_dataset& d) { return TotalAreaSwitch(Count(d), Unions(d)); },
+     [](sweep_dataset& d) { return CornerAreaSwitch(Count(d), Unions(d)); }, UnionBytes, UnionBytes},
+    {"switch4", [](sweep_dataset& d) { return TotalAreaSwitch4(Count(d), Unions(d)); },
+     [](sweep_dataset& d) { return CornerAreaSwitch4(Count(d), Unions(d)); }, UnionBytes, UnionBytes},
+    {"table", [](sweep_dataset& d) { return TotalAreaUnion(Count(d), Unions(d)); },
+     [](sweep_dataset& d) { return CornerAreaUnion(Count(d), Unions(d)); }, UnionBytes, UnionBytes},
+    {"table4", [](sweep_dataset& d) { return TotalAreaUnion4(Count(d), Unions(d)); },
+     [](sweep_dataset& d) { return CornerAreaUnion4(Count(d), Unions(d)); }, UnionBytes, UnionBytes},
+    {"table_simd", [](sweep_dataset& d) { return TotalAreaUnionSIMD(Count(d), Unions(d)); },
+     [](sweep_dataset& d) { return CornerAreaUnionSIMD(Count(d), Unions(d)); }, UnionBytes, UnionBytes},
+    {"collector", [](sweep_dataset& d) { return TotalAreaCollector(d.collector.areas()); },
+     [](sweep_dataset& d) { return CornerAreaCollector(d.collector); }, AreaColumnBytes, CornerColumnBytes},
+    {"store", [](sweep_dataset& d) { return TotalAreaStore(d.store); },
+     [](sweep_dataset& d) { return CornerAreaStore(d.store); }, StoreBytes, StoreBytes},
+    {"variant", [](sweep_dataset& d) { return TotalAreaVariant(Count(d), d.variants.data()); },
+     [](sweep_dataset& d) { return CornerAreaVariant(Count(d), d.variants.data()); }, VariantBytes, VariantBytes},
+    {"crtp", [](sweep_dataset& d) { return TotalAreaStatic(d.static_shapes); },
+     [](sweep_dataset& d) { return CornerAreaStatic(d.static_shapes); }, StaticBytes, StaticBytes},
+    {"aggregate", [](sweep_dataset& d) { return TotalAreaUnion(d.aggregates); },
+     [](sweep_dataset& d) { return CornerAreaUnion(d.aggregates); }, AggregateBytes, AggregateBytes},
+};
+
+enum sweep_format : u32 { Format_CSV, Format_JSON };
+
+struct bench_config {
+    bench_options options;
+    bool samples_set = false;
+    bool sweep = false;
+    std::vector<size_t> sizes = {1 << 10, 1 << 12, 1 << 14, 1 << 16, 1 << 18, 1 << 20, 1 << 22, 1 << 24};
+    std::vector<shape_mix> mixes = {Mix_Periodic, Mix_Uniform, Mix_Skewed, Mix_Sorted, Mix_Single};
+    std::vector<std::string> engines;  // empty = all
+    sweep_format format = Format_CSV;
+    std::string shape_file;  // empty = temporary file
+    size_t prefetch = DefaultPrefetchDistance;
+    bool tune_prefetch = false;
+    std::string backend = "auto";  // DeviceCollector backend
+    std::string metrics;  // probe export after the run, empty = none
+};
+
+// Splits "a,b,c"
+static std::vector<std::string> SplitList(const char* list) {
+    std::vector<std::string> items;
+    std::string item;
+    for (const char* c = list;; ++c) {
+        if (*c == ',' || *c == 0) {
+            if (!item.empty()) {
+                items.push_back(item);
+            }
+            item.clear();
+            if (*c == 0) {
+                break;
+            }
+        } else {
+            item += *c;
+        }
+    }
+    return items;
+}
+
+// "4096", "64K", "16M", "1G" - binary suffixes
+static bool ParseSize(const std::string& text, size_t& size) {
+    char* end = nullptr;
+    unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+    if (end == text.c_str()) {
+        return false;
+    }
+    switch (*end) {
+        case 0: break;
+        case 'k': case 'K': value <<= 10; ++end; break;
+        case 'm': case 'M': value <<= 20; ++end; break;
+        case 'g': case 'G': value <<= 30; ++end; break;
+        default: return false;
+    }
+    // The engines take u32 counts
+    if (*end != 0 || value == 0 || value > 0xffffffffull) {
+        return false;
+    }
+    size = static_cast<size_t>(value);
+    return true;
+}
+
+static const char* const Usage =
+    " [--warmup=N] [--samples=N] [--pin=CPU] [--counters]"
+    " [--sweep] [--sizes=1K,...,1G] [--mix=periodic,uniform,skewed,sorted,single]"
+    " [--engines=vtbl,...] [--format=csv|json] [--shape-file=PATH] [--prefetch=N] [--tune-prefetch]"
+    " [--backend=auto|cuda|cpu] [--metrics=prometheus|json]"
+    " [--config=FILE]";
+
+static bool ParseArgument(bench_config& config, const std::string& arg);
+
+// One option per line, written without the leading "--"; # starts a comment
+static bool ParseConfigFile(bench_config& config, const char* path) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "cannot open " << path << std::endl;
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (!line.empty() && !ParseArgument(config, "--" + line)) {
+            std::cerr << path << ": invalid option '" << line << "'" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ParseArgument(bench_config& config, const std::string& arg) {
+    size_t eq = arg.find('=');
+    std::string key = arg.substr(0, eq);
+    const char* value = eq == std::string::npos ? "" : arg.c_str() + eq + 1;
+
+    if (key == "--warmup") {
+        config.options.warmup = static_cast<u32>(std::strtoul(value, nullptr, 10));
+    } else if (key == "--samples") {
+        config.options.samples = std::max(1u, static_cast<u32>(std::strtoul(value, nullptr, 10)));
+        config.samples_set = true;
+    } else if (key == "--pin") {
+        config.options.cpu = std::atoi(value);
+    } else if (arg == "--counters") {
+        config.options.counters = true;
+    } else if (arg == "--sweep") {
+        config.sweep = true;
+    } else if (key == "--sizes") {
+        config.sizes.clear();
+        for (const std::string& item : SplitList(value)) {
+            size_t size;
+            if (!ParseSize(item, size)) {
+                return false;
+            }
+            config.sizes.push_back(size);
+        }
+    } else if (key == "--mix") {
+        config.mixes.clear();
+        for (const std::string& item : SplitList(value)) {
+            auto name = std::find(std::begin(MixNames), std::end(MixNames), item);
+            if (name == std::end(MixNames)) {
+                return false;
+            }
+            config.mixes.push_back(shape_mix(name - std::begin(MixNames)));
+        }
+    } else if (key == "--engines") {
+        config.engines = SplitList(value);
+    } else if (key == "--format") {
+        if (std::strcmp(value, "csv") == 0) config.format = Format_CSV;
+        else if (std::strcmp(value, "json") == 0) config.format = Format_JSON;
+        else return false;
+    } else if (key == "--prefetch") {
+        config.prefetch = static_cast<size_t>(std::strtoul(value, nullptr, 10));
+    } else if (arg == "--tune-prefetch") {
+        config.tune_prefetch = true;
+    } else if (key == "--shape-file") {
+        config.shape_file = value;
+    } else if (key == "--backend") {
+        if (std::strcmp(value, "auto") != 0 && std::strcmp(value, "cuda") != 0 && std::strcmp(value, "cpu") != 0) {
+            return false;
+        }
+        config.backend = value;
+    } else if (key == "--metrics") {
+        if (std::strcmp(value, "prometheus") != 0 && std::strcmp(value, "json") != 0) {
+            return false;
+        }
+        config.metrics = value;
+    } else if (key == "--config") {
+        return ParseConfigFile(config, value);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static bench_config ParseBenchConfig(int argc, char** argv) {
+    bench_config config;
+    for (int i = 1; i < argc; ++i) {
+        if (!ParseArgument(config, argv[i])) {
+            std::cerr << "usage: " << argv[0] << Usage << std::endl;
+            std::exit(1);
+        }
+    }
+    return config;
+}
+
+static void PrintSweepRow(const bench_config& config, size_t size, shape_mix mix, const char* engine,
+                          const char* metric, size_t bytes, const bench_stats& stats, f32 result, bool first) {
+    const double ns_per_shape = stats.median_ms * 1e6 / double(size);
+    const bench_counters& c = stats.counters;
+    const double ipc = c.cycles > 0.0 ? c.instructions / c.cycles : 0.0;
+    if (config.format == Format_CSV) {
+        std::cout << size << ',' << MixNames[mix] << ',' << engine << ',' << metric << ',' << bytes << ','
+                  << stats.samples << ',' << stats.median_ms << ',' << stats.p99_ms << ',' << stats.stddev_ms << ','
+                  << ns_per_shape << ',';
+        if (stats.has_counters) {
+            std::cout << c.cycles << ',' << ipc << ',' << c.llc_misses << ',' << c.branch_misses;
+        } else {
+            std::cout << ",,,";
+        }
+        std::cout << ',' << result << std::endl;
+    } else {
+        std::cout << (first ? "  " : ", ") << "{\"size\": " << size << ", \"mix\": \"" << MixNames[mix]
+                  << "\", \"engine\": \"" << engine << "\", \"metric\": \"" << metric << "\", \"bytes\": " << bytes
+                  << ", \"samples\": " << stats.samples << ", \"median_ms\": " << stats.median_ms
+                  << ", \"p99_ms\": " << stats.p99_ms << ", \"stddev_ms\": " << stats.stddev_ms
+                  << ", \"ns_per_shape\": " << ns_per_shape;
+        if (stats.has_counters) {
+            std::cout << ", \"cycles\": " << c.cycles << ", \"ipc\": " << ipc << ", \"llc_misses\": " << c.llc_misses
+                      << ", \"branch_misses\": " << c.branch_misses;
+        }
+        std::cout << ", \"result\": " << result << "}" << std::endl;
+    }
+}
+
+// Every engine over every size x mix. Unless --samples is given, a row takes
+// enough samples to read about 1e8 shapes, between 3 and 1000 of them.
+static void run_sweep(const bench_config& config) {
+    if (config.format == Format_CSV) {
+        std::cout << "size,mix,engine,metric,bytes,samples,median_ms,p99_ms,stddev_ms,ns_per_shape,"
+                     "cycles,ipc,llc_misses,branch_misses,result" << std::endl;
+    } else {
+        std::cout << "[" << std::endl;
+    }
+
+    bool first = true;
+    for (size_t size : config.sizes) {
+        u32 samples = config.samples_set ? config.options.samples
+                                         : static_cast<u32>(std::clamp<size_t>(100000000 / size, 3, 1000));
+        for (shape_mix mix : config.mixes) {
+            std::cerr << "sweep: " << size << " shapes, " << MixNames[mix] << std::endl;
+            sweep_dataset data;
+            FillDataset(data, size, mix);
+
+            for (const sweep_engine& engine : SweepEngines) {
+                if (!config.engines.empty() &&
+                    std::find(config.engines.begin(), config.engines.end(), engine.name) == config.engines.end()) {
+                    continue;
+                }
+                f32 result = 0.0f;
+                bench_stats stats = harness.measure(samples, [&] { return engine.total(data); }, result);
+                PrintSweepRow(config, size, mix, engine.name, "total", engine.total_bytes(data), stats, result, first);
+                first = false;
+                stats = harness.measure(samples, [&] { return engine.corner(data); }, result);
+                PrintSweepRow(config, size, mix, engine.name, "corner", engine.corner_bytes(data), stats, result, first);
+            }
+        }
+    }
+
+    if (config.format == Format_JSON) {
+        std::cout << "]" << std::endl;
+    }
+}
+
+// Probe totals of the whole run; empty in builds without the instrumentation
+static void PrintMetrics(const bench_config& config) {
+    if (config.metrics == "prometheus") {
+        std::cout << MetricsPrometheus();
+    } else if (config.metrics == "json") {
+        std::cout << MetricsJson();
+    }
+}
+
+int main(int argc, char** argv) {
+    bench_config config = ParseBenchConfig(argc, argv);
+    harness.configure(config.options);
+    SetPrefetchDistance(config.prefetch);
+    if (config.sweep) {
+        run_sweep(config);
+        PrintMetrics(config);
+        return 0;
+    }
+
     // Prepare shapes for all versions
-    // Calculate maximum sizeof of all shape classes
-    size_t shape_base_size = sizeof(shape_base);
-    size_t square_size = sizeof(square);
-    size_t rectangle_size = sizeof(rectangle);
-    size_t triangle_size = sizeof(triangle);
-    size_t circle_size = sizeof(circle);
-    size_t shape_union_size = sizeof(shape_union);
-    
-    size_t max_size = std::max({shape_base_size, square_size, rectangle_size, 
-                               triangle_size, circle_size, shape_union_size});
-        
+    // The inline buffer stores one shape per slot of the largest shape size
+    size_t max_size = InlineShapeStride;
+
     std::vector<shape_base*> vtbl_shapes;
     std::vector<shape_union> flat_shapes;
     
@@ -157,9 +1473,9 @@ int main() {
         buffer_ptr += max_size;
     }
     
-    // Create collector instances
-    AreaCollector area_collector;
+    // One collector on the shared area column serves both metrics
     CornerCollector corner_collector;
+    const aligned_vector<f32>& collector_areas = corner_collector.areas();
 
     // Fill vectors with shapes
     for (u32 i = 0; i < N; ++i) {
@@ -181,10 +1497,25 @@ int main() {
                 flat_shapes.push_back({Shape_Circle, 3.0f, 3.0f});
                 break;
         }
-        area_collector.addShape(vtbl_shapes.back());
         corner_collector.addShape(vtbl_shapes.back());
     }
     
+    // Same shapes in columns, plus shape_base views on them for OOP callers
+    ShapeStore shape_store;
+    shape_store.reserve(N);
+    for (const shape_union& shape : flat_shapes) {
+        shape_store.add(shape);
+    }
+    std::vector<shape_view> store_views;
+    std::vector<shape_base*> store_view_ptrs;
+    store_views.reserve(N);
+    for (u32 i = 0; i < N; ++i) {
+        store_views.push_back(shape_store.view(i));
+    }
+    for (shape_view& view : store_views) {
+        store_view_ptrs.push_back(&view);
+    }
+
     // Get raw pointers for benchmarking
     shape_base** vtbl_ptrs = vtbl_shapes.data();
     shape_union* flat_ptrs = flat_shapes.data();
@@ -197,9 +1528,90 @@ int main() {
     bench("CornerArea", vtbl_corner, N, vtbl_ptrs);
     bench("CornerArea4", vtbl_corner4, N, vtbl_ptrs);
 
+    std::cout << "=== Clean Code, batched by type ===" << std::endl;
+    auto batch_start = std::chrono::high_resolution_clock::now();
+    ShapeBatches batches(N, vtbl_ptrs);
+    auto batch_end = std::chrono::high_resolution_clock::now();
+    std::cout << "Batch grouping: " << std::chrono::duration<double, std::milli>(batch_end - batch_start).count()
+              << " ms (once), " << batches.runs.size() << " type runs" << std::endl;
+    bench("Batched TotalArea", batched_area, N, &batches);
+    bench("Batched CornerArea", batched_corner, N, &batches);
+
+    std::cout << "=== Clean Code, inline buffer ===" << std::endl;
+    bench("OptVTBL TotalArea", optvtbl_area, N, buffer.data());
+    bench("OptVTBL TotalArea4", optvtbl_area4, N, buffer.data());
+    bench("OptVTBL CornerArea", optvtbl_corner, N, buffer.data());
+    bench("OptVTBL CornerArea4", optvtbl_corner4, N, buffer.data());
+
     std::cout << "=== Clean Code with Collectors ===" << std::endl;
-    bench_total_collector("TotalAreaCollector", TotalAreaCollector, area_collector);
+    std::cout << "Collector storage: " << CollectorBytes(corner_collector) / double(1 << 20)
+              << " MB, area column shared by both engines" << std::endl;
+    bench_total_collector("TotalAreaCollector", TotalAreaCollector, collector_areas);
     bench_corner_collector("CornerCollector", corner_collector);
+    // Perimeter column attached for one query and dropped again
+    corner_collector.attachPerimeters(N, vtbl_ptrs);
+    harness.run("TotalPerimeterCollector", [&] { return TotalPerimeterCollector(corner_collector); });
+    corner_collector.dropPerimeters();
+
+    std::cout << "=== Shape Allocation ===" << std::endl;
+    bench_shape_allocation();
+
+    std::cout << "=== Live Collectors ===" << std::endl;
+    bench_live_collectors(vtbl_shapes);
+
+    std::cout << "=== Concurrent Ingest ===" << std::endl;
+    bench_concurrent_ingest(vtbl_shapes);
+
+    std::cout << "=== Alignment and Prefetch ===" << std::endl;
+    bench_alignment_prefetch(corner_collector, config.tune_prefetch);
+
+    std::cout << "=== SIMD Variants ===" << std::endl;
+    bench_simd_variants(collector_areas, corner_collector, flat_shapes);
+
+    std::cout << "=== Compact Columns ===" << std::endl;
+    bench_compact_columns(corner_collector);
+
+    std::cout << "=== Accumulation Policies ===" << std::endl;
+    bench_accum_policies(collector_areas, corner_collector);
+
+    std::cout << "=== Parallel Collectors ===" << std::endl;
+    bench_parallel_collectors(collector_areas, corner_collector);
+
+    std::cout << "=== Async Reductions ===" << std::endl;
+    bench_async_reductions(collector_areas, corner_collector);
+
+    std::cout << "=== NUMA Collectors ===" << std::endl;
+    bench_numa_collectors(vtbl_shapes);
+
+    std::cout << "=== Variant and CRTP ===" << std::endl;
+    bench_static_dispatch(flat_shapes, vtbl_shapes);
+
+    std::cout << "=== Shape Store (SoA) ===" << std::endl;
+    bench("Store TotalArea", store_area, N, &shape_store);
+    bench("Store CornerArea", store_corner, N, &shape_store);
+    bench("Store views TotalArea", vtbl_area, N, store_view_ptrs.data());
+    bench("Store views CornerArea", vtbl_corner, N, store_view_ptrs.data());
+
+    std::cout << "=== Bulk Ingest ===" << std::endl;
+    bench_bulk_ingest(vtbl_shapes, batches, shape_store);
+
+    std::cout << "=== Mapped Shape File ===" << std::endl;
+    bench_shape_file(shape_store, config.shape_file);
+
+    std::cout << "=== Device Collectors ===" << std::endl;
+    bench_device_collectors(corner_collector, shape_store, config.backend);
+
+    std::cout << "=== Shape Metrics ===" << std::endl;
+    bench_shape_metrics(vtbl_shapes, flat_shapes, shape_store);
+
+    std::cout << "=== Fused Queries ===" << std::endl;
+    bench_fused_queries(shape_store);
+
+    std::cout << "=== Per-type Aggregates ===" << std::endl;
+    bench_type_aggregates(flat_shapes);
+
+    std::cout << "=== Adaptive Engine Selection ===" << std::endl;
+    bench_adaptive_engines(flat_shapes);
 
     std::cout << "=== Switch statement ===" << std::endl;
     bench("Switch TotalArea", switch_area, N, flat_ptrs);
@@ -207,11 +1619,36 @@ int main() {
     bench("Switch CornerArea", switch_corner, N, flat_ptrs);
     bench("Switch CornerArea4", switch_corner4, N, flat_ptrs);
 
+    std::cout << "=== Unroll factors (odd count " << N - 3 << ") ===" << std::endl;
+    bench("TotalArea8", vtbl_kernel<TotalAreaVTBL8>, N - 3, vtbl_ptrs);
+    bench("TotalArea16", vtbl_kernel<TotalAreaVTBL16>, N - 3, vtbl_ptrs);
+    bench("CornerArea8", vtbl_kernel<CornerAreaVTBL8>, N - 3, vtbl_ptrs);
+    bench("CornerArea16", vtbl_kernel<CornerAreaVTBL16>, N - 3, vtbl_ptrs);
+    bench("Switch TotalArea8", union_kernel<TotalAreaSwitch8>, N - 3, flat_ptrs);
+    bench("Switch TotalArea16", union_kernel<TotalAreaSwitch16>, N - 3, flat_ptrs);
+    bench("Switch CornerArea8", union_kernel<CornerAreaSwitch8>, N - 3, flat_ptrs);
+    bench("Switch CornerArea16", union_kernel<CornerAreaSwitch16>, N - 3, flat_ptrs);
+    bench("Table TotalArea8", union_kernel<TotalAreaUnion8>, N - 3, flat_ptrs);
+    bench("Table TotalArea16", union_kernel<TotalAreaUnion16>, N - 3, flat_ptrs);
+    bench("Table CornerArea8", union_kernel<CornerAreaUnion8>, N - 3, flat_ptrs);
+    bench("Table CornerArea16", union_kernel<CornerAreaUnion16>, N - 3, flat_ptrs);
+    bench("Table TotalAreaSIMD", union_kernel<TotalAreaUnionSIMD>, N - 3, flat_ptrs);
+
     std::cout << "=== Table-driven ===" << std::endl;
     bench("Table TotalArea", table_area, N, flat_ptrs);
     bench("Table TotalArea4", table_area4, N, flat_ptrs);
     bench("Table CornerArea", table_corner, N, flat_ptrs);
     bench("Table CornerArea4", table_corner4, N, flat_ptrs);
+    bench("Table TotalAreaSIMD", table_area_simd, N, flat_ptrs);
+    bench("Table CornerAreaSIMD", table_corner_simd, N, flat_ptrs);
+
+    std::cout << "=== Instrumentation ===" << std::endl;
+    bench_instrumentation(flat_shapes);
+
+    if (!config.metrics.empty()) {
+        std::cout << "=== Metrics ===" << std::endl;
+        PrintMetrics(config);
+    }
 
     // Cleanup
     for (auto ptr : vtbl_shapes) {
@@ -0,0 +1,187 @@
+#include "bench_harness.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+// Counts user space only, so the default perf_event_paranoid level allows it
+static int OpenCounter(u32 type, std::uint64_t config, int group) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group < 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+}
+#endif
+
+PerfCounters::PerfCounters() {
+    std::fill(std::begin(fds), std::end(fds), -1);
+#if defined(__linux__)
+    static const std::uint64_t Events[4] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int i = 0; i < 4; ++i) {
+        fds[i] = OpenCounter(PERF_TYPE_HARDWARE, Events[i], fds[0]);
+        if (fds[i] < 0) {
+            // All or nothing: a partial group would report misleading ratios
+            for (int k = 0; k < i; ++k) {
+                close(fds[k]);
+                fds[k] = -1;
+            }
+            return;
+        }
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#if defined(__linux__)
+    for (int fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+void PerfCounters::start() {
+#if defined(__linux__)
+    ioctl(fds[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+bench_counters PerfCounters::stop() {
+    bench_counters totals;
+#if defined(__linux__)
+    ioctl(fds[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    struct {
+        std::uint64_t count;
+        std::uint64_t values[4];
+    } group;
+    if (read(fds[0], &group, sizeof(group)) == ssize_t(sizeof(group)) && group.count == 4) {
+        totals.cycles = double(group.values[0]);
+        totals.instructions = double(group.values[1]);
+        totals.llc_misses = double(group.values[2]);
+        totals.branch_misses = double(group.values[3]);
+    }
+#endif
+    return totals;
+}
+
+#if defined(__linux__)
+static cpu_set_t OriginalAffinity;
+static bool HasOriginalAffinity = false;
+#endif
+
+bool PinToCpu(int cpu) {
+#if defined(__linux__)
+    if (!HasOriginalAffinity) {
+        if (sched_getaffinity(0, sizeof(OriginalAffinity), &OriginalAffinity) != 0) {
+            return false;
+        }
+        HasOriginalAffinity = true;
+    }
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+void UnpinThread() {
+#if defined(__linux__)
+    if (HasOriginalAffinity) {
+        sched_setaffinity(0, sizeof(OriginalAffinity), &OriginalAffinity);
+    }
+#endif
+}
+
+bench_stats ComputeBenchStats(std::vector<double>& samples_ms) {
+    bench_stats stats;
+    const size_t count = samples_ms.size();
+    stats.samples = static_cast<u32>(count);
+    if (count == 0) {
+        return stats;
+    }
+
+    std::sort(samples_ms.begin(), samples_ms.end());
+    stats.min_ms = samples_ms.front();
+    stats.median_ms = count % 2 ? samples_ms[count / 2]
+                                : 0.5 * (samples_ms[count / 2 - 1] + samples_ms[count / 2]);
+    size_t p99 = (count * 99 + 99) / 100;
+    stats.p99_ms = samples_ms[std::min(count, std::max<size_t>(p99, 1)) - 1];
+
+    // Median absolute deviation, scaled to estimate the standard deviation of
+    // normally distributed samples. Interrupts and page faults only ever make
+    // a sample slower, so only the upper side is rejected.
+    std::vector<double> deviations(count);
+    for (size_t i = 0; i < count; ++i) {
+        deviations[i] = std::fabs(samples_ms[i] - stats.median_ms);
+    }
+    std::nth_element(deviations.begin(), deviations.begin() + count / 2, deviations.end());
+    const double mad = deviations[count / 2];
+    const double limit = stats.median_ms + 3.0 * 1.4826 * mad;
+
+    double sum = 0.0, sum_squares = 0.0;
+    size_t kept = 0;
+    for (double sample : samples_ms) {
+        if (mad > 0.0 && sample > limit) {
+            continue;
+        }
+        sum += sample;
+        sum_squares += sample * sample;
+        ++kept;
+    }
+    stats.outliers = static_cast<u32>(count - kept);
+    stats.mean_ms = sum / kept;
+    stats.stddev_ms = kept > 1 ? std::sqrt(std::max(0.0, (sum_squares - sum * stats.mean_ms) / (kept - 1))) : 0.0;
+    return stats;
+}
+
+void PrintBenchStats(const char* name, const bench_stats& stats, f32 result) {
+    std::cout << name << ": median " << stats.median_ms << " ms, mean " << stats.mean_ms
+              << " ms, p99 " << stats.p99_ms << " ms, stddev " << stats.stddev_ms << " ms ("
+              << stats.samples << " runs, " << stats.outliers << " outliers), result = " << result << std::endl;
+    if (stats.has_counters) {
+        const bench_counters& c = stats.counters;
+        std::cout << "    per run: " << c.cycles << " cycles, IPC "
+                  << (c.cycles > 0.0 ? c.instructions / c.cycles : 0.0) << ", " << c.llc_misses
+                  << " LLC misses, " << c.branch_misses << " branch misses" << std::endl;
+    }
+}
+
+void BenchHarness::configure(const bench_options& options) {
+    opts = options;
+    if (opts.cpu >= 0 && !PinToCpu(opts.cpu)) {
+        std::cerr << "warning: cannot pin to CPU " << opts.cpu << std::endl;
+        opts.cpu = -1;
+    }
+    counters.reset();
+    if (opts.counters) {
+        counters.reset(new PerfCounters());
+        if (!counters->available()) {
+            std::cerr << "warning: hardware counters unavailable (perf_event_open failed)" << std::endl;
+            opts.counters = false;
+        }
+    }
+}
@@ -1,8 +1,14 @@
 #include "shapes.h"
+#include "instrumentation.h"
+#include "accum.h"
+#include "shape_batches.h"
+#include <typeindex>
+#include <unordered_map>
 
 
 // OOP area sum
 f32 TotalAreaVTBL(u32 ShapeCount, shape_base **Shapes) {
+    INSTRUMENT_SCOPE("TotalAreaVTBL", ShapeCount, ShapeCount * sizeof(shape_base*));
     f32 Accum = 0.0f;
     for (u32 i = 0; i < ShapeCount; ++i) {
         Accum += Shapes[i]->Area();
@@ -10,21 +16,28 @@ f32 TotalAreaVTBL(u32 ShapeCount, shape_base **Shapes) {
     return Accum;
 }
 
+// Unrolled variants: K independent chains, any ShapeCount
+template <u32 K>
+static f32 TotalAreaVTBLK(u32 ShapeCount, shape_base **Shapes) {
+    return Accum<K>::Sum(ShapeCount, [Shapes](u32 i) { return Shapes[i]->Area(); });
+}
+
 f32 TotalAreaVTBL4(u32 ShapeCount, shape_base **Shapes) {
-    f32 Accum0 = 0.0f, Accum1 = 0.0f, Accum2 = 0.0f, Accum3 = 0.0f;
-    u32 Count = ShapeCount / 4;
-    while (Count--) {
-        Accum0 += Shapes[0]->Area();
-        Accum1 += Shapes[1]->Area();
-        Accum2 += Shapes[2]->Area();
-        Accum3 += Shapes[3]->Area();
-        Shapes += 4;
-    }
-    return Accum0 + Accum1 + Accum2 + Accum3;
+    INSTRUMENT_SCOPE("TotalAreaVTBL4", ShapeCount, ShapeCount * sizeof(shape_base*));
+    return TotalAreaVTBLK<4>(ShapeCount, Shapes);
+}
+f32 TotalAreaVTBL8(u32 ShapeCount, shape_base **Shapes) {
+    INSTRUMENT_SCOPE("TotalAreaVTBL8", ShapeCount, ShapeCount * sizeof(shape_base*));
+    return TotalAreaVTBLK<8>(ShapeCount, Shapes);
+}
+f32 TotalAreaVTBL16(u32 ShapeCount, shape_base **Shapes) {
+    INSTRUMENT_SCOPE("TotalAreaVTBL16", ShapeCount, ShapeCount * sizeof(shape_base*));
+    return TotalAreaVTBLK<16>(ShapeCount, Shapes);
 }
 
 // OOP corner-weighted area sum
 f32 CornerAreaVTBL(u32 ShapeCount, shape_base **Shapes) {
+    INSTRUMENT_SCOPE("CornerAreaVTBL", ShapeCount, ShapeCount * sizeof(shape_base*));
     f32 Accum = 0.0f;
     for (u32 i = 0; i < ShapeCount; ++i) {
         Accum += (1.0f / (1.0f + (f32)Shapes[i]->CornerCount())) * Shapes[i]->Area();
@@ -32,15 +45,97 @@ f32 CornerAreaVTBL(u32 ShapeCount, shape_base **Shapes) {
     return Accum;
 }
 
+template <u32 K>
+static f32 CornerAreaVTBLK(u32 ShapeCount, shape_base **Shapes) {
+    return Accum<K>::Sum(ShapeCount, [Shapes](u32 i) {
+        return (1.0f / (1.0f + (f32)Shapes[i]->CornerCount())) * Shapes[i]->Area();
+    });
+}
+
 f32 CornerAreaVTBL4(u32 ShapeCount, shape_base **Shapes) {
-    f32 Accum0 = 0.0f, Accum1 = 0.0f, Accum2 = 0.0f, Accum3 = 0.0f;
-    u32 Count = ShapeCount / 4;
-    while (Count--) {
-        Accum0 += (1.0f / (1.0f + (f32)Shapes[0]->CornerCount())) * Shapes[0]->Area();
-        Accum1 += (1.0f / (1.0f + (f32)Shapes[1]->CornerCount())) * Shapes[1]->Area();
-        Accum2 += (1.0f / (1.0f + (f32)Shapes[2]->CornerCount())) * Shapes[2]->Area();
-        Accum3 += (1.0f / (1.0f + (f32)Shapes[3]->CornerCount())) * Shapes[3]->Area();
-        Shapes += 4;
-    }
-    return Accum0 + Accum1 + Accum2 + Accum3;
+    INSTRUMENT_SCOPE("CornerAreaVTBL4", ShapeCount, ShapeCount * sizeof(shape_base*));
+    return CornerAreaVTBLK<4>(ShapeCount, Shapes);
+}
+f32 CornerAreaVTBL8(u32 ShapeCount, shape_base **Shapes) {
+    INSTRUMENT_SCOPE("CornerAreaVTBL8", ShapeCount, ShapeCount * sizeof(shape_base*));
+    return CornerAreaVTBLK<8>(ShapeCount, Shapes);
+}
+f32 CornerAreaVTBL16(u32 ShapeCount, shape_base **Shapes) {
+    INSTRUMENT_SCOPE("CornerAreaVTBL16", ShapeCount, ShapeCount * sizeof(shape_base*));
+    return CornerAreaVTBLK<16>(ShapeCount, Shapes);
+}
+
+// One pass over the first Metrics of area, corner area and perimeter; each
+// extra metric is one more virtual call per shape
+template <u32 Metrics>
+static shape_totals TotalMetricsVTBLK(u32 ShapeCount, shape_base **Shapes) {
+    shape_totals Totals;
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        f32 Area = Shapes[i]->Area();
+        Totals.Area += Area;
+        if (Metrics > 1) {
+            Totals.CornerArea += (1.0f / (1.0f + (f32)Shapes[i]->CornerCount())) * Area;
+        }
+        if (Metrics > 2) {
+            Totals.Perimeter += Shapes[i]->Perimeter();
+        }
+    }
+    return Totals;
+}
+
+shape_totals TotalMetricsVTBL(u32 ShapeCount, shape_base **Shapes, u32 Metrics) {
+    INSTRUMENT_SCOPE("TotalMetricsVTBL", ShapeCount, ShapeCount * sizeof(shape_base*));
+    switch (Metrics) {
+        case 1: return TotalMetricsVTBLK<1>(ShapeCount, Shapes);
+        case 2: return TotalMetricsVTBLK<2>(ShapeCount, Shapes);
+        default: return TotalMetricsVTBLK<3>(ShapeCount, Shapes);
+    }
+}
+
+// Group pointers by dynamic type, keeping the input order within a type
+ShapeBatches::ShapeBatches(u32 ShapeCount, shape_base** Shapes) {
+    std::unordered_map<std::type_index, u32> type_runs;
+    std::vector<u32> run_of_shape(ShapeCount);
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        auto inserted = type_runs.emplace(std::type_index(typeid(*Shapes[i])), static_cast<u32>(runs.size()));
+        if (inserted.second) {
+            runs.push_back({0, 0});
+        }
+        run_of_shape[i] = inserted.first->second;
+        ++runs[run_of_shape[i]].Count;
+    }
+
+    u32 Begin = 0;
+    for (run& r : runs) {
+        r.Begin = Begin;
+        Begin += r.Count;
+    }
+
+    std::vector<u32> fill(runs.size(), 0);
+    shapes.resize(ShapeCount);
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        u32 r = run_of_shape[i];
+        shapes[runs[r].Begin + fill[r]++] = Shapes[i];
+    }
+}
+
+// One virtual call per type run
+f32 TotalAreaBatched(ShapeBatches& Batches) {
+    INSTRUMENT_SCOPE("TotalAreaBatched", Batches.shapes.size(), Batches.shapes.size() * sizeof(shape_base*));
+    f32 Accum = 0.0f;
+    for (const ShapeBatches::run& r : Batches.runs) {
+        shape_base** Run = Batches.shapes.data() + r.Begin;
+        Accum += Run[0]->AreaBatch(r.Count, Run);
+    }
+    return Accum;
+}
+
+f32 CornerAreaBatched(ShapeBatches& Batches) {
+    INSTRUMENT_SCOPE("CornerAreaBatched", Batches.shapes.size(), Batches.shapes.size() * sizeof(shape_base*));
+    f32 Accum = 0.0f;
+    for (const ShapeBatches::run& r : Batches.runs) {
+        shape_base** Run = Batches.shapes.data() + r.Begin;
+        Accum += Run[0]->CornerAreaBatch(r.Count, Run);
+    }
+    return Accum;
 }
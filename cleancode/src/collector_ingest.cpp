@@ -0,0 +1,198 @@
+#include "shapes.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include <cmath>
+#include <typeinfo>
+#include "shape_store.h"
+#include "thread_pool.h"
+
+// Shapes per parallel work item of the bulk ingest; every item writes its
+// own disjoint range of the columns
+constexpr size_t IngestChunkSize = 32 * 1024;
+
+// Runs fill(begin, end) over [0, count), in chunks on the pool if one is given
+template <class Fill>
+static void FillRanges(size_t count, ThreadPool* pool, const Fill& fill) {
+    if (!pool || count <= IngestChunkSize) {
+        fill(0, count);
+        return;
+    }
+    const size_t chunks = (count + IngestChunkSize - 1) / IngestChunkSize;
+    pool->parallelFor(chunks, [&](size_t chunk) {
+        size_t begin = chunk * IngestChunkSize;
+        fill(begin, std::min(begin + IngestChunkSize, count));
+    });
+}
+
+// Splits [begin, end) into runs of one dynamic type and hands each run to
+// the batch hook of its first shape. type_info objects are unique per type
+// within the binary, so comparing their addresses is enough and avoids the
+// name comparison of type_info::operator==.
+static void CollectRange(shape_base** Shapes, size_t begin, size_t end, f32* Areas, u8* CornerCounts) {
+    size_t i = begin;
+    while (i < end) {
+        const std::type_info* type = &typeid(*Shapes[i]);
+        size_t run_end = i + 1;
+        while (run_end < end && &typeid(*Shapes[run_end]) == type) {
+            ++run_end;
+        }
+        Shapes[i]->CollectBatch(static_cast<u32>(run_end - i), Shapes + i, Areas + i,
+                                CornerCounts ? CornerCounts + i : nullptr);
+        i = run_end;
+    }
+}
+
+// The store is already grouped by type, so every value is a table lookup and
+// a load from the shape's type column, without any dispatch
+static void CollectRange(const ShapeStore& store, size_t begin, size_t end, f32* Areas, u8* CornerCounts) {
+    const f32* width[Shape_Count];
+    const f32* height[Shape_Count];
+    for (u32 t = 0; t < Shape_Count; ++t) {
+        width[t] = store.column(t).Width.data();
+        height[t] = ShapeStore::HasHeight(static_cast<shape_type>(t)) ? store.column(t).Height.data() : width[t];
+    }
+    for (size_t i = begin; i < end; ++i) {
+        u32 t = store.types()[i];
+        u32 slot = store.slots()[i];
+        Areas[i] = ShapeAreaCoefficients[t] * width[t][slot] * height[t][slot];
+    }
+    if (CornerCounts) {
+        for (size_t i = begin; i < end; ++i) {
+            CornerCounts[i] = static_cast<u8>(ShapeCornerCounts[store.types()[i]]);
+        }
+    }
+}
+
+// Perimeters of [begin, end): one virtual call per shape, or the store's
+// coefficient tables and type columns
+static void PerimeterRange(shape_base** Shapes, size_t begin, size_t end, f32* Perimeters) {
+    for (size_t i = begin; i < end; ++i) {
+        Perimeters[i] = Shapes[i]->Perimeter();
+    }
+}
+
+static void PerimeterRange(const ShapeStore& store, size_t begin, size_t end, f32* Perimeters) {
+    for (size_t i = begin; i < end; ++i) {
+        u32 t = store.types()[i];
+        u32 slot = store.slots()[i];
+        f32 width = store.column(t).Width[slot];
+        f32 height = ShapeStore::HasHeight(static_cast<shape_type>(t)) ? store.column(t).Height[slot] : width;
+        f32 diagonal = ShapeDiagonalCoefficients[t] != 0.0f ? std::sqrt(width * width + height * height) : 0.0f;
+        Perimeters[i] = ShapePerimeterCoefficients[t] * (width + height) + ShapeDiagonalCoefficients[t] * diagonal;
+    }
+}
+
+void CollectShapes(u32 ShapeCount, shape_base** Shapes, f32* Areas, u8* CornerCounts) {
+    CollectRange(Shapes, 0, ShapeCount, Areas, CornerCounts);
+}
+
+// Grows the columns by count entries in one step and fills the new range
+template <class Source>
+static void Ingest(const Source& source, size_t count, aligned_vector<f32>& areas, std::vector<u8>* corner_counts,
+                   ThreadPool* pool) {
+    size_t base = areas.size();
+    areas.resize(base + count);
+    f32* Areas = areas.data() + base;
+    u8* CornerCounts = nullptr;
+    if (corner_counts) {
+        corner_counts->resize(base + count);
+        CornerCounts = corner_counts->data() + base;
+    }
+    FillRanges(count, pool, [&](size_t begin, size_t end) { CollectRange(source, begin, end, Areas, CornerCounts); });
+}
+
+// Appends the perimeters of the last count shapes of source
+template <class Source>
+static void ExtendPerimeters(const Source& source, size_t count, aligned_vector<f32>& perimeters,
+                             ThreadPool* pool) {
+    size_t base = perimeters.size();
+    perimeters.resize(base + count);
+    f32* Perimeters = perimeters.data() + base;
+    FillRanges(count, pool, [&](size_t begin, size_t end) { PerimeterRange(source, begin, end, Perimeters); });
+}
+
+void AreaCollector::extendPerimeters(size_t count, shape_base** Shapes, ThreadPool* pool) {
+    if (perimeters_attached) {
+        ExtendPerimeters(Shapes, count, perimeter_column, pool);
+    }
+}
+
+void AreaCollector::extendPerimeters(const ShapeStore& store, ThreadPool* pool) {
+    if (perimeters_attached) {
+        ExtendPerimeters(store, store.size(), perimeter_column, pool);
+    }
+}
+
+bool AreaCollector::attachPerimeters(u32 ShapeCount, shape_base** Shapes) {
+    INSTRUMENT_SCOPE("AreaCollector::attachPerimeters", ShapeCount, ShapeCount * sizeof(shape_base*));
+    if (ShapeCount != area_column.size()) {
+        return false;
+    }
+    perimeter_column.clear();
+    ExtendPerimeters(Shapes, ShapeCount, perimeter_column, nullptr);
+    perimeters_attached = true;
+    return true;
+}
+
+bool AreaCollector::attachPerimeters(const ShapeStore& store) {
+    INSTRUMENT_SCOPE("AreaCollector::attachPerimeters/store", store.size(), store.size() * 2 * sizeof(f32));
+    if (store.size() != area_column.size()) {
+        return false;
+    }
+    perimeter_column.clear();
+    ExtendPerimeters(store, store.size(), perimeter_column, nullptr);
+    perimeters_attached = true;
+    return true;
+}
+
+void AreaCollector::addShapes(u32 ShapeCount, shape_base** Shapes) {
+    INSTRUMENT_SCOPE("AreaCollector::addShapes", ShapeCount, ShapeCount * sizeof(shape_base*));
+    Ingest(Shapes, ShapeCount, area_column, nullptr, nullptr);
+    extendPerimeters(ShapeCount, Shapes, nullptr);
+}
+
+void AreaCollector::addShapes(u32 ShapeCount, shape_base** Shapes, ThreadPool& pool) {
+    INSTRUMENT_SCOPE("AreaCollector::addShapes/pool", ShapeCount, ShapeCount * sizeof(shape_base*));
+    Ingest(Shapes, ShapeCount, area_column, nullptr, &pool);
+    extendPerimeters(ShapeCount, Shapes, &pool);
+}
+
+void AreaCollector::addShapes(const ShapeStore& store) {
+    INSTRUMENT_SCOPE("AreaCollector::addShapes/store", store.size(), store.size() * 2 * sizeof(f32));
+    Ingest(store, store.size(), area_column, nullptr, nullptr);
+    extendPerimeters(store, nullptr);
+}
+
+void AreaCollector::addShapes(const ShapeStore& store, ThreadPool& pool) {
+    INSTRUMENT_SCOPE("AreaCollector::addShapes/store/pool", store.size(), store.size() * 2 * sizeof(f32));
+    Ingest(store, store.size(), area_column, nullptr, &pool);
+    extendPerimeters(store, &pool);
+}
+
+void CornerCollector::addShapes(u32 ShapeCount, shape_base** Shapes) {
+    INSTRUMENT_SCOPE("CornerCollector::addShapes", ShapeCount, ShapeCount * sizeof(shape_base*));
+    Ingest(Shapes, ShapeCount, area_column, &corner_counts, nullptr);
+    extendPerimeters(ShapeCount, Shapes, nullptr);
+    extendWeights();
+}
+
+void CornerCollector::addShapes(u32 ShapeCount, shape_base** Shapes, ThreadPool& pool) {
+    INSTRUMENT_SCOPE("CornerCollector::addShapes/pool", ShapeCount, ShapeCount * sizeof(shape_base*));
+    Ingest(Shapes, ShapeCount, area_column, &corner_counts, &pool);
+    extendPerimeters(ShapeCount, Shapes, &pool);
+    extendWeights();
+}
+
+void CornerCollector::addShapes(const ShapeStore& store) {
+    INSTRUMENT_SCOPE("CornerCollector::addShapes/store", store.size(), store.size() * 2 * sizeof(f32));
+    Ingest(store, store.size(), area_column, &corner_counts, nullptr);
+    extendPerimeters(store, nullptr);
+    extendWeights();
+}
+
+void CornerCollector::addShapes(const ShapeStore& store, ThreadPool& pool) {
+    INSTRUMENT_SCOPE("CornerCollector::addShapes/store/pool", store.size(), store.size() * 2 * sizeof(f32));
+    Ingest(store, store.size(), area_column, &corner_counts, &pool);
+    extendPerimeters(store, &pool);
+    extendWeights();
+}
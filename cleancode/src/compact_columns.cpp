@@ -0,0 +1,162 @@
+#include "compact_columns.h"
+#include "instrumentation.h"
+#include <cstring>
+
+static u32 FloatBits(f32 value) {
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static f32 BitsFloat(u32 bits) {
+    f32 value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+u16 FloatToHalf(f32 value) {
+    u32 bits = FloatBits(value);
+    u32 sign = (bits >> 16) & 0x8000u;
+    u32 exponent = (bits >> 23) & 0xffu;
+    u32 mantissa = bits & 0x7fffffu;
+
+    if (exponent == 0xffu) {
+        // Infinity stays infinity, NaN stays a quiet NaN
+        return static_cast<u16>(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+    }
+    int half_exponent = int(exponent) - 127 + 15;
+    if (half_exponent >= 31) {
+        return static_cast<u16>(sign | 0x7c00u);
+    }
+    if (half_exponent <= 0) {
+        // Subnormal half, or zero below half the smallest one
+        if (half_exponent < -10) {
+            return static_cast<u16>(sign);
+        }
+        mantissa |= 0x800000u;
+        u32 shift = u32(14 - half_exponent);
+        u32 half = mantissa >> shift;
+        u32 rest = mantissa & ((1u << shift) - 1);
+        u32 halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1u))) {
+            ++half;
+        }
+        return static_cast<u16>(sign | half);
+    }
+    u32 half = (u32(half_exponent) << 10) | (mantissa >> 13);
+    u32 rest = mantissa & 0x1fffu;
+    // A carry out of the significand correctly bumps the exponent
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1u))) {
+        ++half;
+    }
+    return static_cast<u16>(sign | half);
+}
+
+f32 HalfToFloat(u16 value) {
+    u32 sign = u32(value & 0x8000u) << 16;
+    u32 exponent = (value >> 10) & 0x1fu;
+    u32 mantissa = value & 0x3ffu;
+    if (exponent == 0x1fu) {
+        return BitsFloat(sign | 0x7f800000u | (mantissa << 13));
+    }
+    if (exponent == 0) {
+        // Zero or subnormal: mantissa * 2^-24
+        f32 magnitude = f32(mantissa) * (1.0f / 16777216.0f);
+        return sign ? -magnitude : magnitude;
+    }
+    return BitsFloat(sign | ((exponent + 127 - 15) << 23) | (mantissa << 13));
+}
+
+u16 FloatToBFloat16(f32 value) {
+    u32 bits = FloatBits(value);
+    if ((bits & 0x7fffffffu) > 0x7f800000u) {
+        return static_cast<u16>((bits >> 16) | 0x40u);
+    }
+    bits += 0x7fffu + ((bits >> 16) & 1u);
+    return static_cast<u16>(bits >> 16);
+}
+
+f32 BFloat16ToFloat(u16 value) {
+    return BitsFloat(u32(value) << 16);
+}
+
+bool CompactCornerCollector::encode(const CornerCollector& collector, column_encoding encoding) {
+    float_areas.clear();
+    half_areas.clear();
+    weight_index.clear();
+    Encoding = encoding;
+
+    // Distinct corner counts in order of appearance, one weight each; the
+    // byte column is read instead of the f32 weights
+    const std::vector<u8>& corner_counts = collector.cornerCounts();
+    u8 lut_counts[CompactWeightLutSize];
+    u32 lut_size = 0;
+    weight_index.resize(corner_counts.size());
+    for (size_t i = 0; i < corner_counts.size(); ++i) {
+        u32 index = 0;
+        while (index < lut_size && lut_counts[index] != corner_counts[i]) {
+            ++index;
+        }
+        if (index == lut_size) {
+            if (lut_size == CompactWeightLutSize) {
+                weight_index.clear();
+                return false;
+            }
+            lut_counts[lut_size] = corner_counts[i];
+            weight_lut[lut_size++] = CornerWeight(corner_counts[i]);
+        }
+        weight_index[i] = static_cast<u8>(index);
+    }
+    for (u32 index = lut_size; index < CompactWeightLutSize; ++index) {
+        weight_lut[index] = 0.0f;
+    }
+
+    const aligned_vector<f32>& areas = collector.areas();
+    switch (encoding) {
+        case Encoding_F16:
+            half_areas.resize(areas.size());
+            for (size_t i = 0; i < areas.size(); ++i) {
+                half_areas[i] = FloatToHalf(areas[i]);
+            }
+            break;
+        case Encoding_BF16:
+            half_areas.resize(areas.size());
+            for (size_t i = 0; i < areas.size(); ++i) {
+                half_areas[i] = FloatToBFloat16(areas[i]);
+            }
+            break;
+        default:
+            float_areas.assign(areas.begin(), areas.end());
+            break;
+    }
+    return true;
+}
+
+size_t CompactCornerCollector::areaBytes() const {
+    return float_areas.size() * sizeof(f32) + half_areas.size() * sizeof(u16);
+}
+
+// The reductions decode the columns on the fly
+f32 TotalAreaCollector(CompactCornerCollector& collector) {
+    INSTRUMENT_SCOPE("TotalAreaCollector/compact", collector.size(), 0);
+    const simd_kernels& kernels = SimdKernels();
+    switch (collector.encoding()) {
+        case Encoding_F16: return kernels.sum_f16(collector.half_areas.data(), collector.size());
+        case Encoding_BF16: return kernels.sum_bf16(collector.half_areas.data(), collector.size());
+        default: return kernels.sum(collector.float_areas.data(), collector.size());
+    }
+}
+
+f32 CornerAreaCollector(CompactCornerCollector& collector) {
+    INSTRUMENT_SCOPE("CornerAreaCollector/compact", collector.size(), 0);
+    const simd_kernels& kernels = SimdKernels();
+    const u8* index = collector.weight_index.data();
+    switch (collector.encoding()) {
+        case Encoding_F16:
+            return kernels.dot_f16_lut(collector.half_areas.data(), index, collector.weight_lut, collector.size());
+        case Encoding_BF16:
+            return kernels.dot_bf16_lut(collector.half_areas.data(), index, collector.weight_lut, collector.size());
+        default:
+            return kernels.dot_lut(collector.float_areas.data(), index, collector.weight_lut, collector.size());
+    }
+}
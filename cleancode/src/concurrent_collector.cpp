@@ -0,0 +1,113 @@
+#include "concurrent_collector.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include "simd_kernels.h"
+
+// Shapes per CollectShapes call of a batch append; the corner counts of a
+// block stay on the stack
+constexpr size_t AppendBlockSize = 1024;
+
+concurrent_lane::~concurrent_lane() {
+    for (concurrent_segment* segment : Segments) {
+        delete segment;
+    }
+}
+
+// The pointer is stored before the row is published, so readers that only
+// look below published() never see it unset
+concurrent_segment* concurrent_lane::writable(size_t row) {
+    size_t s = row / ConcurrentSegmentRows;
+    if (s >= ConcurrentMaxSegments) {
+        return nullptr;
+    }
+    if (!Segments[s]) {
+        Segments[s] = new concurrent_segment;
+    }
+    return Segments[s];
+}
+
+bool concurrent_lane::addShapes(u32 ShapeCount, shape_base** Shapes) {
+    const size_t begin = Size.load(std::memory_order_relaxed);
+    if (begin + ShapeCount > ConcurrentMaxSegments * ConcurrentSegmentRows) {
+        return false;
+    }
+    u8 corner_counts[AppendBlockSize];
+    for (size_t done = 0; done < ShapeCount;) {
+        size_t row = begin + done;
+        size_t r = row % ConcurrentSegmentRows;
+        size_t count = std::min({AppendBlockSize, ShapeCount - done, ConcurrentSegmentRows - r});
+        concurrent_segment* segment = writable(row);
+        CollectShapes(static_cast<u32>(count), Shapes + done, segment->Areas + r, corner_counts);
+        for (size_t i = 0; i < count; ++i) {
+            segment->Weights[r + i] = CornerWeight(corner_counts[i]);
+        }
+        done += count;
+    }
+    Size.store(begin + ShapeCount, std::memory_order_release);
+    return true;
+}
+
+size_t ConcurrentSnapshot::size() const {
+    size_t rows = 0;
+    for (const lane_rows& lane : Lanes) {
+        rows += lane.Rows;
+    }
+    return rows;
+}
+
+ConcurrentCornerCollector::~ConcurrentCornerCollector() {
+    for (std::atomic<concurrent_lane*>& lane : Lanes) {
+        delete lane.load();
+    }
+}
+
+concurrent_lane* ConcurrentCornerCollector::addLane() {
+    u32 index = LaneCount.fetch_add(1);
+    if (index >= ConcurrentMaxLanes) {
+        return nullptr;
+    }
+    concurrent_lane* lane = new concurrent_lane;
+    Lanes[index].store(lane, std::memory_order_release);
+    return lane;
+}
+
+// A lane whose index is taken but not yet stored has published nothing
+ConcurrentSnapshot ConcurrentCornerCollector::snapshot() const {
+    ConcurrentSnapshot view;
+    u32 count = std::min(LaneCount.load(), ConcurrentMaxLanes);
+    view.Lanes.reserve(count);
+    for (u32 i = 0; i < count; ++i) {
+        if (const concurrent_lane* lane = Lanes[i].load(std::memory_order_acquire)) {
+            view.Lanes.push_back({lane, lane->published()});
+        }
+    }
+    return view;
+}
+
+// Lanes in order, then segments in order; each segment is one aligned call
+template <class Reduce>
+static f32 ReduceSnapshot(const ConcurrentSnapshot& view, const Reduce& reduce) {
+    double Accum = 0.0;
+    for (const ConcurrentSnapshot::lane_rows& lane : view.lanes()) {
+        for (size_t begin = 0, s = 0; begin < lane.Rows; begin += ConcurrentSegmentRows, ++s) {
+            Accum += reduce(*lane.Lane->segment(s), std::min(ConcurrentSegmentRows, lane.Rows - begin));
+        }
+    }
+    return static_cast<f32>(Accum);
+}
+
+f32 TotalAreaCollector(const ConcurrentSnapshot& view) {
+    INSTRUMENT_SCOPE("TotalAreaCollector/snapshot", view.size(), view.size() * sizeof(f32));
+    const simd_kernels& kernels = SimdKernels();
+    return ReduceSnapshot(view, [&](const concurrent_segment& segment, size_t rows) {
+        return kernels.sum_aligned(segment.Areas, rows);
+    });
+}
+
+f32 CornerAreaCollector(const ConcurrentSnapshot& view) {
+    INSTRUMENT_SCOPE("CornerAreaCollector/snapshot", view.size(), view.size() * 2 * sizeof(f32));
+    const simd_kernels& kernels = SimdKernels();
+    return ReduceSnapshot(view, [&](const concurrent_segment& segment, size_t rows) {
+        return kernels.dot_aligned(segment.Areas, segment.Weights, rows);
+    });
+}
@@ -0,0 +1,127 @@
+#include "device_collector.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include "shape_store.h"
+#include "simd_kernels.h"
+
+// The experimental CUDA backend is only added to the build with
+// -DCLEANCODE_CUDA_EXPERIMENTAL=ON and a CUDA toolkit; without it the factory
+// reports no device.
+#ifndef DEVICE_CUDA
+std::unique_ptr<DeviceCollector> MakeCudaDeviceCollector() { return nullptr; }
+#endif
+
+// Rows per block of the fused CPU pass: the area block is summed and then
+// read again for the dot product while it is still in L2
+constexpr size_t CpuFusedBlock = 32 * 1024;
+
+namespace {
+
+class CpuDeviceCollector : public DeviceCollector {
+public:
+    const char* backend() const override { return "cpu"; }
+
+    bool upload(const f32* AreasInit, const f32* WeightsInit, size_t size) override {
+        areas.assign(AreasInit, AreasInit + size);
+        weights.assign(WeightsInit, WeightsInit + size);
+        return true;
+    }
+
+    bool upload(const ShapeStore& store) override {
+        areas.resize(store.size());
+        weights.resize(store.size());
+        size_t offset = 0;
+        for (u32 t = 0; t < Shape_Count; ++t) {
+            const shape_column& column = store.column(t);
+            const f32* width = column.Width.data();
+            const f32* height = ShapeStore::HasHeight(shape_type(t)) ? column.Height.data() : width;
+            const f32 Coefficient = ShapeAreaCoefficients[t];
+            for (size_t i = 0; i < column.Width.size(); ++i) {
+                areas[offset + i] = Coefficient * width[i] * height[i];
+            }
+            std::fill_n(weights.begin() + offset, column.Width.size(), ShapeCornerWeights[t]);
+            offset += column.Width.size();
+        }
+        return true;
+    }
+
+    void release() override {
+        areas = aligned_vector<f32>();
+        weights = aligned_vector<f32>();
+    }
+
+    size_t size() const override { return areas.size(); }
+    f32 totalArea() const override { return SimdKernels().sum_aligned(areas.data(), areas.size()); }
+    f32 cornerArea() const override {
+        return SimdKernels().dot_aligned(areas.data(), weights.data(), areas.size());
+    }
+
+    device_reduction reduce() const override {
+        INSTRUMENT_SCOPE("DeviceCollector::reduce/cpu", areas.size(), areas.size() * 2 * sizeof(f32));
+        const simd_kernels& kernels = SimdKernels();
+        double total = 0.0, corner = 0.0;
+        for (size_t i = 0; i < areas.size(); i += CpuFusedBlock) {
+            size_t count = std::min(CpuFusedBlock, areas.size() - i);
+            total += kernels.sum_aligned(areas.data() + i, count);
+            corner += kernels.dot_aligned(areas.data() + i, weights.data() + i, count);
+        }
+        device_reduction result;
+        result.TotalArea = static_cast<f32>(total);
+        result.CornerArea = static_cast<f32>(corner);
+        return result;
+    }
+
+private:
+    aligned_vector<f32> areas;
+    aligned_vector<f32> weights;
+};
+
+struct device_backend {
+    const char* name;
+    std::unique_ptr<DeviceCollector> (*make)();
+};
+
+// Best first; "auto" takes the first that finds a device
+const device_backend DeviceBackends[] = {
+    {"cuda", MakeCudaDeviceCollector},
+    {"cpu", MakeCpuDeviceCollector},
+};
+
+} // namespace
+
+bool DeviceCollector::upload(const CornerCollector& collector) {
+    return upload(collector.areas().data(), collector.weights().data(), collector.size());
+}
+
+std::unique_ptr<DeviceCollector> MakeCpuDeviceCollector() { return std::make_unique<CpuDeviceCollector>(); }
+
+std::unique_ptr<DeviceCollector> MakeDeviceCollector(const std::string& backend) {
+    for (const device_backend& entry : DeviceBackends) {
+        if (backend == "auto" || backend == entry.name) {
+            if (std::unique_ptr<DeviceCollector> collector = entry.make()) {
+                return collector;
+            }
+        }
+    }
+    return MakeCpuDeviceCollector();
+}
+
+std::vector<std::string> AvailableDeviceBackends() {
+    std::vector<std::string> names;
+    for (const device_backend& entry : DeviceBackends) {
+        if (entry.make()) {
+            names.push_back(entry.name);
+        }
+    }
+    return names;
+}
+
+f32 TotalAreaCollector(const DeviceCollector& collector) {
+    INSTRUMENT_SCOPE("TotalAreaCollector/device", collector.size(), collector.size() * sizeof(f32));
+    return collector.totalArea();
+}
+
+f32 CornerAreaCollector(const DeviceCollector& collector) {
+    INSTRUMENT_SCOPE("CornerAreaCollector/device", collector.size(), collector.size() * 2 * sizeof(f32));
+    return collector.cornerArea();
+}
@@ -0,0 +1,236 @@
+#include "device_collector.h"
+#include "instrumentation.h"
+#include <cuda_runtime.h>
+#include <algorithm>
+#include <vector>
+#include "shape_store.h"
+
+// Device-resident collector columns reduced by CUDA kernels. Each reduction
+// writes one partial per block; the partials are added on the host in block
+// order, so a result only depends on the data and the launch shape.
+//
+// Experimental: only built with -DCLEANCODE_CUDA_EXPERIMENTAL=ON, and not
+// compiled or run in CI.
+
+namespace {
+
+constexpr u32 ReduceThreads = 256;
+constexpr u32 ReduceMaxBlocks = 1024;
+
+// Grid-stride sums of areas and, when weights is set, areas * weights; one
+// pair of partials per block
+__global__ void ReduceKernel(const f32* areas, const f32* weights, size_t size, f32* TotalPartials,
+                             f32* CornerPartials) {
+    __shared__ f32 Total[ReduceThreads];
+    __shared__ f32 Corner[ReduceThreads];
+    f32 total = 0.0f, corner = 0.0f;
+    for (size_t i = size_t(blockIdx.x) * blockDim.x + threadIdx.x; i < size; i += size_t(gridDim.x) * blockDim.x) {
+        f32 area = areas[i];
+        total += area;
+        if (weights) {
+            corner += area * weights[i];
+        }
+    }
+    Total[threadIdx.x] = total;
+    Corner[threadIdx.x] = corner;
+    __syncthreads();
+    for (u32 half = ReduceThreads / 2; half > 0; half /= 2) {
+        if (threadIdx.x < half) {
+            Total[threadIdx.x] += Total[threadIdx.x + half];
+            Corner[threadIdx.x] += Corner[threadIdx.x + half];
+        }
+        __syncthreads();
+    }
+    if (threadIdx.x == 0) {
+        TotalPartials[blockIdx.x] = Total[0];
+        CornerPartials[blockIdx.x] = Corner[0];
+    }
+}
+
+// Area and weight rows of one store type column
+__global__ void ExpandKernel(const f32* width, const f32* height, size_t size, f32 Coefficient, f32 Weight,
+                             f32* areas, f32* weights) {
+    for (size_t i = size_t(blockIdx.x) * blockDim.x + threadIdx.x; i < size; i += size_t(gridDim.x) * blockDim.x) {
+        areas[i] = Coefficient * width[i] * height[i];
+        weights[i] = Weight;
+    }
+}
+
+static u32 BlocksFor(size_t size) {
+    size_t blocks = (size + ReduceThreads - 1) / ReduceThreads;
+    return static_cast<u32>(std::max<size_t>(1, std::min<size_t>(ReduceMaxBlocks, blocks)));
+}
+
+// Owning device allocation of Count values
+class device_buffer {
+public:
+    device_buffer() { }
+    ~device_buffer() { reset(); }
+    device_buffer(const device_buffer&) = delete;
+    device_buffer& operator=(const device_buffer&) = delete;
+
+    bool allocate(size_t count) {
+        reset();
+        if (count == 0) {
+            return true;
+        }
+        if (cudaMalloc(&Data, count * sizeof(f32)) != cudaSuccess) {
+            Data = nullptr;
+            return false;
+        }
+        Count = count;
+        return true;
+    }
+    void reset() {
+        if (Data) {
+            cudaFree(Data);
+        }
+        Data = nullptr;
+        Count = 0;
+    }
+
+    f32* data() const { return Data; }
+    size_t size() const { return Count; }
+
+private:
+    f32* Data = nullptr;
+    size_t Count = 0;
+};
+
+static bool copy(f32* device, const f32* host, size_t count) {
+    return cudaMemcpy(device, host, count * sizeof(f32), cudaMemcpyHostToDevice) == cudaSuccess;
+}
+
+class CudaDeviceCollector : public DeviceCollector {
+public:
+    CudaDeviceCollector() { }
+    ~CudaDeviceCollector() override { release(); }
+
+    const char* backend() const override { return "cuda"; }
+
+    bool upload(const f32* AreasInit, const f32* WeightsInit, size_t size) override {
+        if (!allocate(size) || !copy(areas.data(), AreasInit, size) || !copy(weights.data(), WeightsInit, size)) {
+            release();
+            return false;
+        }
+        return true;
+    }
+
+    // Only the dimensions cross the bus; the rows are expanded on the device.
+    // The width/height staging buffers are sized once for the largest type
+    // column and kept for later uploads, so no buffer is freed while an
+    // expand kernel may still read it.
+    bool upload(const ShapeStore& store) override {
+        size_t largest = 0;
+        for (u32 t = 0; t < Shape_Count; ++t) {
+            largest = std::max(largest, store.column(t).Width.size());
+        }
+        if (!allocate(store.size()) || !reserveStaging(largest)) {
+            release();
+            return false;
+        }
+        size_t offset = 0;
+        for (u32 t = 0; t < Shape_Count; ++t) {
+            const shape_column& column = store.column(t);
+            const size_t count = column.Width.size();
+            if (count == 0) {
+                continue;
+            }
+            // The copies are ordered after the previous expand kernel on the
+            // default stream
+            const bool separate = ShapeStore::HasHeight(shape_type(t));
+            if (!copy(staging_width.data(), column.Width.data(), count) ||
+                (separate && !copy(staging_height.data(), column.Height.data(), count))) {
+                release();
+                return false;
+            }
+            const f32* heights = separate ? staging_height.data() : staging_width.data();
+            ExpandKernel<<<BlocksFor(count), ReduceThreads>>>(staging_width.data(), heights, count,
+                                                              ShapeAreaCoefficients[t], ShapeCornerWeights[t],
+                                                              areas.data() + offset, weights.data() + offset);
+            offset += count;
+        }
+        if (cudaGetLastError() != cudaSuccess || cudaStreamSynchronize(0) != cudaSuccess) {
+            release();
+            return false;
+        }
+        return true;
+    }
+
+    // Waits for outstanding work on the columns before freeing them
+    void release() override {
+        cudaStreamSynchronize(0);
+        areas.reset();
+        weights.reset();
+        total_partials.reset();
+        corner_partials.reset();
+        staging_width.reset();
+        staging_height.reset();
+    }
+
+    size_t size() const override { return areas.size(); }
+    f32 totalArea() const override { return run(false).TotalArea; }
+    f32 cornerArea() const override { return run(true).CornerArea; }
+    device_reduction reduce() const override {
+        INSTRUMENT_SCOPE("DeviceCollector::reduce/cuda", areas.size(), areas.size() * 2 * sizeof(f32));
+        return run(true);
+    }
+
+private:
+    bool allocate(size_t size) {
+        cudaStreamSynchronize(0);
+        return areas.allocate(size) && weights.allocate(size) && total_partials.allocate(ReduceMaxBlocks) &&
+               corner_partials.allocate(ReduceMaxBlocks);
+    }
+
+    // Grows the staging buffers to count values; they are only ever grown
+    bool reserveStaging(size_t count) {
+        if (staging_width.size() >= count && staging_height.size() >= count) {
+            return true;
+        }
+        cudaStreamSynchronize(0);
+        return staging_width.allocate(count) && staging_height.allocate(count);
+    }
+
+    // A failed launch or copy returns zeros
+    device_reduction run(bool Weighted) const {
+        device_reduction result;
+        if (areas.size() == 0) {
+            return result;
+        }
+        const u32 blocks = BlocksFor(areas.size());
+        ReduceKernel<<<blocks, ReduceThreads>>>(areas.data(), Weighted ? weights.data() : nullptr, areas.size(),
+                                                total_partials.data(), corner_partials.data());
+        std::vector<f32> total(blocks), corner(blocks);
+        const size_t bytes = blocks * sizeof(f32);
+        if (cudaMemcpy(total.data(), total_partials.data(), bytes, cudaMemcpyDeviceToHost) != cudaSuccess ||
+            cudaMemcpy(corner.data(), corner_partials.data(), bytes, cudaMemcpyDeviceToHost) != cudaSuccess) {
+            return result;
+        }
+        double total_sum = 0.0, corner_sum = 0.0;
+        for (u32 b = 0; b < blocks; ++b) {
+            total_sum += total[b];
+            corner_sum += corner[b];
+        }
+        result.TotalArea = static_cast<f32>(total_sum);
+        result.CornerArea = static_cast<f32>(corner_sum);
+        return result;
+    }
+
+    device_buffer areas;
+    device_buffer weights;
+    device_buffer total_partials;
+    device_buffer corner_partials;
+    device_buffer staging_width;
+    device_buffer staging_height;
+};
+
+} // namespace
+
+std::unique_ptr<DeviceCollector> MakeCudaDeviceCollector() {
+    int devices = 0;
+    if (cudaGetDeviceCount(&devices) != cudaSuccess || devices == 0) {
+        return nullptr;
+    }
+    return std::make_unique<CudaDeviceCollector>();
+}
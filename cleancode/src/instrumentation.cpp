@@ -0,0 +1,215 @@
+#include "instrumentation.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#if !defined(__x86_64__) && !defined(__i386__) && !defined(__aarch64__)
+u64 SteadyTimestamp() {
+    return static_cast<u64>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+#endif
+
+// Long enough for a 1e-4 relative error at a microsecond of clock jitter
+constexpr auto TimestampCalibrationTime = std::chrono::milliseconds(10);
+
+double TimestampTicksPerNs() {
+    static const double ticks_per_ns = [] {
+        auto start = std::chrono::steady_clock::now();
+        u64 first = ReadTimestamp();
+        while (std::chrono::steady_clock::now() - start < TimestampCalibrationTime) {
+        }
+        u64 last = ReadTimestamp();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        return ns > 0.0 && last > first ? double(last - first) / ns : 1.0;
+    }();
+    return ticks_per_ns;
+}
+
+#if CLEANCODE_INSTRUMENT
+
+namespace {
+
+// Probe names and the counters of every running thread. Registration takes
+// the mutex; recording never does. A thread's counters are added to retired
+// at its exit, so the calls of finished threads stay in the totals.
+struct metrics_registry {
+    std::mutex mutex;
+    std::vector<std::string> names;
+    std::vector<thread_metrics*> threads;
+    thread_metrics retired;
+    bool overflow_reported = false;
+};
+
+metrics_registry& Registry() {
+    static metrics_registry registry;
+    return registry;
+}
+
+void AddCounters(probe_counters& into, const probe_counters& from) {
+    AddCounter(into.Calls, from.Calls.load(std::memory_order_relaxed));
+    AddCounter(into.Ticks, from.Ticks.load(std::memory_order_relaxed));
+    AddCounter(into.Elements, from.Elements.load(std::memory_order_relaxed));
+    AddCounter(into.Bytes, from.Bytes.load(std::memory_order_relaxed));
+    for (u32 b = 0; b < MetricsBuckets; ++b) {
+        AddCounter(into.Buckets[b], from.Buckets[b].load(std::memory_order_relaxed));
+    }
+}
+
+// Owns the counters of one thread and retires them at thread exit
+struct thread_metrics_owner {
+    std::unique_ptr<thread_metrics> metrics;
+
+    ~thread_metrics_owner() {
+        if (!metrics) {
+            return;
+        }
+        metrics_registry& registry = Registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (u32 p = 0; p < MetricsMaxProbes; ++p) {
+            AddCounters(registry.retired.Probes[p], metrics->Probes[p]);
+        }
+        registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), metrics.get()));
+    }
+};
+
+} // namespace
+
+u32 RegisterProbe(const char* name) {
+    metrics_registry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    auto existing = std::find(registry.names.begin(), registry.names.end(), name);
+    if (existing != registry.names.end()) {
+        return static_cast<u32>(existing - registry.names.begin());
+    }
+    if (registry.names.size() == MetricsMaxProbes) {
+        if (!registry.overflow_reported) {
+            registry.overflow_reported = true;
+            std::fprintf(stderr, "instrumentation: more than %u probe names, dropping \"%s\" and later ones\n",
+                         MetricsMaxProbes, name);
+        }
+        return MetricsMaxProbes;
+    }
+    registry.names.push_back(name);
+    return static_cast<u32>(registry.names.size() - 1);
+}
+
+thread_metrics& LocalMetrics() {
+    thread_local thread_metrics_owner owner;
+    if (!owner.metrics) {
+        owner.metrics = std::make_unique<thread_metrics>();
+        metrics_registry& registry = Registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.threads.push_back(owner.metrics.get());
+    }
+    return *owner.metrics;
+}
+
+#if defined(CLEANCODE_ITT)
+__itt_domain* InstrumentDomain() {
+    static __itt_domain* const domain = __itt_domain_create("cleancode");
+    return domain;
+}
+#endif
+
+std::vector<probe_snapshot> SnapshotMetrics() {
+    metrics_registry& registry = Registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    std::vector<probe_snapshot> probes(registry.names.size());
+    for (size_t p = 0; p < probes.size(); ++p) {
+        probe_snapshot& probe = probes[p];
+        probe.Name = registry.names[p];
+        auto add = [&](const probe_counters& counters) {
+            probe.Calls += counters.Calls.load(std::memory_order_relaxed);
+            probe.Ticks += counters.Ticks.load(std::memory_order_relaxed);
+            probe.Elements += counters.Elements.load(std::memory_order_relaxed);
+            probe.Bytes += counters.Bytes.load(std::memory_order_relaxed);
+            for (u32 b = 0; b < MetricsBuckets; ++b) {
+                probe.Buckets[b] += counters.Buckets[b].load(std::memory_order_relaxed);
+            }
+        };
+        add(registry.retired.Probes[p]);
+        for (const thread_metrics* thread : registry.threads) {
+            add(thread->Probes[p]);
+        }
+    }
+    return probes;
+}
+
+#else
+
+std::vector<probe_snapshot> SnapshotMetrics() { return {}; }
+
+#endif
+
+// Upper bound of histogram bucket b in seconds
+static double BucketSeconds(u32 b, double ticks_per_ns) { return double(2ull << b) / ticks_per_ns * 1e-9; }
+
+// Buckets up to the last non-empty one; the rest only repeat the count
+static u32 UsedBuckets(const probe_snapshot& probe) {
+    u32 used = 0;
+    for (u32 b = 0; b < MetricsBuckets; ++b) {
+        if (probe.Buckets[b]) {
+            used = b + 1;
+        }
+    }
+    return used;
+}
+
+std::string MetricsPrometheus() {
+    const std::vector<probe_snapshot> probes = SnapshotMetrics();
+    const double ticks_per_ns = TimestampTicksPerNs();
+    std::ostringstream out;
+    auto counter = [&](const char* metric, const char* help, auto value) {
+        out << "# HELP " << metric << " " << help << "\n# TYPE " << metric << " counter\n";
+        for (const probe_snapshot& probe : probes) {
+            out << metric << "{probe=\"" << probe.Name << "\"} " << value(probe) << "\n";
+        }
+    };
+    counter("cleancode_calls_total", "Calls of the probed function.", [](const probe_snapshot& p) { return p.Calls; });
+    counter("cleancode_seconds_total", "Time spent in the probed function.",
+            [&](const probe_snapshot& p) { return double(p.Ticks) / ticks_per_ns * 1e-9; });
+    counter("cleancode_elements_total", "Shapes processed.", [](const probe_snapshot& p) { return p.Elements; });
+    counter("cleancode_bytes_total", "Bytes of input read.", [](const probe_snapshot& p) { return p.Bytes; });
+
+    out << "# HELP cleancode_call_seconds Duration of one call.\n# TYPE cleancode_call_seconds histogram\n";
+    for (const probe_snapshot& probe : probes) {
+        u64 cumulative = 0;
+        for (u32 b = 0, used = UsedBuckets(probe); b < used; ++b) {
+            cumulative += probe.Buckets[b];
+            out << "cleancode_call_seconds_bucket{probe=\"" << probe.Name << "\",le=\""
+                << BucketSeconds(b, ticks_per_ns) << "\"} " << cumulative << "\n";
+        }
+        out << "cleancode_call_seconds_bucket{probe=\"" << probe.Name << "\",le=\"+Inf\"} " << probe.Calls << "\n";
+        out << "cleancode_call_seconds_sum{probe=\"" << probe.Name << "\"} "
+            << double(probe.Ticks) / ticks_per_ns * 1e-9 << "\n";
+        out << "cleancode_call_seconds_count{probe=\"" << probe.Name << "\"} " << probe.Calls << "\n";
+    }
+    return out.str();
+}
+
+std::string MetricsJson() {
+    const std::vector<probe_snapshot> probes = SnapshotMetrics();
+    const double ticks_per_ns = TimestampTicksPerNs();
+    std::ostringstream out;
+    out << "[";
+    for (size_t p = 0; p < probes.size(); ++p) {
+        const probe_snapshot& probe = probes[p];
+        const double seconds = double(probe.Ticks) / ticks_per_ns * 1e-9;
+        out << (p ? ",\n " : "\n ") << "{\"probe\": \"" << probe.Name << "\", \"calls\": " << probe.Calls
+            << ", \"seconds\": " << seconds << ", \"elements\": " << probe.Elements << ", \"bytes\": " << probe.Bytes
+            << ", \"elements_per_second\": " << (seconds > 0.0 ? double(probe.Elements) / seconds : 0.0)
+            << ", \"histogram\": [";
+        for (u32 b = 0, used = UsedBuckets(probe); b < used; ++b) {
+            out << (b ? ", " : "") << "{\"le_seconds\": " << BucketSeconds(b, ticks_per_ns)
+                << ", \"count\": " << probe.Buckets[b] << "}";
+        }
+        out << "]}";
+    }
+    out << (probes.empty() ? "]" : "\n]") << std::endl;
+    return out.str();
+}
@@ -0,0 +1,521 @@
+// AVX2 + FMA + F16C kernels. Built with -mavx2 -mfma -mf16c and only entered
+// after the CPU check in simd_dispatch.cpp.
+#include <immintrin.h>
+#include "simd_kernels.h"
+
+// Lane mask for the first 'remaining' (0..8) lanes of a masked load;
+// masked-off lanes load as zero and never touch memory
+static __m256i TailMaskAVX2(size_t remaining) {
+    static const int Lanes[16] = {-1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0};
+    return _mm256_loadu_si256((const __m256i*)(Lanes + 8 - remaining));
+}
+
+// Aligned variants require 32-byte aligned columns; every load of the main
+// loops is then at a multiple of eight elements and aligned as well
+template <bool Aligned>
+static __m256 LoadAVX2(const f32* p) {
+    return Aligned ? _mm256_load_ps(p) : _mm256_loadu_ps(p);
+}
+
+// 8-accumulator AVX sum
+template <bool Aligned>
+static f32 SumAVX2(const f32* areas, size_t size) {
+    // Use 8 accumulators for even better pipelining and to utilize more registers
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    __m256 sum2 = _mm256_setzero_ps();
+    __m256 sum3 = _mm256_setzero_ps();
+    __m256 sum4 = _mm256_setzero_ps();
+    __m256 sum5 = _mm256_setzero_ps();
+    __m256 sum6 = _mm256_setzero_ps();
+    __m256 sum7 = _mm256_setzero_ps();
+    
+    // Process 64 elements at a time - further unrolled loop with prefetching
+    size_t i = 0;
+    const size_t ahead = PrefetchDistance();
+    
+    // For very large arrays, first prefetch ahead
+    if (ahead && size >= 128) {
+        _mm_prefetch((const char*)&areas[64], _MM_HINT_T0);
+        _mm_prefetch((const char*)&areas[96], _MM_HINT_T0);
+    }
+    
+    for (; i + 63 < size; i += 64) {
+        // Prefetch next iterations to L1 cache
+        if (ahead) {
+            _mm_prefetch((const char*)&areas[i + ahead], _MM_HINT_T0);
+            _mm_prefetch((const char*)&areas[i + ahead + 32], _MM_HINT_T0);
+        }
+        
+        // Fully unrolled loop for 64 elements with 8 accumulators
+        // This eliminates loop overhead and maximizes instruction-level parallelism
+        sum0 = _mm256_add_ps(sum0, LoadAVX2<Aligned>(&areas[i]));
+        sum1 = _mm256_add_ps(sum1, LoadAVX2<Aligned>(&areas[i + 8]));
+        sum2 = _mm256_add_ps(sum2, LoadAVX2<Aligned>(&areas[i + 16]));
+        sum3 = _mm256_add_ps(sum3, LoadAVX2<Aligned>(&areas[i + 24]));
+        sum4 = _mm256_add_ps(sum4, LoadAVX2<Aligned>(&areas[i + 32]));
+        sum5 = _mm256_add_ps(sum5, LoadAVX2<Aligned>(&areas[i + 40]));
+        sum6 = _mm256_add_ps(sum6, LoadAVX2<Aligned>(&areas[i + 48]));
+        sum7 = _mm256_add_ps(sum7, LoadAVX2<Aligned>(&areas[i + 56]));
+    }
+    
+    // Combine the 8 accumulators into 4
+    sum0 = _mm256_add_ps(sum0, sum4);
+    sum1 = _mm256_add_ps(sum1, sum5);
+    sum2 = _mm256_add_ps(sum2, sum6);
+    sum3 = _mm256_add_ps(sum3, sum7);
+    
+    // Combine the 4 accumulators into 2
+    sum0 = _mm256_add_ps(sum0, sum1);
+    sum2 = _mm256_add_ps(sum2, sum3);
+    
+    // Combine the 2 accumulators into 1
+    sum0 = _mm256_add_ps(sum0, sum2);
+    
+    // Now process 8 elements at a time for remaining data
+    for (; i + 7 < size; i += 8) {
+        sum0 = _mm256_add_ps(sum0, LoadAVX2<Aligned>(&areas[i]));
+    }
+
+    // Last 0-7 elements through a masked load instead of a scalar loop
+    if (i < size) {
+        sum0 = _mm256_add_ps(sum0, _mm256_maskload_ps(&areas[i], TailMaskAVX2(size - i)));
+    }
+    
+    // Extract result from AVX register using more efficient horizontal sum
+    __m128 high128 = _mm256_extractf128_ps(sum0, 1);
+    __m128 low128 = _mm256_castps256_ps128(sum0);
+    __m128 sum128 = _mm_add_ps(high128, low128);
+    
+    // Horizontal sum of 128-bit SSE vector - optimized version
+    sum128 = _mm_hadd_ps(sum128, sum128);
+    sum128 = _mm_hadd_ps(sum128, sum128);
+    
+    return _mm_cvtss_f32(sum128);
+}
+
+// Dot product of areas and precomputed weights using FMA
+template <bool Aligned>
+static f32 DotAVX2(const f32* areas, const f32* weights, size_t size) {
+    // Use 8 accumulators for better pipelining
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    __m256 sum2 = _mm256_setzero_ps();
+    __m256 sum3 = _mm256_setzero_ps();
+    __m256 sum4 = _mm256_setzero_ps();
+    __m256 sum5 = _mm256_setzero_ps();
+    __m256 sum6 = _mm256_setzero_ps();
+    __m256 sum7 = _mm256_setzero_ps();
+    
+    // Process 64 elements at a time with prefetching
+    size_t i = 0;
+    const size_t ahead = PrefetchDistance();
+    
+    // For very large arrays, first prefetch ahead
+    if (ahead && size >= 128) {
+        _mm_prefetch((const char*)&areas[64], _MM_HINT_T0);
+        _mm_prefetch((const char*)&areas[64+64], _MM_HINT_T0);
+        _mm_prefetch((const char*)&weights[64], _MM_HINT_T0);
+        _mm_prefetch((const char*)&weights[64+64], _MM_HINT_T0);
+    }
+    
+    for (; i + 63 < size; i += 64) {
+        // Prefetch next iterations to L1 cache
+        if (ahead) {
+            _mm_prefetch((const char*)&areas[i + ahead], _MM_HINT_T0);
+            _mm_prefetch((const char*)&areas[i + ahead + 32], _MM_HINT_T0);
+            _mm_prefetch((const char*)&weights[i + ahead], _MM_HINT_T0);
+            _mm_prefetch((const char*)&weights[i + ahead + 32], _MM_HINT_T0);
+        }
+        
+        // First 8 elements
+        __m256 area_vec0 = LoadAVX2<Aligned>(&areas[i]);
+        __m256 weight_vec0 = LoadAVX2<Aligned>(&weights[i]);
+        
+        // Next 8 elements
+        __m256 area_vec1 = LoadAVX2<Aligned>(&areas[i + 8]);
+        __m256 weight_vec1 = LoadAVX2<Aligned>(&weights[i + 8]);
+        
+        // Next 8 elements
+        __m256 area_vec2 = LoadAVX2<Aligned>(&areas[i + 16]);
+        __m256 weight_vec2 = LoadAVX2<Aligned>(&weights[i + 16]);
+        
+        // Next 8 elements
+        __m256 area_vec3 = LoadAVX2<Aligned>(&areas[i + 24]);
+        __m256 weight_vec3 = LoadAVX2<Aligned>(&weights[i + 24]);
+        
+        // Next 8 elements
+        __m256 area_vec4 = LoadAVX2<Aligned>(&areas[i + 32]);
+        __m256 weight_vec4 = LoadAVX2<Aligned>(&weights[i + 32]);
+        
+        // Next 8 elements
+        __m256 area_vec5 = LoadAVX2<Aligned>(&areas[i + 40]);
+        __m256 weight_vec5 = LoadAVX2<Aligned>(&weights[i + 40]);
+        
+        // Next 8 elements
+        __m256 area_vec6 = LoadAVX2<Aligned>(&areas[i + 48]);
+        __m256 weight_vec6 = LoadAVX2<Aligned>(&weights[i + 48]);
+        
+        // Next 8 elements
+        __m256 area_vec7 = LoadAVX2<Aligned>(&areas[i + 56]);
+        __m256 weight_vec7 = LoadAVX2<Aligned>(&weights[i + 56]);
+        
+        // Multiply and accumulate using 8 independent accumulators with FMA
+        // FMA computes a*b+c in a single instruction with a single rounding step
+        sum0 = _mm256_fmadd_ps(area_vec0, weight_vec0, sum0);
+        sum1 = _mm256_fmadd_ps(area_vec1, weight_vec1, sum1);
+        sum2 = _mm256_fmadd_ps(area_vec2, weight_vec2, sum2);
+        sum3 = _mm256_fmadd_ps(area_vec3, weight_vec3, sum3);
+        sum4 = _mm256_fmadd_ps(area_vec4, weight_vec4, sum4);
+        sum5 = _mm256_fmadd_ps(area_vec5, weight_vec5, sum5);
+        sum6 = _mm256_fmadd_ps(area_vec6, weight_vec6, sum6);
+        sum7 = _mm256_fmadd_ps(area_vec7, weight_vec7, sum7);
+    }
+    
+    // Combine the 8 accumulators into 4
+    sum0 = _mm256_add_ps(sum0, sum4);
+    sum1 = _mm256_add_ps(sum1, sum5);
+    sum2 = _mm256_add_ps(sum2, sum6);
+    sum3 = _mm256_add_ps(sum3, sum7);
+    
+    // Combine the 4 accumulators into 2
+    sum0 = _mm256_add_ps(sum0, sum1);
+    sum2 = _mm256_add_ps(sum2, sum3);
+    
+    // Combine the 2 accumulators into 1
+    sum0 = _mm256_add_ps(sum0, sum2);
+    
+    // Process remaining 8-element chunks
+    for (; i + 7 < size; i += 8) {
+        __m256 area_vec = LoadAVX2<Aligned>(&areas[i]);
+        __m256 weight_vec = LoadAVX2<Aligned>(&weights[i]);
+        sum0 = _mm256_fmadd_ps(area_vec, weight_vec, sum0);
+    }
+
+    // Last 0-7 elements through masked loads
+    if (i < size) {
+        __m256i mask = TailMaskAVX2(size - i);
+        sum0 = _mm256_fmadd_ps(_mm256_maskload_ps(&areas[i], mask), _mm256_maskload_ps(&weights[i], mask), sum0);
+    }
+    
+    // Horizontal sum using efficient hadd instructions
+    __m128 high128 = _mm256_extractf128_ps(sum0, 1);
+    __m128 low128 = _mm256_castps256_ps128(sum0);
+    __m128 sum128 = _mm_add_ps(high128, low128);
+    
+    // More efficient horizontal sum with hadd
+    sum128 = _mm_hadd_ps(sum128, sum128);
+    sum128 = _mm_hadd_ps(sum128, sum128);
+    
+    return _mm_cvtss_f32(sum128);
+}
+
+// Table-driven sum over the 12-byte shape_union array. Eight shapes are three
+// loads; blends put each field into one register with the lanes in the order
+// 0,3,6,1,4,7,2,5 for Type, rotated by one and two lanes for Width and
+// Height, so two rotations align them. The lane order does not matter for a
+// sum. The coefficient of each lane comes from an in-register permute.
+static __m256 UnionBlockAVX2(__m256 v0, __m256 v1, __m256 v2, __m256 table, __m256 sum) {
+    const __m256i rotate1 = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    const __m256i rotate2 = _mm256_setr_epi32(2, 3, 4, 5, 6, 7, 0, 1);
+    __m256 type = _mm256_blend_ps(_mm256_blend_ps(v0, v1, 0x92), v2, 0x24);
+    __m256 width = _mm256_blend_ps(_mm256_blend_ps(v0, v1, 0x24), v2, 0x49);
+    __m256 height = _mm256_blend_ps(_mm256_blend_ps(v0, v1, 0x49), v2, 0x92);
+    width = _mm256_permutevar8x32_ps(width, rotate1);
+    height = _mm256_permutevar8x32_ps(height, rotate2);
+    __m256 coeff = _mm256_permutevar8x32_ps(table, _mm256_castps_si256(type));
+    return _mm256_fmadd_ps(_mm256_mul_ps(coeff, width), height, sum);
+}
+
+static f32 UnionSumAVX2(const shape_union* shapes, size_t size, const f32* coefficients) {
+    const __m256 table = _mm256_broadcast_ps((const __m128*)coefficients);
+    const f32* fields = reinterpret_cast<const f32*>(shapes);
+
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 15 < size; i += 16) {
+        const f32* p = fields + 3 * i;
+        _mm_prefetch((const char*)(p + 192), _MM_HINT_T0);
+        sum0 = UnionBlockAVX2(_mm256_loadu_ps(p), _mm256_loadu_ps(p + 8), _mm256_loadu_ps(p + 16), table, sum0);
+        sum1 = UnionBlockAVX2(_mm256_loadu_ps(p + 24), _mm256_loadu_ps(p + 32), _mm256_loadu_ps(p + 40), table, sum1);
+    }
+    for (; i + 7 < size; i += 8) {
+        const f32* p = fields + 3 * i;
+        sum0 = UnionBlockAVX2(_mm256_loadu_ps(p), _mm256_loadu_ps(p + 8), _mm256_loadu_ps(p + 16), table, sum0);
+    }
+
+    // Last 0-7 shapes: masked loads over their 3 * remaining fields. Masked
+    // lanes read as type 0 with zero width, which adds nothing.
+    if (i < size) {
+        const f32* p = fields + 3 * i;
+        size_t floats = 3 * (size - i);
+        __m256 v0 = _mm256_maskload_ps(p, TailMaskAVX2(floats < 8 ? floats : 8));
+        __m256 v1 = _mm256_maskload_ps(p + 8, TailMaskAVX2(floats < 8 ? 0 : floats < 16 ? floats - 8 : 8));
+        __m256 v2 = _mm256_maskload_ps(p + 16, TailMaskAVX2(floats < 16 ? 0 : floats - 16));
+        sum1 = UnionBlockAVX2(v0, v1, v2, table, sum1);
+    }
+    sum0 = _mm256_add_ps(sum0, sum1);
+
+    __m128 sum128 = _mm_add_ps(_mm256_extractf128_ps(sum0, 1), _mm256_castps256_ps128(sum0));
+    sum128 = _mm_hadd_ps(sum128, sum128);
+    sum128 = _mm_hadd_ps(sum128, sum128);
+    return _mm_cvtss_f32(sum128);
+}
+
+static f32 HorizontalSumAVX2(__m256 v) {
+    __m128 sum128 = _mm_add_ps(_mm256_extractf128_ps(v, 1), _mm256_castps256_ps128(v));
+    sum128 = _mm_hadd_ps(sum128, sum128);
+    sum128 = _mm_hadd_ps(sum128, sum128);
+    return _mm_cvtss_f32(sum128);
+}
+
+static double HorizontalSumAVX2(__m256d v) {
+    __m128d sum128 = _mm_add_pd(_mm256_extractf128_pd(v, 1), _mm256_castpd256_pd128(v));
+    return _mm_cvtsd_f64(_mm_hadd_pd(sum128, sum128));
+}
+
+// Accum_F64: each 8-float load is widened into two 4-double accumulators
+static f32 SumF64AVX2(const f32* values, size_t size) {
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d sum2 = _mm256_setzero_pd();
+    __m256d sum3 = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 15 < size; i += 16) {
+        __m256 v0 = _mm256_loadu_ps(&values[i]);
+        __m256 v1 = _mm256_loadu_ps(&values[i + 8]);
+        sum0 = _mm256_add_pd(sum0, _mm256_cvtps_pd(_mm256_castps256_ps128(v0)));
+        sum1 = _mm256_add_pd(sum1, _mm256_cvtps_pd(_mm256_extractf128_ps(v0, 1)));
+        sum2 = _mm256_add_pd(sum2, _mm256_cvtps_pd(_mm256_castps256_ps128(v1)));
+        sum3 = _mm256_add_pd(sum3, _mm256_cvtps_pd(_mm256_extractf128_ps(v1, 1)));
+    }
+    for (; i < size; i += 8) {
+        size_t remaining = size - i;
+        __m256 v = _mm256_maskload_ps(&values[i], TailMaskAVX2(remaining < 8 ? remaining : 8));
+        sum0 = _mm256_add_pd(sum0, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+        sum1 = _mm256_add_pd(sum1, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+    }
+
+    sum0 = _mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3));
+    return static_cast<f32>(HorizontalSumAVX2(sum0));
+}
+
+// Accum_F64 dot product: the product of two widened floats is exact in double
+static void DotF64StepAVX2(__m256d& sum0, __m256d& sum1, __m256 a, __m256 b) {
+    sum0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a)), _mm256_cvtps_pd(_mm256_castps256_ps128(b)), sum0);
+    sum1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)), _mm256_cvtps_pd(_mm256_extractf128_ps(b, 1)), sum1);
+}
+
+static f32 DotF64AVX2(const f32* a, const f32* b, size_t size) {
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d sum2 = _mm256_setzero_pd();
+    __m256d sum3 = _mm256_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 15 < size; i += 16) {
+        DotF64StepAVX2(sum0, sum1, _mm256_loadu_ps(&a[i]), _mm256_loadu_ps(&b[i]));
+        DotF64StepAVX2(sum2, sum3, _mm256_loadu_ps(&a[i + 8]), _mm256_loadu_ps(&b[i + 8]));
+    }
+    for (; i < size; i += 8) {
+        size_t remaining = size - i;
+        __m256i mask = TailMaskAVX2(remaining < 8 ? remaining : 8);
+        DotF64StepAVX2(sum0, sum1, _mm256_maskload_ps(&a[i], mask), _mm256_maskload_ps(&b[i], mask));
+    }
+
+    sum0 = _mm256_add_pd(_mm256_add_pd(sum0, sum1), _mm256_add_pd(sum2, sum3));
+    return static_cast<f32>(HorizontalSumAVX2(sum0));
+}
+
+// One Neumaier step in every lane: sum += x, with the rounding error of the
+// addition collected in compensation
+static void NeumaierAddAVX2(__m256& sum, __m256& compensation, __m256 x) {
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 t = _mm256_add_ps(sum, x);
+    __m256 sum_larger = _mm256_cmp_ps(_mm256_and_ps(sum, abs_mask), _mm256_and_ps(x, abs_mask), _CMP_GE_OQ);
+    __m256 big = _mm256_blendv_ps(x, sum, sum_larger);
+    __m256 small = _mm256_blendv_ps(sum, x, sum_larger);
+    compensation = _mm256_add_ps(compensation, _mm256_add_ps(_mm256_sub_ps(big, t), small));
+    sum = t;
+}
+
+// Lane sums and compensations are combined in double at the end
+static f32 NeumaierResultAVX2(__m256 sum0, __m256 comp0, __m256 sum1, __m256 comp1) {
+    alignas(32) f32 lanes[32];
+    _mm256_store_ps(lanes, sum0);
+    _mm256_store_ps(lanes + 8, comp0);
+    _mm256_store_ps(lanes + 16, sum1);
+    _mm256_store_ps(lanes + 24, comp1);
+    double Accum = 0.0;
+    for (f32 lane : lanes) {
+        Accum += lane;
+    }
+    return static_cast<f32>(Accum);
+}
+
+// Accum_Neumaier: compensated f32 lanes, two independent lane sets
+static f32 SumNeumaierAVX2(const f32* values, size_t size) {
+    __m256 sum0 = _mm256_setzero_ps(), comp0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps(), comp1 = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 15 < size; i += 16) {
+        NeumaierAddAVX2(sum0, comp0, _mm256_loadu_ps(&values[i]));
+        NeumaierAddAVX2(sum1, comp1, _mm256_loadu_ps(&values[i + 8]));
+    }
+    for (; i < size; i += 8) {
+        size_t remaining = size - i;
+        NeumaierAddAVX2(sum0, comp0, _mm256_maskload_ps(&values[i], TailMaskAVX2(remaining < 8 ? remaining : 8)));
+    }
+    return NeumaierResultAVX2(sum0, comp0, sum1, comp1);
+}
+
+// Compensated dot product: FMA recovers the exact rounding error of each
+// product, which goes into the compensation as well
+static void DotNeumaierStepAVX2(__m256& sum, __m256& compensation, __m256 a, __m256 b) {
+    __m256 product = _mm256_mul_ps(a, b);
+    compensation = _mm256_add_ps(compensation, _mm256_fmsub_ps(a, b, product));
+    NeumaierAddAVX2(sum, compensation, product);
+}
+
+static f32 DotNeumaierAVX2(const f32* a, const f32* b, size_t size) {
+    __m256 sum0 = _mm256_setzero_ps(), comp0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps(), comp1 = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 15 < size; i += 16) {
+        DotNeumaierStepAVX2(sum0, comp0, _mm256_loadu_ps(&a[i]), _mm256_loadu_ps(&b[i]));
+        DotNeumaierStepAVX2(sum1, comp1, _mm256_loadu_ps(&a[i + 8]), _mm256_loadu_ps(&b[i + 8]));
+    }
+    for (; i < size; i += 8) {
+        size_t remaining = size - i;
+        __m256i mask = TailMaskAVX2(remaining < 8 ? remaining : 8);
+        DotNeumaierStepAVX2(sum0, comp0, _mm256_maskload_ps(&a[i], mask), _mm256_maskload_ps(&b[i], mask));
+    }
+    return NeumaierResultAVX2(sum0, comp0, sum1, comp1);
+}
+
+// Compact columns: eight values decoded to f32 lanes per load
+static __m256 LoadF32AVX2(const f32* values) {
+    return _mm256_loadu_ps(values);
+}
+
+static __m256 LoadF16AVX2(const u16* values) {
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)values));
+}
+
+// bf16 is the upper half of an f32
+static __m256 LoadBF16AVX2(const u16* values) {
+    __m256i widened = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)values));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(widened, 16));
+}
+
+// Eight weights: u8 indices into the 8-entry table held in one register
+static __m256 LoadLutAVX2(const u8* index, __m256 lut) {
+    __m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)index));
+    return _mm256_permutevar8x32_ps(lut, indices);
+}
+
+// Sum of a compact column; the last 0-7 values are copied into a zeroed
+// block, since the narrow loads have no masked form
+template <class T, __m256 (*Load)(const T*)>
+static f32 CompactSumAVX2(const T* values, size_t size) {
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    __m256 sum2 = _mm256_setzero_ps();
+    __m256 sum3 = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 31 < size; i += 32) {
+        sum0 = _mm256_add_ps(sum0, Load(&values[i]));
+        sum1 = _mm256_add_ps(sum1, Load(&values[i + 8]));
+        sum2 = _mm256_add_ps(sum2, Load(&values[i + 16]));
+        sum3 = _mm256_add_ps(sum3, Load(&values[i + 24]));
+    }
+    for (; i + 7 < size; i += 8) {
+        sum0 = _mm256_add_ps(sum0, Load(&values[i]));
+    }
+    if (i < size) {
+        T tail[8] = {};
+        for (size_t k = 0; i + k < size; ++k) {
+            tail[k] = values[i + k];
+        }
+        sum1 = _mm256_add_ps(sum1, Load(tail));
+    }
+    return HorizontalSumAVX2(_mm256_add_ps(_mm256_add_ps(sum0, sum1), _mm256_add_ps(sum2, sum3)));
+}
+
+// Dot product of a compact area column with table-indexed weights. Padding
+// in the tail has area zero, so the weight it looks up does not matter.
+template <class T, __m256 (*Load)(const T*)>
+static f32 CompactDotLutAVX2(const T* areas, const u8* index, const f32* lut_values, size_t size) {
+    const __m256 lut = _mm256_loadu_ps(lut_values);
+    __m256 sum0 = _mm256_setzero_ps();
+    __m256 sum1 = _mm256_setzero_ps();
+    __m256 sum2 = _mm256_setzero_ps();
+    __m256 sum3 = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 31 < size; i += 32) {
+        sum0 = _mm256_fmadd_ps(Load(&areas[i]), LoadLutAVX2(&index[i], lut), sum0);
+        sum1 = _mm256_fmadd_ps(Load(&areas[i + 8]), LoadLutAVX2(&index[i + 8], lut), sum1);
+        sum2 = _mm256_fmadd_ps(Load(&areas[i + 16]), LoadLutAVX2(&index[i + 16], lut), sum2);
+        sum3 = _mm256_fmadd_ps(Load(&areas[i + 24]), LoadLutAVX2(&index[i + 24], lut), sum3);
+    }
+    for (; i + 7 < size; i += 8) {
+        sum0 = _mm256_fmadd_ps(Load(&areas[i]), LoadLutAVX2(&index[i], lut), sum0);
+    }
+    if (i < size) {
+        T tail_areas[8] = {};
+        u8 tail_index[8] = {};
+        for (size_t k = 0; i + k < size; ++k) {
+            tail_areas[k] = areas[i + k];
+            tail_index[k] = index[i + k];
+        }
+        sum1 = _mm256_fmadd_ps(Load(tail_areas), LoadLutAVX2(tail_index, lut), sum1);
+    }
+    return HorizontalSumAVX2(_mm256_add_ps(_mm256_add_ps(sum0, sum1), _mm256_add_ps(sum2, sum3)));
+}
+
+// One step of the column moments over eight shapes
+static void ColumnMomentsStepAVX2(__m256& product, __m256& sum, __m256& diagonal, __m256 width, __m256 height) {
+    product = _mm256_fmadd_ps(width, height, product);
+    sum = _mm256_add_ps(sum, _mm256_add_ps(width, height));
+    diagonal = _mm256_add_ps(diagonal, _mm256_sqrt_ps(_mm256_fmadd_ps(width, width, _mm256_mul_ps(height, height))));
+}
+
+// Two accumulator sets, 16 shapes per iteration. Masked-off tail lanes load
+// as zero and add zero to all three moments.
+static shape_moments ColumnMomentsAVX2(const f32* width, const f32* height, size_t size) {
+    __m256 product0 = _mm256_setzero_ps(), sum0 = _mm256_setzero_ps(), diagonal0 = _mm256_setzero_ps();
+    __m256 product1 = _mm256_setzero_ps(), sum1 = _mm256_setzero_ps(), diagonal1 = _mm256_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 15 < size; i += 16) {
+        ColumnMomentsStepAVX2(product0, sum0, diagonal0, _mm256_loadu_ps(&width[i]), _mm256_loadu_ps(&height[i]));
+        ColumnMomentsStepAVX2(product1, sum1, diagonal1, _mm256_loadu_ps(&width[i + 8]),
+                              _mm256_loadu_ps(&height[i + 8]));
+    }
+    for (; i < size; i += 8) {
+        size_t remaining = size - i;
+        __m256i mask = TailMaskAVX2(remaining < 8 ? remaining : 8);
+        ColumnMomentsStepAVX2(product0, sum0, diagonal0, _mm256_maskload_ps(&width[i], mask),
+                              _mm256_maskload_ps(&height[i], mask));
+    }
+    return {HorizontalSumAVX2(_mm256_add_ps(product0, product1)), HorizontalSumAVX2(_mm256_add_ps(sum0, sum1)),
+            HorizontalSumAVX2(_mm256_add_ps(diagonal0, diagonal1))};
+}
+
+const simd_kernels* SimdKernelsAVX2() {
+    static const simd_kernels Kernels = {"avx2", SumAVX2<false>, DotAVX2<false>, UnionSumAVX2,
+                                         SumF64AVX2, DotF64AVX2, SumNeumaierAVX2, DotNeumaierAVX2,
+                                         CompactSumAVX2<u16, LoadF16AVX2>, CompactSumAVX2<u16, LoadBF16AVX2>,
+                                         CompactDotLutAVX2<f32, LoadF32AVX2>,
+                                         CompactDotLutAVX2<u16, LoadF16AVX2>,
+                                         CompactDotLutAVX2<u16, LoadBF16AVX2>,
+                                         SumAVX2<true>, DotAVX2<true>, ColumnMomentsAVX2};
+    return &Kernels;
+}
@@ -0,0 +1,323 @@
+// AVX-512F kernels. Built with -mavx512f -mfma and only entered after the CPU
+// check in simd_dispatch.cpp.
+#include <immintrin.h>
+#include "simd_kernels.h"
+
+// Mask of the first 'remaining' (0..16) lanes
+static __mmask16 TailMaskAVX512(size_t remaining) {
+    return static_cast<__mmask16>((1u << remaining) - 1);
+}
+
+// Aligned variants require 64-byte aligned columns: one load per cache line
+template <bool Aligned>
+static __m512 LoadAVX512(const f32* p) {
+    return Aligned ? _mm512_load_ps(p) : _mm512_loadu_ps(p);
+}
+
+// 8-accumulator AVX-512 sum, 128 elements per iteration
+template <bool Aligned>
+static f32 SumAVX512(const f32* values, size_t size) {
+    __m512 sum0 = _mm512_setzero_ps();
+    __m512 sum1 = _mm512_setzero_ps();
+    __m512 sum2 = _mm512_setzero_ps();
+    __m512 sum3 = _mm512_setzero_ps();
+    __m512 sum4 = _mm512_setzero_ps();
+    __m512 sum5 = _mm512_setzero_ps();
+    __m512 sum6 = _mm512_setzero_ps();
+    __m512 sum7 = _mm512_setzero_ps();
+
+    size_t i = 0;
+    const size_t ahead = 2 * PrefetchDistance();
+    for (; i + 127 < size; i += 128) {
+        if (ahead) {
+            _mm_prefetch((const char*)&values[i + ahead], _MM_HINT_T0);
+            _mm_prefetch((const char*)&values[i + ahead + 64], _MM_HINT_T0);
+        }
+
+        sum0 = _mm512_add_ps(sum0, LoadAVX512<Aligned>(&values[i]));
+        sum1 = _mm512_add_ps(sum1, LoadAVX512<Aligned>(&values[i + 16]));
+        sum2 = _mm512_add_ps(sum2, LoadAVX512<Aligned>(&values[i + 32]));
+        sum3 = _mm512_add_ps(sum3, LoadAVX512<Aligned>(&values[i + 48]));
+        sum4 = _mm512_add_ps(sum4, LoadAVX512<Aligned>(&values[i + 64]));
+        sum5 = _mm512_add_ps(sum5, LoadAVX512<Aligned>(&values[i + 80]));
+        sum6 = _mm512_add_ps(sum6, LoadAVX512<Aligned>(&values[i + 96]));
+        sum7 = _mm512_add_ps(sum7, LoadAVX512<Aligned>(&values[i + 112]));
+    }
+
+    sum0 = _mm512_add_ps(_mm512_add_ps(sum0, sum4), _mm512_add_ps(sum1, sum5));
+    sum2 = _mm512_add_ps(_mm512_add_ps(sum2, sum6), _mm512_add_ps(sum3, sum7));
+    sum0 = _mm512_add_ps(sum0, sum2);
+
+    for (; i + 15 < size; i += 16) {
+        sum0 = _mm512_add_ps(sum0, LoadAVX512<Aligned>(&values[i]));
+    }
+    if (i < size) {
+        sum0 = _mm512_add_ps(sum0, _mm512_maskz_loadu_ps(TailMaskAVX512(size - i), &values[i]));
+    }
+    return _mm512_reduce_add_ps(sum0);
+}
+
+// 8-accumulator AVX-512 FMA dot product
+template <bool Aligned>
+static f32 DotAVX512(const f32* a, const f32* b, size_t size) {
+    __m512 sum0 = _mm512_setzero_ps();
+    __m512 sum1 = _mm512_setzero_ps();
+    __m512 sum2 = _mm512_setzero_ps();
+    __m512 sum3 = _mm512_setzero_ps();
+    __m512 sum4 = _mm512_setzero_ps();
+    __m512 sum5 = _mm512_setzero_ps();
+    __m512 sum6 = _mm512_setzero_ps();
+    __m512 sum7 = _mm512_setzero_ps();
+
+    size_t i = 0;
+    const size_t ahead = 2 * PrefetchDistance();
+    for (; i + 127 < size; i += 128) {
+        if (ahead) {
+            _mm_prefetch((const char*)&a[i + ahead], _MM_HINT_T0);
+            _mm_prefetch((const char*)&a[i + ahead + 64], _MM_HINT_T0);
+            _mm_prefetch((const char*)&b[i + ahead], _MM_HINT_T0);
+            _mm_prefetch((const char*)&b[i + ahead + 64], _MM_HINT_T0);
+        }
+
+        sum0 = _mm512_fmadd_ps(LoadAVX512<Aligned>(&a[i]), LoadAVX512<Aligned>(&b[i]), sum0);
+        sum1 = _mm512_fmadd_ps(LoadAVX512<Aligned>(&a[i + 16]), LoadAVX512<Aligned>(&b[i + 16]), sum1);
+        sum2 = _mm512_fmadd_ps(LoadAVX512<Aligned>(&a[i + 32]), LoadAVX512<Aligned>(&b[i + 32]), sum2);
+        sum3 = _mm512_fmadd_ps(LoadAVX512<Aligned>(&a[i + 48]), LoadAVX512<Aligned>(&b[i + 48]), sum3);
+        sum4 = _mm512_fmadd_ps(LoadAVX512<Aligned>(&a[i + 64]), LoadAVX512<Aligned>(&b[i + 64]), sum4);
+        sum5 = _mm512_fmadd_ps(LoadAVX512<Aligned>(&a[i + 80]), LoadAVX512<Aligned>(&b[i + 80]), sum5);
+        sum6 = _mm512_fmadd_ps(LoadAVX512<Aligned>(&a[i + 96]), LoadAVX512<Aligned>(&b[i + 96]), sum6);
+        sum7 = _mm512_fmadd_ps(LoadAVX512<Aligned>(&a[i + 112]), LoadAVX512<Aligned>(&b[i + 112]), sum7);
+    }
+
+    sum0 = _mm512_add_ps(_mm512_add_ps(sum0, sum4), _mm512_add_ps(sum1, sum5));
+    sum2 = _mm512_add_ps(_mm512_add_ps(sum2, sum6), _mm512_add_ps(sum3, sum7));
+    sum0 = _mm512_add_ps(sum0, sum2);
+
+    for (; i + 15 < size; i += 16) {
+        sum0 = _mm512_fmadd_ps(LoadAVX512<Aligned>(&a[i]), LoadAVX512<Aligned>(&b[i]), sum0);
+    }
+    if (i < size) {
+        __mmask16 mask = TailMaskAVX512(size - i);
+        sum0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, &a[i]), _mm512_maskz_loadu_ps(mask, &b[i]), sum0);
+    }
+    return _mm512_reduce_add_ps(sum0);
+}
+
+// Accum_F64: each 16-float load is widened into two 8-double accumulators
+static void AddF64AVX512(__m512d& sum0, __m512d& sum1, __m512 v) {
+    sum0 = _mm512_add_pd(sum0, _mm512_cvtps_pd(_mm512_castps512_ps256(v)));
+    sum1 = _mm512_add_pd(sum1, _mm512_cvtps_pd(_mm256_castsi256_ps(_mm512_extracti64x4_epi64(_mm512_castps_si512(v), 1))));
+}
+
+static f32 SumF64AVX512(const f32* values, size_t size) {
+    __m512d sum0 = _mm512_setzero_pd();
+    __m512d sum1 = _mm512_setzero_pd();
+    __m512d sum2 = _mm512_setzero_pd();
+    __m512d sum3 = _mm512_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 31 < size; i += 32) {
+        AddF64AVX512(sum0, sum1, _mm512_loadu_ps(&values[i]));
+        AddF64AVX512(sum2, sum3, _mm512_loadu_ps(&values[i + 16]));
+    }
+    for (; i < size; i += 16) {
+        size_t remaining = size - i;
+        AddF64AVX512(sum0, sum1, _mm512_maskz_loadu_ps(TailMaskAVX512(remaining < 16 ? remaining : 16), &values[i]));
+    }
+    return static_cast<f32>(_mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(sum0, sum1), _mm512_add_pd(sum2, sum3))));
+}
+
+// Accum_F64 dot product: the product of two widened floats is exact in double
+static void DotF64StepAVX512(__m512d& sum0, __m512d& sum1, __m512 a, __m512 b) {
+    __m256 a_high = _mm256_castsi256_ps(_mm512_extracti64x4_epi64(_mm512_castps_si512(a), 1));
+    __m256 b_high = _mm256_castsi256_ps(_mm512_extracti64x4_epi64(_mm512_castps_si512(b), 1));
+    sum0 = _mm512_fmadd_pd(_mm512_cvtps_pd(_mm512_castps512_ps256(a)), _mm512_cvtps_pd(_mm512_castps512_ps256(b)), sum0);
+    sum1 = _mm512_fmadd_pd(_mm512_cvtps_pd(a_high), _mm512_cvtps_pd(b_high), sum1);
+}
+
+static f32 DotF64AVX512(const f32* a, const f32* b, size_t size) {
+    __m512d sum0 = _mm512_setzero_pd();
+    __m512d sum1 = _mm512_setzero_pd();
+    __m512d sum2 = _mm512_setzero_pd();
+    __m512d sum3 = _mm512_setzero_pd();
+
+    size_t i = 0;
+    for (; i + 31 < size; i += 32) {
+        DotF64StepAVX512(sum0, sum1, _mm512_loadu_ps(&a[i]), _mm512_loadu_ps(&b[i]));
+        DotF64StepAVX512(sum2, sum3, _mm512_loadu_ps(&a[i + 16]), _mm512_loadu_ps(&b[i + 16]));
+    }
+    for (; i < size; i += 16) {
+        size_t remaining = size - i;
+        __mmask16 mask = TailMaskAVX512(remaining < 16 ? remaining : 16);
+        DotF64StepAVX512(sum0, sum1, _mm512_maskz_loadu_ps(mask, &a[i]), _mm512_maskz_loadu_ps(mask, &b[i]));
+    }
+    return static_cast<f32>(_mm512_reduce_add_pd(_mm512_add_pd(_mm512_add_pd(sum0, sum1), _mm512_add_pd(sum2, sum3))));
+}
+
+// One Neumaier step in every lane; the lane masks pick which operand of each
+// addition is the larger one
+static void NeumaierAddAVX512(__m512& sum, __m512& compensation, __m512 x) {
+    __m512 t = _mm512_add_ps(sum, x);
+    __mmask16 sum_larger = _mm512_cmp_ps_mask(_mm512_abs_ps(sum), _mm512_abs_ps(x), _CMP_GE_OQ);
+    __m512 big = _mm512_mask_blend_ps(sum_larger, x, sum);
+    __m512 small = _mm512_mask_blend_ps(sum_larger, sum, x);
+    compensation = _mm512_add_ps(compensation, _mm512_add_ps(_mm512_sub_ps(big, t), small));
+    sum = t;
+}
+
+static void DotNeumaierStepAVX512(__m512& sum, __m512& compensation, __m512 a, __m512 b) {
+    __m512 product = _mm512_mul_ps(a, b);
+    compensation = _mm512_add_ps(compensation, _mm512_fmsub_ps(a, b, product));
+    NeumaierAddAVX512(sum, compensation, product);
+}
+
+// Lane sums and compensations are combined in double at the end
+static f32 NeumaierResultAVX512(__m512 sum0, __m512 comp0, __m512 sum1, __m512 comp1) {
+    alignas(64) f32 lanes[64];
+    _mm512_store_ps(lanes, sum0);
+    _mm512_store_ps(lanes + 16, comp0);
+    _mm512_store_ps(lanes + 32, sum1);
+    _mm512_store_ps(lanes + 48, comp1);
+    double Accum = 0.0;
+    for (f32 lane : lanes) {
+        Accum += lane;
+    }
+    return static_cast<f32>(Accum);
+}
+
+static f32 SumNeumaierAVX512(const f32* values, size_t size) {
+    __m512 sum0 = _mm512_setzero_ps(), comp0 = _mm512_setzero_ps();
+    __m512 sum1 = _mm512_setzero_ps(), comp1 = _mm512_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 31 < size; i += 32) {
+        NeumaierAddAVX512(sum0, comp0, _mm512_loadu_ps(&values[i]));
+        NeumaierAddAVX512(sum1, comp1, _mm512_loadu_ps(&values[i + 16]));
+    }
+    for (; i < size; i += 16) {
+        size_t remaining = size - i;
+        NeumaierAddAVX512(sum0, comp0, _mm512_maskz_loadu_ps(TailMaskAVX512(remaining < 16 ? remaining : 16), &values[i]));
+    }
+    return NeumaierResultAVX512(sum0, comp0, sum1, comp1);
+}
+
+static f32 DotNeumaierAVX512(const f32* a, const f32* b, size_t size) {
+    __m512 sum0 = _mm512_setzero_ps(), comp0 = _mm512_setzero_ps();
+    __m512 sum1 = _mm512_setzero_ps(), comp1 = _mm512_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 31 < size; i += 32) {
+        DotNeumaierStepAVX512(sum0, comp0, _mm512_loadu_ps(&a[i]), _mm512_loadu_ps(&b[i]));
+        DotNeumaierStepAVX512(sum1, comp1, _mm512_loadu_ps(&a[i + 16]), _mm512_loadu_ps(&b[i + 16]));
+    }
+    for (; i < size; i += 16) {
+        size_t remaining = size - i;
+        __mmask16 mask = TailMaskAVX512(remaining < 16 ? remaining : 16);
+        DotNeumaierStepAVX512(sum0, comp0, _mm512_maskz_loadu_ps(mask, &a[i]), _mm512_maskz_loadu_ps(mask, &b[i]));
+    }
+    return NeumaierResultAVX512(sum0, comp0, sum1, comp1);
+}
+
+// Two-step permute indices that pull field k of sixteen consecutive
+// shape_unions out of three registers: field k of shape j sits at float 3j+k.
+// The first step combines v0/v1 (floats 0..31), the second one merges in v2.
+struct deinterleave_indices {
+    alignas(64) int first[3][16];
+    alignas(64) int second[3][16];
+};
+
+static const deinterleave_indices& DeinterleaveIndices() {
+    static const deinterleave_indices indices = [] {
+        deinterleave_indices result = {};
+        for (int k = 0; k < 3; ++k) {
+            for (int j = 0; j < 16; ++j) {
+                int position = 3 * j + k;
+                result.first[k][j] = position < 32 ? position : 0;
+                result.second[k][j] = position < 32 ? j : 16 + position - 32;
+            }
+        }
+        return result;
+    }();
+    return indices;
+}
+
+static __m512 DeinterleaveField(const deinterleave_indices& indices, int k, __m512 v0, __m512 v1, __m512 v2) {
+    __m512 low = _mm512_permutex2var_ps(v0, _mm512_load_si512(indices.first[k]), v1);
+    return _mm512_permutex2var_ps(low, _mm512_load_si512(indices.second[k]), v2);
+}
+
+static __m512 UnionBlockAVX512(const deinterleave_indices& indices, __m512 v0, __m512 v1, __m512 v2,
+                               __m512 table, __m512 sum) {
+    __m512 type = DeinterleaveField(indices, 0, v0, v1, v2);
+    __m512 width = DeinterleaveField(indices, 1, v0, v1, v2);
+    __m512 height = DeinterleaveField(indices, 2, v0, v1, v2);
+    __m512 coeff = _mm512_permutexvar_ps(_mm512_castps_si512(type), table);
+    return _mm512_fmadd_ps(_mm512_mul_ps(coeff, width), height, sum);
+}
+
+// Table-driven sum over the shape_union array, 16 shapes per step
+static f32 UnionSumAVX512(const shape_union* shapes, size_t size, const f32* coefficients) {
+    const deinterleave_indices& indices = DeinterleaveIndices();
+    const __m512 table = _mm512_broadcast_f32x4(_mm_loadu_ps(coefficients));
+    const f32* fields = reinterpret_cast<const f32*>(shapes);
+
+    __m512 sum0 = _mm512_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 15 < size; i += 16) {
+        const f32* p = fields + 3 * i;
+        _mm_prefetch((const char*)(p + 192), _MM_HINT_T0);
+        sum0 = UnionBlockAVX512(indices, _mm512_loadu_ps(p), _mm512_loadu_ps(p + 16), _mm512_loadu_ps(p + 32),
+                                table, sum0);
+    }
+
+    // Last 0-15 shapes through masked loads; masked lanes read as zero width
+    if (i < size) {
+        const f32* p = fields + 3 * i;
+        size_t floats = 3 * (size - i);
+        __m512 v0 = _mm512_maskz_loadu_ps(TailMaskAVX512(floats < 16 ? floats : 16), p);
+        __m512 v1 = _mm512_maskz_loadu_ps(TailMaskAVX512(floats < 16 ? 0 : floats < 32 ? floats - 16 : 16), p + 16);
+        __m512 v2 = _mm512_maskz_loadu_ps(TailMaskAVX512(floats < 32 ? 0 : floats - 32), p + 32);
+        sum0 = UnionBlockAVX512(indices, v0, v1, v2, table, sum0);
+    }
+    return _mm512_reduce_add_ps(sum0);
+}
+
+// One step of the column moments over sixteen shapes
+static void ColumnMomentsStepAVX512(__m512& product, __m512& sum, __m512& diagonal, __m512 width, __m512 height) {
+    product = _mm512_fmadd_ps(width, height, product);
+    sum = _mm512_add_ps(sum, _mm512_add_ps(width, height));
+    diagonal = _mm512_add_ps(diagonal, _mm512_sqrt_ps(_mm512_fmadd_ps(width, width, _mm512_mul_ps(height, height))));
+}
+
+// Two accumulator sets, 32 shapes per iteration; the last 0-15 shapes
+// through masked loads
+static shape_moments ColumnMomentsAVX512(const f32* width, const f32* height, size_t size) {
+    __m512 product0 = _mm512_setzero_ps(), sum0 = _mm512_setzero_ps(), diagonal0 = _mm512_setzero_ps();
+    __m512 product1 = _mm512_setzero_ps(), sum1 = _mm512_setzero_ps(), diagonal1 = _mm512_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 31 < size; i += 32) {
+        ColumnMomentsStepAVX512(product0, sum0, diagonal0, _mm512_loadu_ps(&width[i]), _mm512_loadu_ps(&height[i]));
+        ColumnMomentsStepAVX512(product1, sum1, diagonal1, _mm512_loadu_ps(&width[i + 16]),
+                                _mm512_loadu_ps(&height[i + 16]));
+    }
+    for (; i + 15 < size; i += 16) {
+        ColumnMomentsStepAVX512(product0, sum0, diagonal0, _mm512_loadu_ps(&width[i]), _mm512_loadu_ps(&height[i]));
+    }
+    if (i < size) {
+        __mmask16 mask = TailMaskAVX512(size - i);
+        ColumnMomentsStepAVX512(product1, sum1, diagonal1, _mm512_maskz_loadu_ps(mask, &width[i]),
+                                _mm512_maskz_loadu_ps(mask, &height[i]));
+    }
+    return {_mm512_reduce_add_ps(_mm512_add_ps(product0, product1)), _mm512_reduce_add_ps(_mm512_add_ps(sum0, sum1)),
+            _mm512_reduce_add_ps(_mm512_add_ps(diagonal0, diagonal1))};
+}
+
+const simd_kernels* SimdKernelsAVX512() {
+    static const simd_kernels Kernels = {"avx512", SumAVX512<false>, DotAVX512<false>, UnionSumAVX512,
+                                         SumF64AVX512, DotF64AVX512, SumNeumaierAVX512, DotNeumaierAVX512,
+                                         nullptr, nullptr, nullptr, nullptr, nullptr,
+                                         SumAVX512<true>, DotAVX512<true>, ColumnMomentsAVX512};
+    return &Kernels;
+}
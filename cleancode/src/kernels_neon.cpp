@@ -0,0 +1,161 @@
+// NEON kernels for aarch64 (Graviton). Advanced SIMD is mandatory on aarch64,
+// so this variant needs no runtime check.
+#include <arm_neon.h>
+#include "simd_kernels.h"
+
+// 8-accumulator NEON sum, 32 elements per iteration
+static f32 SumNEON(const f32* values, size_t size) {
+    float32x4_t sum0 = vdupq_n_f32(0.0f);
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    float32x4_t sum2 = vdupq_n_f32(0.0f);
+    float32x4_t sum3 = vdupq_n_f32(0.0f);
+    float32x4_t sum4 = vdupq_n_f32(0.0f);
+    float32x4_t sum5 = vdupq_n_f32(0.0f);
+    float32x4_t sum6 = vdupq_n_f32(0.0f);
+    float32x4_t sum7 = vdupq_n_f32(0.0f);
+
+    size_t i = 0;
+    for (; i + 31 < size; i += 32) {
+        __builtin_prefetch(&values[i + 128]);
+
+        sum0 = vaddq_f32(sum0, vld1q_f32(&values[i]));
+        sum1 = vaddq_f32(sum1, vld1q_f32(&values[i + 4]));
+        sum2 = vaddq_f32(sum2, vld1q_f32(&values[i + 8]));
+        sum3 = vaddq_f32(sum3, vld1q_f32(&values[i + 12]));
+        sum4 = vaddq_f32(sum4, vld1q_f32(&values[i + 16]));
+        sum5 = vaddq_f32(sum5, vld1q_f32(&values[i + 20]));
+        sum6 = vaddq_f32(sum6, vld1q_f32(&values[i + 24]));
+        sum7 = vaddq_f32(sum7, vld1q_f32(&values[i + 28]));
+    }
+
+    sum0 = vaddq_f32(vaddq_f32(sum0, sum4), vaddq_f32(sum1, sum5));
+    sum2 = vaddq_f32(vaddq_f32(sum2, sum6), vaddq_f32(sum3, sum7));
+    sum0 = vaddq_f32(sum0, sum2);
+
+    for (; i + 3 < size; i += 4) {
+        sum0 = vaddq_f32(sum0, vld1q_f32(&values[i]));
+    }
+
+    // NEON has no masked loads; the last 0-3 elements stay scalar
+    f32 Accum = vaddvq_f32(sum0);
+    for (; i < size; ++i) {
+        Accum += values[i];
+    }
+    return Accum;
+}
+
+// 8-accumulator NEON FMA dot product
+static f32 DotNEON(const f32* a, const f32* b, size_t size) {
+    float32x4_t sum0 = vdupq_n_f32(0.0f);
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+    float32x4_t sum2 = vdupq_n_f32(0.0f);
+    float32x4_t sum3 = vdupq_n_f32(0.0f);
+    float32x4_t sum4 = vdupq_n_f32(0.0f);
+    float32x4_t sum5 = vdupq_n_f32(0.0f);
+    float32x4_t sum6 = vdupq_n_f32(0.0f);
+    float32x4_t sum7 = vdupq_n_f32(0.0f);
+
+    size_t i = 0;
+    for (; i + 31 < size; i += 32) {
+        __builtin_prefetch(&a[i + 128]);
+        __builtin_prefetch(&b[i + 128]);
+
+        sum0 = vfmaq_f32(sum0, vld1q_f32(&a[i]), vld1q_f32(&b[i]));
+        sum1 = vfmaq_f32(sum1, vld1q_f32(&a[i + 4]), vld1q_f32(&b[i + 4]));
+        sum2 = vfmaq_f32(sum2, vld1q_f32(&a[i + 8]), vld1q_f32(&b[i + 8]));
+        sum3 = vfmaq_f32(sum3, vld1q_f32(&a[i + 12]), vld1q_f32(&b[i + 12]));
+        sum4 = vfmaq_f32(sum4, vld1q_f32(&a[i + 16]), vld1q_f32(&b[i + 16]));
+        sum5 = vfmaq_f32(sum5, vld1q_f32(&a[i + 20]), vld1q_f32(&b[i + 20]));
+        sum6 = vfmaq_f32(sum6, vld1q_f32(&a[i + 24]), vld1q_f32(&b[i + 24]));
+        sum7 = vfmaq_f32(sum7, vld1q_f32(&a[i + 28]), vld1q_f32(&b[i + 28]));
+    }
+
+    sum0 = vaddq_f32(vaddq_f32(sum0, sum4), vaddq_f32(sum1, sum5));
+    sum2 = vaddq_f32(vaddq_f32(sum2, sum6), vaddq_f32(sum3, sum7));
+    sum0 = vaddq_f32(sum0, sum2);
+
+    for (; i + 3 < size; i += 4) {
+        sum0 = vfmaq_f32(sum0, vld1q_f32(&a[i]), vld1q_f32(&b[i]));
+    }
+
+    // NEON has no masked loads; the last 0-3 elements stay scalar
+    f32 Accum = vaddvq_f32(sum0);
+    for (; i < size; ++i) {
+        Accum += a[i] * b[i];
+    }
+    return Accum;
+}
+
+// Table-driven sum over the shape_union array. vld3q deinterleaves four
+// shapes; the coefficient table is a 16-byte register indexed per byte.
+static f32 UnionSumNEON(const shape_union* shapes, size_t size, const f32* coefficients) {
+    const uint8x16_t table = vreinterpretq_u8_f32(vld1q_f32(coefficients));
+    const uint32x4_t byte_offsets = vdupq_n_u32(0x03020100);
+    const f32* fields = reinterpret_cast<const f32*>(shapes);
+
+    float32x4_t sum0 = vdupq_n_f32(0.0f);
+    float32x4_t sum1 = vdupq_n_f32(0.0f);
+
+    size_t i = 0;
+    for (; i + 7 < size; i += 8) {
+        const f32* p = fields + 3 * i;
+        __builtin_prefetch(p + 96);
+
+        float32x4x3_t v = vld3q_f32(p);
+        uint32x4_t bytes = vmlaq_n_u32(byte_offsets, vreinterpretq_u32_f32(v.val[0]), 0x04040404);
+        float32x4_t coeff = vreinterpretq_f32_u8(vqtbl1q_u8(table, vreinterpretq_u8_u32(bytes)));
+        sum0 = vfmaq_f32(sum0, vmulq_f32(coeff, v.val[1]), v.val[2]);
+
+        v = vld3q_f32(p + 12);
+        bytes = vmlaq_n_u32(byte_offsets, vreinterpretq_u32_f32(v.val[0]), 0x04040404);
+        coeff = vreinterpretq_f32_u8(vqtbl1q_u8(table, vreinterpretq_u8_u32(bytes)));
+        sum1 = vfmaq_f32(sum1, vmulq_f32(coeff, v.val[1]), v.val[2]);
+    }
+
+    f32 Accum = vaddvq_f32(vaddq_f32(sum0, sum1));
+    for (; i < size; ++i) {
+        Accum += coefficients[shapes[i].Type] * shapes[i].Width * shapes[i].Height;
+    }
+    return Accum;
+}
+
+// One step of the column moments over four shapes
+static void ColumnMomentsStepNEON(float32x4_t& product, float32x4_t& sum, float32x4_t& diagonal, float32x4_t width,
+                                  float32x4_t height) {
+    product = vfmaq_f32(product, width, height);
+    sum = vaddq_f32(sum, vaddq_f32(width, height));
+    diagonal = vaddq_f32(diagonal, vsqrtq_f32(vfmaq_f32(vmulq_f32(height, height), width, width)));
+}
+
+// Two accumulator sets, 8 shapes per iteration
+static shape_moments ColumnMomentsNEON(const f32* width, const f32* height, size_t size) {
+    float32x4_t product0 = vdupq_n_f32(0.0f), sum0 = vdupq_n_f32(0.0f), diagonal0 = vdupq_n_f32(0.0f);
+    float32x4_t product1 = vdupq_n_f32(0.0f), sum1 = vdupq_n_f32(0.0f), diagonal1 = vdupq_n_f32(0.0f);
+
+    size_t i = 0;
+    for (; i + 7 < size; i += 8) {
+        ColumnMomentsStepNEON(product0, sum0, diagonal0, vld1q_f32(&width[i]), vld1q_f32(&height[i]));
+        ColumnMomentsStepNEON(product1, sum1, diagonal1, vld1q_f32(&width[i + 4]), vld1q_f32(&height[i + 4]));
+    }
+    for (; i + 3 < size; i += 4) {
+        ColumnMomentsStepNEON(product0, sum0, diagonal0, vld1q_f32(&width[i]), vld1q_f32(&height[i]));
+    }
+
+    // The last 0-3 shapes stay scalar
+    shape_moments Moments = {vaddvq_f32(vaddq_f32(product0, product1)), vaddvq_f32(vaddq_f32(sum0, sum1)),
+                             vaddvq_f32(vaddq_f32(diagonal0, diagonal1))};
+    for (; i < size; ++i) {
+        Moments.Product += width[i] * height[i];
+        Moments.Sum += width[i] + height[i];
+        Moments.Diagonal += vget_lane_f32(vsqrt_f32(vdup_n_f32(width[i] * width[i] + height[i] * height[i])), 0);
+    }
+    return Moments;
+}
+
+const simd_kernels* SimdKernelsNEON() {
+    static const simd_kernels Kernels = {"neon", SumNEON, DotNEON, UnionSumNEON,
+                                         nullptr, nullptr, nullptr, nullptr,
+                                         nullptr, nullptr, nullptr, nullptr, nullptr,
+                                         nullptr, nullptr, ColumnMomentsNEON};
+    return &Kernels;
+}
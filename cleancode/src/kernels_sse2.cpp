@@ -0,0 +1,154 @@
+// SSE2 kernels: the x86-64 baseline, safe on every node of the fleet.
+#include <emmintrin.h>
+#include "simd_kernels.h"
+
+// Horizontal sum without SSE3 hadd
+static f32 HorizontalSumSSE2(__m128 v) {
+    __m128 high = _mm_movehl_ps(v, v);
+    v = _mm_add_ps(v, high);
+    high = _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+    v = _mm_add_ss(v, high);
+    return _mm_cvtss_f32(v);
+}
+
+// 8-accumulator SSE sum, 32 elements per iteration
+static f32 SumSSE2(const f32* values, size_t size) {
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    __m128 sum2 = _mm_setzero_ps();
+    __m128 sum3 = _mm_setzero_ps();
+    __m128 sum4 = _mm_setzero_ps();
+    __m128 sum5 = _mm_setzero_ps();
+    __m128 sum6 = _mm_setzero_ps();
+    __m128 sum7 = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 31 < size; i += 32) {
+        _mm_prefetch((const char*)&values[i + 128], _MM_HINT_T0);
+        _mm_prefetch((const char*)&values[i + 144], _MM_HINT_T0);
+
+        sum0 = _mm_add_ps(sum0, _mm_loadu_ps(&values[i]));
+        sum1 = _mm_add_ps(sum1, _mm_loadu_ps(&values[i + 4]));
+        sum2 = _mm_add_ps(sum2, _mm_loadu_ps(&values[i + 8]));
+        sum3 = _mm_add_ps(sum3, _mm_loadu_ps(&values[i + 12]));
+        sum4 = _mm_add_ps(sum4, _mm_loadu_ps(&values[i + 16]));
+        sum5 = _mm_add_ps(sum5, _mm_loadu_ps(&values[i + 20]));
+        sum6 = _mm_add_ps(sum6, _mm_loadu_ps(&values[i + 24]));
+        sum7 = _mm_add_ps(sum7, _mm_loadu_ps(&values[i + 28]));
+    }
+
+    sum0 = _mm_add_ps(_mm_add_ps(sum0, sum4), _mm_add_ps(sum1, sum5));
+    sum2 = _mm_add_ps(_mm_add_ps(sum2, sum6), _mm_add_ps(sum3, sum7));
+    sum0 = _mm_add_ps(sum0, sum2);
+
+    for (; i + 3 < size; i += 4) {
+        sum0 = _mm_add_ps(sum0, _mm_loadu_ps(&values[i]));
+    }
+
+    // SSE2 has no masked loads; the last 0-3 elements stay scalar
+    f32 Accum = HorizontalSumSSE2(sum0);
+    for (; i < size; ++i) {
+        Accum += values[i];
+    }
+    return Accum;
+}
+
+// 8-accumulator SSE dot product; no FMA on this level, so mul + add
+static f32 DotSSE2(const f32* a, const f32* b, size_t size) {
+    __m128 sum0 = _mm_setzero_ps();
+    __m128 sum1 = _mm_setzero_ps();
+    __m128 sum2 = _mm_setzero_ps();
+    __m128 sum3 = _mm_setzero_ps();
+    __m128 sum4 = _mm_setzero_ps();
+    __m128 sum5 = _mm_setzero_ps();
+    __m128 sum6 = _mm_setzero_ps();
+    __m128 sum7 = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 31 < size; i += 32) {
+        _mm_prefetch((const char*)&a[i + 128], _MM_HINT_T0);
+        _mm_prefetch((const char*)&b[i + 128], _MM_HINT_T0);
+
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(&a[i]), _mm_loadu_ps(&b[i])));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(&a[i + 4]), _mm_loadu_ps(&b[i + 4])));
+        sum2 = _mm_add_ps(sum2, _mm_mul_ps(_mm_loadu_ps(&a[i + 8]), _mm_loadu_ps(&b[i + 8])));
+        sum3 = _mm_add_ps(sum3, _mm_mul_ps(_mm_loadu_ps(&a[i + 12]), _mm_loadu_ps(&b[i + 12])));
+        sum4 = _mm_add_ps(sum4, _mm_mul_ps(_mm_loadu_ps(&a[i + 16]), _mm_loadu_ps(&b[i + 16])));
+        sum5 = _mm_add_ps(sum5, _mm_mul_ps(_mm_loadu_ps(&a[i + 20]), _mm_loadu_ps(&b[i + 20])));
+        sum6 = _mm_add_ps(sum6, _mm_mul_ps(_mm_loadu_ps(&a[i + 24]), _mm_loadu_ps(&b[i + 24])));
+        sum7 = _mm_add_ps(sum7, _mm_mul_ps(_mm_loadu_ps(&a[i + 28]), _mm_loadu_ps(&b[i + 28])));
+    }
+
+    sum0 = _mm_add_ps(_mm_add_ps(sum0, sum4), _mm_add_ps(sum1, sum5));
+    sum2 = _mm_add_ps(_mm_add_ps(sum2, sum6), _mm_add_ps(sum3, sum7));
+    sum0 = _mm_add_ps(sum0, sum2);
+
+    for (; i + 3 < size; i += 4) {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(&a[i]), _mm_loadu_ps(&b[i])));
+    }
+
+    // SSE2 has no masked loads; the last 0-3 elements stay scalar
+    f32 Accum = HorizontalSumSSE2(sum0);
+    for (; i < size; ++i) {
+        Accum += a[i] * b[i];
+    }
+    return Accum;
+}
+
+// SSE2 has no variable permute for the coefficient lookup, so this level
+// keeps four scalar chains
+static f32 UnionSumSSE2(const shape_union* shapes, size_t size, const f32* coefficients) {
+    f32 Accum0 = 0.0f, Accum1 = 0.0f, Accum2 = 0.0f, Accum3 = 0.0f;
+    size_t i = 0;
+    for (; i + 3 < size; i += 4) {
+        Accum0 += coefficients[shapes[i].Type] * shapes[i].Width * shapes[i].Height;
+        Accum1 += coefficients[shapes[i + 1].Type] * shapes[i + 1].Width * shapes[i + 1].Height;
+        Accum2 += coefficients[shapes[i + 2].Type] * shapes[i + 2].Width * shapes[i + 2].Height;
+        Accum3 += coefficients[shapes[i + 3].Type] * shapes[i + 3].Width * shapes[i + 3].Height;
+    }
+    for (; i < size; ++i) {
+        Accum0 += coefficients[shapes[i].Type] * shapes[i].Width * shapes[i].Height;
+    }
+    return Accum0 + Accum1 + Accum2 + Accum3;
+}
+
+// One step of the column moments over four shapes; no FMA on this level
+static void ColumnMomentsStepSSE2(__m128& product, __m128& sum, __m128& diagonal, __m128 width, __m128 height) {
+    product = _mm_add_ps(product, _mm_mul_ps(width, height));
+    sum = _mm_add_ps(sum, _mm_add_ps(width, height));
+    diagonal = _mm_add_ps(diagonal, _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(width, width), _mm_mul_ps(height, height))));
+}
+
+// Two accumulator sets, 8 shapes per iteration
+static shape_moments ColumnMomentsSSE2(const f32* width, const f32* height, size_t size) {
+    __m128 product0 = _mm_setzero_ps(), sum0 = _mm_setzero_ps(), diagonal0 = _mm_setzero_ps();
+    __m128 product1 = _mm_setzero_ps(), sum1 = _mm_setzero_ps(), diagonal1 = _mm_setzero_ps();
+
+    size_t i = 0;
+    for (; i + 7 < size; i += 8) {
+        ColumnMomentsStepSSE2(product0, sum0, diagonal0, _mm_loadu_ps(&width[i]), _mm_loadu_ps(&height[i]));
+        ColumnMomentsStepSSE2(product1, sum1, diagonal1, _mm_loadu_ps(&width[i + 4]), _mm_loadu_ps(&height[i + 4]));
+    }
+    for (; i + 3 < size; i += 4) {
+        ColumnMomentsStepSSE2(product0, sum0, diagonal0, _mm_loadu_ps(&width[i]), _mm_loadu_ps(&height[i]));
+    }
+
+    // The last 0-3 shapes stay scalar
+    shape_moments Moments = {HorizontalSumSSE2(_mm_add_ps(product0, product1)),
+                             HorizontalSumSSE2(_mm_add_ps(sum0, sum1)),
+                             HorizontalSumSSE2(_mm_add_ps(diagonal0, diagonal1))};
+    for (; i < size; ++i) {
+        Moments.Product += width[i] * height[i];
+        Moments.Sum += width[i] + height[i];
+        Moments.Diagonal += _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(width[i] * width[i] + height[i] * height[i])));
+    }
+    return Moments;
+}
+
+const simd_kernels* SimdKernelsSSE2() {
+    static const simd_kernels Kernels = {"sse2", SumSSE2, DotSSE2, UnionSumSSE2,
+                                         nullptr, nullptr, nullptr, nullptr,
+                                         nullptr, nullptr, nullptr, nullptr, nullptr,
+                                         nullptr, nullptr, ColumnMomentsSSE2};
+    return &Kernels;
+}
@@ -0,0 +1,232 @@
+#include "numa_collector.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "simd_kernels.h"
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+// Shapes per work item; as for the parallel reductions, a fixed size keeps
+// the order of the partial sums independent of the thread count
+constexpr size_t NumaChunkSize = 32 * 1024;
+
+// Parses a sysfs cpulist such as "0-3,8-11"
+static std::vector<int> ParseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ranges(list);
+    std::string range;
+    while (std::getline(ranges, range, ',')) {
+        if (range.empty()) {
+            continue;
+        }
+        size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::vector<numa_node> NumaNodes() {
+    std::vector<numa_node> nodes;
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string node_list;
+    if (online && std::getline(online, node_list)) {
+        for (int id : ParseCpuList(node_list)) {
+            std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+            std::string cpus;
+            if (cpulist && std::getline(cpulist, cpus) && !cpus.empty()) {
+                nodes.push_back({static_cast<u32>(id), ParseCpuList(cpus)});
+            }
+        }
+    }
+    if (nodes.empty()) {
+        numa_node all{0, {}};
+        for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) {
+            all.Cpus.push_back(static_cast<int>(cpu));
+        }
+        nodes.push_back(all);
+    }
+    return nodes;
+}
+
+// An anonymous mapping is backed lazily, page by page, on first write; the
+// heap may hand out memory another thread already touched
+page_buffer::page_buffer(size_t count) : Bytes(count * sizeof(f32)) {
+    if (Bytes == 0) {
+        return;
+    }
+#if defined(__linux__)
+    void* p = mmap(nullptr, Bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    Data = static_cast<f32*>(p);
+#else
+    Data = static_cast<f32*>(::operator new(Bytes));
+#endif
+}
+
+page_buffer::~page_buffer() {
+    if (Data) {
+#if defined(__linux__)
+        munmap(Data, Bytes);
+#else
+        ::operator delete(Data);
+#endif
+    }
+}
+
+page_buffer::page_buffer(page_buffer&& other) noexcept : Data(other.Data), Bytes(other.Bytes) {
+    other.Data = nullptr;
+    other.Bytes = 0;
+}
+
+page_buffer& page_buffer::operator=(page_buffer&& other) noexcept {
+    std::swap(Data, other.Data);
+    std::swap(Bytes, other.Bytes);
+    return *this;
+}
+
+static std::vector<u32> AllSegments(u32 count) {
+    std::vector<u32> all(count);
+    for (u32 n = 0; n < count; ++n) {
+        all[n] = n;
+    }
+    return all;
+}
+
+// The pools get one worker per CPU of the node; the thread calling run()
+// only waits, so every chunk runs on a worker of the intended node
+NumaCornerCollector::NumaCornerCollector(const std::vector<numa_node>& nodes) {
+    segments.resize(nodes.size());
+    for (size_t n = 0; n < nodes.size(); ++n) {
+        segments[n].Node = nodes[n];
+        unsigned workers = static_cast<unsigned>(std::max<size_t>(1, nodes[n].Cpus.size()));
+        segments[n].Pool = std::make_unique<ThreadPool>(workers + 1, nodes[n].Cpus);
+    }
+}
+
+void NumaCornerCollector::run(const std::vector<u32>& which, u32 reader,
+                              const std::function<void(u32, size_t, size_t)>& fn) {
+    struct latch {
+        size_t remaining = 0;
+        std::mutex mutex;
+        std::condition_variable finished;
+    } done;
+
+    for (u32 n : which) {
+        done.remaining += (segments[n].Count + NumaChunkSize - 1) / NumaChunkSize;
+    }
+    for (u32 n : which) {
+        ThreadPool& pool = *segments[reader == AllNodes ? n : reader].Pool;
+        for (size_t begin = 0; begin < segments[n].Count; begin += NumaChunkSize) {
+            size_t count = std::min(NumaChunkSize, segments[n].Count - begin);
+            pool.submit([&, n, begin, count] {
+                fn(n, begin, count);
+                std::lock_guard<std::mutex> lock(done.mutex);
+                if (--done.remaining == 0) {
+                    done.finished.notify_one();
+                }
+            });
+        }
+    }
+    std::unique_lock<std::mutex> lock(done.mutex);
+    done.finished.wait(lock, [&] { return done.remaining == 0; });
+}
+
+void NumaCornerCollector::assign(u32 ShapeCount, shape_base** Shapes) {
+    size_t cpus = 0;
+    for (const segment& s : segments) {
+        cpus += std::max<size_t>(1, s.Node.Cpus.size());
+    }
+
+    // Segment boundaries on chunk multiples, the last segment takes the rest
+    std::vector<size_t> offsets(segments.size());
+    size_t offset = 0, cpus_before = 0;
+    for (u32 n = 0; n < segments.size(); ++n) {
+        cpus_before += std::max<size_t>(1, segments[n].Node.Cpus.size());
+        size_t end = n + 1 == segments.size()
+                         ? ShapeCount
+                         : std::min<size_t>(ShapeCount, ShapeCount * cpus_before / cpus / NumaChunkSize * NumaChunkSize);
+        end = std::max(end, offset);
+        segment& s = segments[n];
+        s.Count = end - offset;
+        s.Areas = page_buffer(s.Count);
+        s.Weights = page_buffer(s.Count);
+        offsets[n] = offset;
+        offset = end;
+    }
+    Size = ShapeCount;
+
+    run(AllSegments(nodeCount()), AllNodes, [&](u32 n, size_t begin, size_t count) {
+        segment& s = segments[n];
+        std::vector<u8> corner_counts(count);
+        CollectShapes(static_cast<u32>(count), Shapes + offsets[n] + begin, s.Areas.data() + begin,
+                      corner_counts.data());
+        f32* weights = s.Weights.data() + begin;
+        for (size_t i = 0; i < count; ++i) {
+            weights[i] = CornerWeight(corner_counts[i]);
+        }
+    });
+}
+
+f32 NumaCornerCollector::reduce(const std::vector<u32>& which, u32 reader, bool weighted) {
+    const simd_kernels& kernels = SimdKernels();
+    std::vector<size_t> first(which.size());
+    size_t chunks = 0;
+    for (size_t i = 0; i < which.size(); ++i) {
+        first[i] = chunks;
+        chunks += (segments[which[i]].Count + NumaChunkSize - 1) / NumaChunkSize;
+    }
+    std::vector<u32> slot_of(segments.size());
+    for (size_t i = 0; i < which.size(); ++i) {
+        slot_of[which[i]] = static_cast<u32>(i);
+    }
+
+    std::vector<f32> partials(chunks);
+    run(which, reader, [&](u32 n, size_t begin, size_t count) {
+        const segment& s = segments[n];
+        // Segments are page aligned and chunks start at multiples of NumaChunkSize
+        f32 partial = weighted ? kernels.dot_aligned(s.Areas.data() + begin, s.Weights.data() + begin, count)
+                               : kernels.sum_aligned(s.Areas.data() + begin, count);
+        partials[first[slot_of[n]] + begin / NumaChunkSize] = partial;
+    });
+
+    double Accum = 0.0;
+    for (f32 partial : partials) {
+        Accum += partial;
+    }
+    return static_cast<f32>(Accum);
+}
+
+f32 NumaCornerCollector::totalArea() {
+    INSTRUMENT_SCOPE("NumaCornerCollector::totalArea", size(), size() * sizeof(f32));
+    return reduce(AllSegments(nodeCount()), AllNodes, false);
+}
+
+f32 NumaCornerCollector::cornerArea() {
+    INSTRUMENT_SCOPE("NumaCornerCollector::cornerArea", size(), size() * 2 * sizeof(f32));
+    return reduce(AllSegments(nodeCount()), AllNodes, true);
+}
+
+f32 NumaCornerCollector::segmentTotalArea(u32 n, u32 reader) {
+    INSTRUMENT_SCOPE("NumaCornerCollector::segmentTotalArea", segments[n].Count, segments[n].Count * sizeof(f32));
+    return reduce({n}, reader, false);
+}
+
+f32 NumaCornerCollector::segmentCornerArea(u32 n, u32 reader) {
+    INSTRUMENT_SCOPE("NumaCornerCollector::segmentCornerArea", segments[n].Count,
+                     segments[n].Count * 2 * sizeof(f32));
+    return reduce({n}, reader, true);
+}
@@ -1,200 +1,157 @@
 #include "shapes.h"
+#include "instrumentation.h"
 #include <algorithm>
-#include <immintrin.h> // For SIMD vector instructions
-
-
-// Collector-based functions for benchmarking
-f32 TotalAreaCollector(AreaCollector& collector) {
-    // Use SIMD for faster summation
-    const size_t size = collector.areas.size();
-    const f32* areas = collector.areas.data();
-    
-    // Use 8 accumulators for even better pipelining and to utilize more registers
-    __m256 sum0 = _mm256_setzero_ps();
-    __m256 sum1 = _mm256_setzero_ps();
-    __m256 sum2 = _mm256_setzero_ps();
-    __m256 sum3 = _mm256_setzero_ps();
-    __m256 sum4 = _mm256_setzero_ps();
-    __m256 sum5 = _mm256_setzero_ps();
-    __m256 sum6 = _mm256_setzero_ps();
-    __m256 sum7 = _mm256_setzero_ps();
-    
-    // Process 64 elements at a time - further unrolled loop with prefetching
-    size_t i = 0;
-    
-    // For very large arrays, first prefetch ahead
-    if (size >= 128) {
-        _mm_prefetch((const char*)&areas[64], _MM_HINT_T0);
-        _mm_prefetch((const char*)&areas[96], _MM_HINT_T0);
-    }
-    
-    for (; i + 63 < size; i += 64) {
-        // Prefetch next iterations to L1 cache
-        _mm_prefetch((const char*)&areas[i + 128], _MM_HINT_T0);
-        _mm_prefetch((const char*)&areas[i + 160], _MM_HINT_T0);
-        
-        // Fully unrolled loop for 64 elements with 8 accumulators
-        // This eliminates loop overhead and maximizes instruction-level parallelism
-        sum0 = _mm256_add_ps(sum0, _mm256_loadu_ps(&areas[i]));
-        sum1 = _mm256_add_ps(sum1, _mm256_loadu_ps(&areas[i + 8]));
-        sum2 = _mm256_add_ps(sum2, _mm256_loadu_ps(&areas[i + 16]));
-        sum3 = _mm256_add_ps(sum3, _mm256_loadu_ps(&areas[i + 24]));
-        sum4 = _mm256_add_ps(sum4, _mm256_loadu_ps(&areas[i + 32]));
-        sum5 = _mm256_add_ps(sum5, _mm256_loadu_ps(&areas[i + 40]));
-        sum6 = _mm256_add_ps(sum6, _mm256_loadu_ps(&areas[i + 48]));
-        sum7 = _mm256_add_ps(sum7, _mm256_loadu_ps(&areas[i + 56]));
-    }
-    
-    // Combine the 8 accumulators into 4
-    sum0 = _mm256_add_ps(sum0, sum4);
-    sum1 = _mm256_add_ps(sum1, sum5);
-    sum2 = _mm256_add_ps(sum2, sum6);
-    sum3 = _mm256_add_ps(sum3, sum7);
-    
-    // Combine the 4 accumulators into 2
-    sum0 = _mm256_add_ps(sum0, sum1);
-    sum2 = _mm256_add_ps(sum2, sum3);
-    
-    // Combine the 2 accumulators into 1
-    sum0 = _mm256_add_ps(sum0, sum2);
-    
-    // Now process 8 elements at a time for remaining data
-    for (; i + 7 < size; i += 8) {
-        sum0 = _mm256_add_ps(sum0, _mm256_loadu_ps(&areas[i]));
-    }
-    
-    // Extract result from AVX register using more efficient horizontal sum
-    __m128 high128 = _mm256_extractf128_ps(sum0, 1);
-    __m128 low128 = _mm256_castps256_ps128(sum0);
-    __m128 sum128 = _mm_add_ps(high128, low128);
-    
-    // Horizontal sum of 128-bit SSE vector - optimized version
-    sum128 = _mm_hadd_ps(sum128, sum128);
-    sum128 = _mm_hadd_ps(sum128, sum128);
-    
-    f32 Accum = _mm_cvtss_f32(sum128);
-    
-    // Handle remaining elements
-    for (; i < size; ++i) {
-        Accum += areas[i];
+#include "accum.h"
+#include "live_collector.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+
+// Elements per parallel work item: 32K f32 (128 KB per column) keeps a chunk
+// resident in L2 while it is reduced. The chunk size is fixed so the order of
+// the partial sums - and therefore the result - does not depend on the number
+// of threads.
+constexpr size_t ReduceChunkSize = 32 * 1024;
+
+// Elements per leaf of the pairwise reduction: large enough for the vector
+// kernels to run at full speed, small enough that f32 error inside a leaf
+// stays at the level of a few thousand additions
+constexpr size_t PairwiseBlockSize = 2048;
+
+// Collector-based functions for benchmarking. The collector columns are
+// aligned_vectors, and every chunk and pairwise leaf starts at a multiple of
+// 16 elements, so all of them take the aligned kernels.
+f32 TotalAreaCollector(const aligned_vector<f32>& areas) {
+    INSTRUMENT_SCOPE("TotalAreaCollector", areas.size(), areas.size() * sizeof(f32));
+    return SimdKernels().sum_aligned(areas.data(), areas.size());
+}
+
+f32 TotalAreaCollector(const AreaCollector& collector) { return TotalAreaCollector(collector.areas()); }
+
+// Optimized corner area collector using precomputed weights
+f32 CornerAreaCollector(const CornerCollector& collector) {
+    INSTRUMENT_SCOPE("CornerAreaCollector", collector.size(), collector.size() * 2 * sizeof(f32));
+    return SimdKernels().dot_aligned(collector.areas().data(), collector.weights().data(), collector.size());
+}
+
+// Sum of the attached perimeter column, 0 when none is attached
+f32 TotalPerimeterCollector(const AreaCollector& collector) {
+    INSTRUMENT_SCOPE("TotalPerimeterCollector", collector.perimeters().size(),
+                     collector.perimeters().size() * sizeof(f32));
+    return SimdKernels().sum_aligned(collector.perimeters().data(), collector.perimeters().size());
+}
+
+f32 TotalPerimeterCollector(const CornerCollector& collector) {
+    INSTRUMENT_SCOPE("TotalPerimeterCollector", collector.perimeters().size(),
+                     collector.perimeters().size() * sizeof(f32));
+    return SimdKernels().sum_aligned(collector.perimeters().data(), collector.perimeters().size());
+}
+
+// Pairwise combination of the leaf results: error grows with log2 of the
+// number of blocks instead of the element count
+template <class Leaf>
+static f32 PairwiseReduce(size_t begin, size_t size, const Leaf& leaf) {
+    if (size <= PairwiseBlockSize) {
+        return leaf(begin, size);
     }
-    
-    return Accum;
+    size_t half = (size / 2 + PairwiseBlockSize - 1) / PairwiseBlockSize * PairwiseBlockSize;
+    return PairwiseReduce(begin, half, leaf) + PairwiseReduce(begin + half, size - half, leaf);
 }
 
-// Optimized corner area collector using precomputed weights and FMA if available
-f32 CornerAreaCollector(CornerCollector& collector) {
-    const size_t size = collector.areas.size();
-    const f32* areas = collector.areas.data();
-    const f32* weights = collector.weights.data();
-    
-    // Use 8 accumulators for better pipelining
-    __m256 sum0 = _mm256_setzero_ps();
-    __m256 sum1 = _mm256_setzero_ps();
-    __m256 sum2 = _mm256_setzero_ps();
-    __m256 sum3 = _mm256_setzero_ps();
-    __m256 sum4 = _mm256_setzero_ps();
-    __m256 sum5 = _mm256_setzero_ps();
-    __m256 sum6 = _mm256_setzero_ps();
-    __m256 sum7 = _mm256_setzero_ps();
-    
-    // Process 64 elements at a time with prefetching
-    size_t i = 0;
-    
-    // For very large arrays, first prefetch ahead
-    if (size >= 128) {
-        _mm_prefetch((const char*)&areas[64], _MM_HINT_T0);
-        _mm_prefetch((const char*)&areas[64+64], _MM_HINT_T0);
-        _mm_prefetch((const char*)&weights[64], _MM_HINT_T0);
-        _mm_prefetch((const char*)&weights[64+64], _MM_HINT_T0);
+f32 TotalAreaCollector(const aligned_vector<f32>& column, accum_policy policy) {
+    INSTRUMENT_SCOPE("TotalAreaCollector/policy", column.size(), column.size() * sizeof(f32));
+    const simd_kernels& kernels = SimdKernels();
+    const f32* areas = column.data();
+    const size_t size = column.size();
+    switch (policy) {
+        case Accum_F64: return kernels.sum_f64(areas, size);
+        case Accum_Neumaier: return kernels.sum_neumaier(areas, size);
+        case Accum_Pairwise:
+            return PairwiseReduce(0, size, [&](size_t begin, size_t count) {
+                return kernels.sum_aligned(areas + begin, count);
+            });
+        default: return kernels.sum_aligned(areas, size);
     }
-    
-    for (; i + 63 < size; i += 64) {
-        // Prefetch next iterations to L1 cache
-        _mm_prefetch((const char*)&areas[i + 128], _MM_HINT_T0);
-        _mm_prefetch((const char*)&areas[i + 160], _MM_HINT_T0);
-        _mm_prefetch((const char*)&weights[i + 128], _MM_HINT_T0);
-        _mm_prefetch((const char*)&weights[i + 160], _MM_HINT_T0);
-        
-        // First 8 elements
-        __m256 area_vec0 = _mm256_loadu_ps(&areas[i]);
-        __m256 weight_vec0 = _mm256_loadu_ps(&weights[i]);
-        
-        // Next 8 elements
-        __m256 area_vec1 = _mm256_loadu_ps(&areas[i + 8]);
-        __m256 weight_vec1 = _mm256_loadu_ps(&weights[i + 8]);
-        
-        // Next 8 elements
-        __m256 area_vec2 = _mm256_loadu_ps(&areas[i + 16]);
-        __m256 weight_vec2 = _mm256_loadu_ps(&weights[i + 16]);
-        
-        // Next 8 elements
-        __m256 area_vec3 = _mm256_loadu_ps(&areas[i + 24]);
-        __m256 weight_vec3 = _mm256_loadu_ps(&weights[i + 24]);
-        
-        // Next 8 elements
-        __m256 area_vec4 = _mm256_loadu_ps(&areas[i + 32]);
-        __m256 weight_vec4 = _mm256_loadu_ps(&weights[i + 32]);
-        
-        // Next 8 elements
-        __m256 area_vec5 = _mm256_loadu_ps(&areas[i + 40]);
-        __m256 weight_vec5 = _mm256_loadu_ps(&weights[i + 40]);
-        
-        // Next 8 elements
-        __m256 area_vec6 = _mm256_loadu_ps(&areas[i + 48]);
-        __m256 weight_vec6 = _mm256_loadu_ps(&weights[i + 48]);
-        
-        // Next 8 elements
-        __m256 area_vec7 = _mm256_loadu_ps(&areas[i + 56]);
-        __m256 weight_vec7 = _mm256_loadu_ps(&weights[i + 56]);
-        
-        // Multiply and accumulate using 8 independent accumulators with FMA
-        // FMA computes a*b+c in a single instruction with a single rounding step
-        sum0 = _mm256_fmadd_ps(area_vec0, weight_vec0, sum0);
-        sum1 = _mm256_fmadd_ps(area_vec1, weight_vec1, sum1);
-        sum2 = _mm256_fmadd_ps(area_vec2, weight_vec2, sum2);
-        sum3 = _mm256_fmadd_ps(area_vec3, weight_vec3, sum3);
-        sum4 = _mm256_fmadd_ps(area_vec4, weight_vec4, sum4);
-        sum5 = _mm256_fmadd_ps(area_vec5, weight_vec5, sum5);
-        sum6 = _mm256_fmadd_ps(area_vec6, weight_vec6, sum6);
-        sum7 = _mm256_fmadd_ps(area_vec7, weight_vec7, sum7);
+}
+
+f32 TotalAreaCollector(const AreaCollector& collector, accum_policy policy) {
+    return TotalAreaCollector(collector.areas(), policy);
+}
+
+f32 CornerAreaCollector(const CornerCollector& collector, accum_policy policy) {
+    INSTRUMENT_SCOPE("CornerAreaCollector/policy", collector.size(), collector.size() * 2 * sizeof(f32));
+    const simd_kernels& kernels = SimdKernels();
+    const f32* areas = collector.areas().data();
+    const f32* weights = collector.weights().data();
+    const size_t size = collector.size();
+    switch (policy) {
+        case Accum_F64: return kernels.dot_f64(areas, weights, size);
+        case Accum_Neumaier: return kernels.dot_neumaier(areas, weights, size);
+        case Accum_Pairwise:
+            return PairwiseReduce(0, size, [&](size_t begin, size_t count) {
+                return kernels.dot_aligned(areas + begin, weights + begin, count);
+            });
+        default: return kernels.dot_aligned(areas, weights, size);
     }
-    
-    // Combine the 8 accumulators into 4
-    sum0 = _mm256_add_ps(sum0, sum4);
-    sum1 = _mm256_add_ps(sum1, sum5);
-    sum2 = _mm256_add_ps(sum2, sum6);
-    sum3 = _mm256_add_ps(sum3, sum7);
-    
-    // Combine the 4 accumulators into 2
-    sum0 = _mm256_add_ps(sum0, sum1);
-    sum2 = _mm256_add_ps(sum2, sum3);
-    
-    // Combine the 2 accumulators into 1
-    sum0 = _mm256_add_ps(sum0, sum2);
-    
-    // Process remaining 8-element chunks
-    for (; i + 7 < size; i += 8) {
-        __m256 area_vec = _mm256_loadu_ps(&areas[i]);
-        __m256 weight_vec = _mm256_loadu_ps(&weights[i]);
-        sum0 = _mm256_fmadd_ps(area_vec, weight_vec, sum0);
+}
+
+// Live collectors maintain their totals on every change, so a query is a read
+f32 TotalAreaCollector(LiveAreaCollector& collector) {
+    INSTRUMENT_SCOPE("TotalAreaCollector/live", collector.size(), 0);
+    return collector.totalArea();
+}
+
+f32 CornerAreaCollector(LiveCornerCollector& collector) {
+    INSTRUMENT_SCOPE("CornerAreaCollector/live", collector.size(), 0);
+    return collector.cornerArea();
+}
+
+// Parallel reductions: every chunk writes its own partial, and the partials
+// are combined in chunk order, in double, on the calling thread.
+f32 TotalAreaCollector(const aligned_vector<f32>& column, ThreadPool& pool) {
+    INSTRUMENT_SCOPE("TotalAreaCollector/pool", column.size(), column.size() * sizeof(f32));
+    const size_t size = column.size();
+    const f32* areas = column.data();
+    const size_t chunks = (size + ReduceChunkSize - 1) / ReduceChunkSize;
+
+    const simd_kernels& kernels = SimdKernels();
+
+    std::vector<f32> partials(chunks);
+    pool.parallelFor(chunks, [&](size_t chunk) {
+        size_t begin = chunk * ReduceChunkSize;
+        size_t count = std::min(ReduceChunkSize, size - begin);
+        partials[chunk] = kernels.sum_aligned(areas + begin, count);
+    });
+
+    double Accum = 0.0;
+    for (f32 partial : partials) {
+        Accum += partial;
     }
-    
-    // Horizontal sum using efficient hadd instructions
-    __m128 high128 = _mm256_extractf128_ps(sum0, 1);
-    __m128 low128 = _mm256_castps256_ps128(sum0);
-    __m128 sum128 = _mm_add_ps(high128, low128);
-    
-    // More efficient horizontal sum with hadd
-    sum128 = _mm_hadd_ps(sum128, sum128);
-    sum128 = _mm_hadd_ps(sum128, sum128);
-    
-    f32 Accum = _mm_cvtss_f32(sum128);
-    
-    // Handle remaining elements
-    for (; i < size; ++i) {
-        Accum += areas[i] * weights[i];
+    return static_cast<f32>(Accum);
+}
+
+f32 TotalAreaCollector(const AreaCollector& collector, ThreadPool& pool) {
+    return TotalAreaCollector(collector.areas(), pool);
+}
+
+f32 CornerAreaCollector(const CornerCollector& collector, ThreadPool& pool) {
+    INSTRUMENT_SCOPE("CornerAreaCollector/pool", collector.size(), collector.size() * 2 * sizeof(f32));
+    const size_t size = collector.size();
+    const f32* areas = collector.areas().data();
+    const f32* weights = collector.weights().data();
+    const size_t chunks = (size + ReduceChunkSize - 1) / ReduceChunkSize;
+
+    const simd_kernels& kernels = SimdKernels();
+
+    std::vector<f32> partials(chunks);
+    pool.parallelFor(chunks, [&](size_t chunk) {
+        size_t begin = chunk * ReduceChunkSize;
+        size_t count = std::min(ReduceChunkSize, size - begin);
+        partials[chunk] = kernels.dot_aligned(areas + begin, weights + begin, count);
+    });
+
+    double Accum = 0.0;
+    for (f32 partial : partials) {
+        Accum += partial;
     }
-    
-    return Accum;
+    return static_cast<f32>(Accum);
 }
@@ -0,0 +1,255 @@
+#include "shape_file.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include "shape_store.h"
+#include "simd_kernels.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char ShapeFileMagic[8] = {'S', 'H', 'A', 'P', 'E', 'C', 'O', 'L'};
+
+static u64 AlignUp(u64 offset) {
+    return (offset + ShapeFileAlignment - 1) / ShapeFileAlignment * ShapeFileAlignment;
+}
+
+// Pads the stream with zeros up to offset
+static void PadTo(std::ofstream& file, u64 offset) {
+    static const char Zeros[ShapeFileAlignment] = {};
+    u64 position = static_cast<u64>(file.tellp());
+    file.write(Zeros, static_cast<std::streamsize>(offset - position));
+}
+
+bool WriteShapeFile(const std::string& path, const CornerCollector& collector, const u8* types) {
+    const u64 count = collector.size();
+    shape_file_header header = {};
+    std::memcpy(header.Magic, ShapeFileMagic, sizeof(header.Magic));
+    header.Version = ShapeFileVersion;
+    header.HeaderBytes = sizeof(shape_file_header);
+    header.ShapeCount = count;
+    header.TypesOffset = AlignUp(sizeof(shape_file_header));
+    header.AreasOffset = AlignUp(header.TypesOffset + count * sizeof(u8));
+    header.WeightsOffset = AlignUp(header.AreasOffset + count * sizeof(f32));
+    header.FileBytes = header.WeightsOffset + count * sizeof(f32);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    PadTo(file, header.TypesOffset);
+    file.write(reinterpret_cast<const char*>(types), static_cast<std::streamsize>(count * sizeof(u8)));
+    PadTo(file, header.AreasOffset);
+    file.write(reinterpret_cast<const char*>(collector.areas().data()), static_cast<std::streamsize>(count * sizeof(f32)));
+    PadTo(file, header.WeightsOffset);
+    file.write(reinterpret_cast<const char*>(collector.weights().data()),
+               static_cast<std::streamsize>(count * sizeof(f32)));
+    file.close();
+    return !file.fail();
+}
+
+bool WriteShapeFile(const std::string& path, const ShapeStore& store) {
+    CornerCollector collector;
+    collector.addShapes(store);
+    return WriteShapeFile(path, collector, store.types().data());
+}
+
+// Every column has to lie inside the file and on its alignment
+static bool ValidHeader(const shape_file_header& header, size_t file_bytes) {
+    if (std::memcmp(header.Magic, ShapeFileMagic, sizeof(header.Magic)) != 0 ||
+        header.Version != ShapeFileVersion || header.HeaderBytes != sizeof(shape_file_header) ||
+        header.FileBytes > file_bytes) {
+        return false;
+    }
+    const u64 count = header.ShapeCount;
+    const u64 offsets[3] = {header.TypesOffset, header.AreasOffset, header.WeightsOffset};
+    const u64 widths[3] = {sizeof(u8), sizeof(f32), sizeof(f32)};
+    for (int c = 0; c < 3; ++c) {
+        if (offsets[c] % ShapeFileAlignment != 0 || offsets[c] < sizeof(shape_file_header) ||
+            count > (header.FileBytes - std::min<u64>(offsets[c], header.FileBytes)) / widths[c]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MappedCollector::open(const std::string& path) {
+    close();
+#if defined(__linux__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(shape_file_header)) {
+        ::close(fd);
+        return false;
+    }
+    size_t file_bytes = static_cast<size_t>(info.st_size);
+    void* p = mmap(nullptr, file_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        return false;
+    }
+    const shape_file_header& header = *static_cast<const shape_file_header*>(p);
+    if (!ValidHeader(header, file_bytes)) {
+        munmap(p, file_bytes);
+        return false;
+    }
+    Base = static_cast<const u8*>(p);
+    Bytes = file_bytes;
+    Count = static_cast<size_t>(header.ShapeCount);
+    Types = Base + header.TypesOffset;
+    Areas = reinterpret_cast<const f32*>(Base + header.AreasOffset);
+    Weights = reinterpret_cast<const f32*>(Base + header.WeightsOffset);
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+void MappedCollector::close() {
+#if defined(__linux__)
+    if (Base) {
+        munmap(const_cast<u8*>(Base), Bytes);
+    }
+#endif
+    Base = nullptr;
+    Bytes = 0;
+    Count = 0;
+    Types = nullptr;
+    Areas = nullptr;
+    Weights = nullptr;
+}
+
+void MappedCollector::advise(size_t begin, size_t count, page_advice advice) const {
+#if defined(__linux__)
+    if (!Base || begin >= Count) {
+        return;
+    }
+    count = std::min(count, Count - begin);
+    static const size_t Page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    static const int Advice[] = {MADV_SEQUENTIAL, MADV_WILLNEED, MADV_DONTNEED};
+    const u8* columns[2] = {reinterpret_cast<const u8*>(Areas), reinterpret_cast<const u8*>(Weights)};
+    for (const u8* column : columns) {
+        size_t first = static_cast<size_t>(column - Base) + begin * sizeof(f32);
+        size_t last = first + count * sizeof(f32);
+        // Hints may widen a range to whole pages, dropping must not touch
+        // the pages a range shares with its neighbours
+        if (advice == Advice_DontNeed) {
+            first = (first + Page - 1) / Page * Page;
+            last = last / Page * Page;
+        } else {
+            first = first / Page * Page;
+        }
+        if (first < last) {
+            madvise(const_cast<u8*>(Base) + first, last - first, Advice[advice]);
+        }
+    }
+#else
+    (void)begin;
+    (void)count;
+    (void)advice;
+#endif
+}
+
+void MappedCollector::adviseSequential() const {
+    advise(0, Count, Advice_Sequential);
+}
+
+void MappedCollector::willNeed(size_t begin, size_t count) const {
+    advise(begin, count, Advice_WillNeed);
+}
+
+void MappedCollector::dontNeed(size_t begin, size_t count) const {
+    advise(begin, count, Advice_DontNeed);
+}
+
+bool ShapeFileReader::open(const std::string& path) {
+    close();
+#if defined(__linux__)
+    File = ::open(path.c_str(), O_RDONLY);
+    if (File < 0) {
+        return false;
+    }
+    struct stat info;
+    shape_file_header header;
+    if (fstat(File, &info) != 0 || pread(File, &header, sizeof(header), 0) != sizeof(header) ||
+        !ValidHeader(header, static_cast<size_t>(info.st_size))) {
+        close();
+        return false;
+    }
+    posix_fadvise(File, 0, 0, POSIX_FADV_SEQUENTIAL);
+    Count = static_cast<size_t>(header.ShapeCount);
+    AreasOffset = header.AreasOffset;
+    WeightsOffset = header.WeightsOffset;
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+void ShapeFileReader::close() {
+#if defined(__linux__)
+    if (File >= 0) {
+        ::close(File);
+    }
+#endif
+    File = -1;
+    Count = 0;
+    Position = 0;
+}
+
+#if defined(__linux__)
+// pread may return less than asked for; false on an error or early end
+static bool ReadFully(int file, void* data, size_t bytes, u64 offset) {
+    u8* out = static_cast<u8*>(data);
+    while (bytes > 0) {
+        ssize_t n = pread(file, out, bytes, static_cast<off_t>(offset));
+        if (n <= 0) {
+            return false;
+        }
+        out += n;
+        bytes -= static_cast<size_t>(n);
+        offset += static_cast<u64>(n);
+    }
+    return true;
+}
+#endif
+
+size_t ShapeFileReader::read(f32* areas, f32* weights, size_t capacity) {
+#if defined(__linux__)
+    size_t count = std::min(capacity, Count - Position);
+    if (File < 0 || count == 0) {
+        return 0;
+    }
+    if (!ReadFully(File, areas, count * sizeof(f32), AreasOffset + Position * sizeof(f32)) ||
+        (weights && !ReadFully(File, weights, count * sizeof(f32), WeightsOffset + Position * sizeof(f32)))) {
+        return 0;
+    }
+    Position += count;
+    return count;
+#else
+    (void)areas;
+    (void)weights;
+    (void)capacity;
+    return 0;
+#endif
+}
+
+// The mapping is page aligned and the columns start on ShapeFileAlignment
+f32 TotalAreaCollector(const MappedCollector& collector) {
+    INSTRUMENT_SCOPE("TotalAreaCollector/mapped", collector.size(), collector.size() * sizeof(f32));
+    return SimdKernels().sum_aligned(collector.areas(), collector.size());
+}
+
+f32 CornerAreaCollector(const MappedCollector& collector) {
+    INSTRUMENT_SCOPE("CornerAreaCollector/mapped", collector.size(), collector.size() * 2 * sizeof(f32));
+    return SimdKernels().dot_aligned(collector.areas(), collector.weights(), collector.size());
+}
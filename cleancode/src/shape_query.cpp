@@ -0,0 +1,152 @@
+#include "shape_query.h"
+#include <algorithm>
+#include <array>
+
+// Independent accumulator lanes of the fused pass. The inner loops run over
+// the lanes, so the compiler maps them onto vector registers.
+constexpr u32 QueryLanes = 32;
+constexpr u32 QueryMaxMonomials = (QueryMaxPower + 1) * (QueryMaxPower + 1);
+
+struct query_monomial {
+    u8 WidthPower;
+    u8 HeightPower;
+};
+
+struct query_plan {
+    query_monomial Monomials[QueryMaxMonomials];
+    u32 MonomialCount = 0;
+    u32 MaxWidthPower = 0;
+    u32 MaxHeightPower = 0;
+};
+
+// Adds Width^p * Height^q of the QueryLanes shapes at width/height that pass
+// the area filter to each monomial's accumulators. The tail is copied into a
+// zero-padded block and its padding masked through Valid.
+static inline void AccumulateBlock(const f32* width, const f32* height, const f32* Valid, f32 Coefficient,
+                                   const query_filter& Filter, const query_plan& Plan,
+                                   f32 (*Acc)[QueryLanes]) {
+    f32 WidthPowers[QueryMaxPower + 1][QueryLanes];
+    f32 HeightPowers[QueryMaxPower + 1][QueryLanes];
+    for (u32 l = 0; l < QueryLanes; ++l) {
+        f32 area = Coefficient * width[l] * height[l];
+        // The filter mask rides along in the zeroth power of Width
+        WidthPowers[0][l] = area >= Filter.AreaMin && area < Filter.AreaMax ? Valid[l] : 0.0f;
+        HeightPowers[0][l] = 1.0f;
+    }
+    for (u32 p = 1; p <= Plan.MaxWidthPower; ++p) {
+        for (u32 l = 0; l < QueryLanes; ++l) {
+            WidthPowers[p][l] = WidthPowers[p - 1][l] * width[l];
+        }
+    }
+    for (u32 q = 1; q <= Plan.MaxHeightPower; ++q) {
+        for (u32 l = 0; l < QueryLanes; ++l) {
+            HeightPowers[q][l] = HeightPowers[q - 1][l] * height[l];
+        }
+    }
+    for (u32 m = 0; m < Plan.MonomialCount; ++m) {
+        const f32* wp = WidthPowers[Plan.Monomials[m].WidthPower];
+        const f32* hp = HeightPowers[Plan.Monomials[m].HeightPower];
+        for (u32 l = 0; l < QueryLanes; ++l) {
+            Acc[m][l] += wp[l] * hp[l];
+        }
+    }
+}
+
+// One pass over a type column: every monomial of the plan, filtered
+static void MonomialSums(const f32* width, const f32* height, size_t size, f32 Coefficient,
+                         const query_filter& Filter, const query_plan& Plan, f32* Sums) {
+    static const std::array<f32, QueryLanes> AllLanes = [] {
+        std::array<f32, QueryLanes> lanes;
+        lanes.fill(1.0f);
+        return lanes;
+    }();
+    f32 Acc[QueryMaxMonomials][QueryLanes] = {};
+    size_t i = 0;
+    for (; i + QueryLanes <= size; i += QueryLanes) {
+        AccumulateBlock(width + i, height + i, AllLanes.data(), Coefficient, Filter, Plan, Acc);
+    }
+    if (i < size) {
+        f32 TailWidth[QueryLanes] = {}, TailHeight[QueryLanes] = {}, TailValid[QueryLanes] = {};
+        for (u32 l = 0; i + l < size; ++l) {
+            TailWidth[l] = width[i + l];
+            TailHeight[l] = height[i + l];
+            TailValid[l] = 1.0f;
+        }
+        AccumulateBlock(TailWidth, TailHeight, TailValid, Coefficient, Filter, Plan, Acc);
+    }
+    for (u32 m = 0; m < Plan.MonomialCount; ++m) {
+        for (u32 width_lanes = QueryLanes / 2; width_lanes > 0; width_lanes /= 2) {
+            for (u32 l = 0; l < width_lanes; ++l) {
+                Acc[m][l] += Acc[m][l + width_lanes];
+            }
+        }
+        Sums[m] = Acc[m][0];
+    }
+}
+
+static f32 Power(f32 base, u32 exponent) {
+    f32 result = 1.0f;
+    for (u32 i = 0; i < exponent; ++i) {
+        result *= base;
+    }
+    return result;
+}
+
+ShapeQuery& ShapeQuery::sum(const query_expr& expr) {
+    if (expr.Area + expr.Width > QueryMaxPower || expr.Area + expr.Height > QueryMaxPower) {
+        Valid = false;
+    }
+    Aggregates.push_back(expr);
+    return *this;
+}
+
+query_result ShapeQuery::run() const {
+    query_result result;
+    if (!Valid) {
+        return result;
+    }
+    result.groups = Grouped ? static_cast<u32>(Shape_Count) : 1u;
+    result.aggregates = static_cast<u32>(Aggregates.size());
+    result.values.assign(result.groups * result.aggregates, 0.0f);
+
+    // Distinct (p, q) pairs, so aggregates sharing a monomial share its sum
+    query_plan plan;
+    std::vector<u32> monomial_of(Aggregates.size());
+    for (size_t a = 0; a < Aggregates.size(); ++a) {
+        query_monomial m = {static_cast<u8>(Aggregates[a].Area + Aggregates[a].Width),
+                            static_cast<u8>(Aggregates[a].Area + Aggregates[a].Height)};
+        u32 index = 0;
+        while (index < plan.MonomialCount && (plan.Monomials[index].WidthPower != m.WidthPower ||
+                                              plan.Monomials[index].HeightPower != m.HeightPower)) {
+            ++index;
+        }
+        if (index == plan.MonomialCount) {
+            plan.Monomials[plan.MonomialCount++] = m;
+            plan.MaxWidthPower = std::max<u32>(plan.MaxWidthPower, m.WidthPower);
+            plan.MaxHeightPower = std::max<u32>(plan.MaxHeightPower, m.HeightPower);
+        }
+        monomial_of[a] = index;
+    }
+
+    for (u32 t = 0; t < Shape_Count; ++t) {
+        const shape_column& column = Store->column(t);
+        if (!(Filter.TypeMask & (1u << t)) || column.Width.empty()) {
+            continue;
+        }
+        shape_type Type = static_cast<shape_type>(t);
+        const f32* width = column.Width.data();
+        const f32* height = ShapeStore::HasHeight(Type) ? column.Height.data() : width;
+
+        f32 sums[QueryMaxMonomials];
+        MonomialSums(width, height, column.Width.size(), ShapeAreaCoefficients[t], Filter, plan, sums);
+
+        f32* group = result.values.data() + (Grouped ? t : 0) * result.aggregates;
+        for (size_t a = 0; a < Aggregates.size(); ++a) {
+            const query_expr& expr = Aggregates[a];
+            f32 scale = Power(ShapeAreaCoefficients[t], expr.Area) * Power(ShapeCornerWeights[t], expr.Weight) *
+                        Power(static_cast<f32>(ShapeCornerCounts[t]), expr.Corners);
+            group[a] += scale * sums[monomial_of[a]];
+        }
+    }
+    return result;
+}
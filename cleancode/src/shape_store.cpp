@@ -0,0 +1,128 @@
+#include "shape_store.h"
+#include "instrumentation.h"
+#include "simd_kernels.h"
+
+// Per-shape formulas of the switch engine
+f32 GetAreaSwitch(const shape_union& Shape);
+u32 GetCornerCountSwitch(shape_type Type);
+f32 GetPerimeterSwitch(const shape_union& Shape);
+shape_bounds GetBoundsSwitch(const shape_union& Shape);
+
+u32 ShapeStore::add(const shape_union& shape) {
+    shape_column& column = columns[shape.Type];
+    u32 handle = static_cast<u32>(type_tags.size());
+    type_tags.push_back(static_cast<u8>(shape.Type));
+    type_slots.push_back(static_cast<u32>(column.Width.size()));
+    column.Width.push_back(shape.Width);
+    if (HasHeight(shape.Type)) {
+        column.Height.push_back(shape.Height);
+    }
+    return handle;
+}
+
+void ShapeStore::reserve(size_t count) {
+    size_t TypeCounts[Shape_Count];
+    for (u32 t = 0; t < Shape_Count; ++t) {
+        TypeCounts[t] = (count + Shape_Count - 1) / Shape_Count;
+    }
+    reserve(TypeCounts);
+}
+
+void ShapeStore::reserve(const size_t (&TypeCounts)[Shape_Count]) {
+    size_t count = 0;
+    for (u32 t = 0; t < Shape_Count; ++t) {
+        shape_column& column = columns[t];
+        column.Width.reserve(column.Width.size() + TypeCounts[t]);
+        if (HasHeight(static_cast<shape_type>(t))) {
+            column.Height.reserve(column.Height.size() + TypeCounts[t]);
+        }
+        count += TypeCounts[t];
+    }
+    type_tags.reserve(type_tags.size() + count);
+    type_slots.reserve(type_slots.size() + count);
+}
+
+shape_union ShapeStore::get(u32 handle) const {
+    shape_type Type = static_cast<shape_type>(type_tags[handle]);
+    const shape_column& column = columns[Type];
+    u32 slot = type_slots[handle];
+    f32 Width = column.Width[slot];
+    f32 Height = HasHeight(Type) ? column.Height[slot] : Width;
+    return {Type, Width, Height};
+}
+
+f32 shape_view::Area() {
+    return GetAreaSwitch(Store->get(Index));
+}
+
+u32 shape_view::CornerCount() {
+    return GetCornerCountSwitch(static_cast<shape_type>(Store->types()[Index]));
+}
+
+f32 shape_view::Perimeter() {
+    return GetPerimeterSwitch(Store->get(Index));
+}
+
+shape_bounds shape_view::Bounds() {
+    return GetBoundsSwitch(Store->get(Index));
+}
+
+// Sum of Width*Height over one type column; single-parameter types square
+// their Width column instead of reading a duplicate
+static f32 ColumnProductSum(const shape_column& column, shape_type Type) {
+    const f32* width = column.Width.data();
+    const f32* height = ShapeStore::HasHeight(Type) ? column.Height.data() : width;
+    return SimdKernels().dot(width, height, column.Width.size());
+}
+
+f32 TotalAreaStore(const ShapeStore& store) {
+    INSTRUMENT_SCOPE("TotalAreaStore", store.size(), store.size() * 2 * sizeof(f32));
+    double Accum = 0.0;
+    for (u32 t = 0; t < Shape_Count; ++t) {
+        shape_type Type = static_cast<shape_type>(t);
+        Accum += ShapeAreaCoefficients[t] * ColumnProductSum(store.column(t), Type);
+    }
+    return static_cast<f32>(Accum);
+}
+
+f32 CornerAreaStore(const ShapeStore& store) {
+    INSTRUMENT_SCOPE("CornerAreaStore", store.size(), store.size() * 2 * sizeof(f32));
+    double Accum = 0.0;
+    for (u32 t = 0; t < Shape_Count; ++t) {
+        shape_type Type = static_cast<shape_type>(t);
+        Accum += ShapeCornerWeights[t] * ShapeAreaCoefficients[t] * ColumnProductSum(store.column(t), Type);
+    }
+    return static_cast<f32>(Accum);
+}
+
+// Every metric of one type column is a coefficient times a column sum, so
+// area and corner area share one dot product per column, and the perimeter
+// takes the column_moments pass over the same two columns instead
+shape_totals TotalMetricsStore(const ShapeStore& store, u32 Metrics) {
+    INSTRUMENT_SCOPE("TotalMetricsStore", store.size(), store.size() * 2 * sizeof(f32));
+    const simd_kernels& kernels = SimdKernels();
+    double Area = 0.0, CornerArea = 0.0, Perimeter = 0.0;
+    for (u32 t = 0; t < Shape_Count; ++t) {
+        const shape_column& column = store.column(t);
+        const f32* width = column.Width.data();
+        const f32* height = ShapeStore::HasHeight(static_cast<shape_type>(t)) ? column.Height.data() : width;
+        shape_moments Moments = {0.0f, 0.0f, 0.0f};
+        if (Metrics > 2) {
+            Moments = kernels.column_moments(width, height, column.Width.size());
+        } else {
+            Moments.Product = kernels.dot(width, height, column.Width.size());
+        }
+        Area += ShapeAreaCoefficients[t] * Moments.Product;
+        if (Metrics > 1) {
+            CornerArea += ShapeCornerAreaCoefficients[t] * Moments.Product;
+        }
+        if (Metrics > 2) {
+            Perimeter += ShapePerimeterCoefficients[t] * Moments.Sum + ShapeDiagonalCoefficients[t] * Moments.Diagonal;
+        }
+    }
+    shape_totals Totals;
+    Totals.Area = static_cast<f32>(Area);
+    Totals.CornerArea = static_cast<f32>(CornerArea);
+    Totals.Perimeter = static_cast<f32>(Perimeter);
+    return Totals;
+}
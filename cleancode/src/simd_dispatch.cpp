@@ -0,0 +1,234 @@
+#include "simd_kernels.h"
+#include "compact_columns.h"
+#include <atomic>
+#include <cmath>
+
+// The per-ISA translation units are only added to the build on their own
+// architecture; stub out the getters of the others.
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86 1
+#include <cpuid.h>
+#elif defined(__aarch64__)
+#define SIMD_NEON 1
+#endif
+
+#ifndef SIMD_X86
+const simd_kernels* SimdKernelsSSE2() { return nullptr; }
+const simd_kernels* SimdKernelsAVX2() { return nullptr; }
+const simd_kernels* SimdKernelsAVX512() { return nullptr; }
+#endif
+#ifndef SIMD_NEON
+const simd_kernels* SimdKernelsNEON() { return nullptr; }
+#endif
+
+// Portable fallback for architectures without a hand-written variant
+static f32 SumScalar(const f32* values, size_t size) {
+    f32 Accum = 0.0f;
+    for (size_t i = 0; i < size; ++i) {
+        Accum += values[i];
+    }
+    return Accum;
+}
+
+static f32 DotScalar(const f32* a, const f32* b, size_t size) {
+    f32 Accum = 0.0f;
+    for (size_t i = 0; i < size; ++i) {
+        Accum += a[i] * b[i];
+    }
+    return Accum;
+}
+
+static f32 UnionSumScalar(const shape_union* shapes, size_t size, const f32* coefficients) {
+    f32 Accum = 0.0f;
+    for (size_t i = 0; i < size; ++i) {
+        Accum += coefficients[shapes[i].Type] * shapes[i].Width * shapes[i].Height;
+    }
+    return Accum;
+}
+
+// Portable policy kernels. The double accumulators of the f64 variants are
+// exact for the products of two f32, so they need no compensation.
+static f32 SumF64Scalar(const f32* values, size_t size) {
+    double Accum = 0.0;
+    for (size_t i = 0; i < size; ++i) {
+        Accum += values[i];
+    }
+    return static_cast<f32>(Accum);
+}
+
+static f32 DotF64Scalar(const f32* a, const f32* b, size_t size) {
+    double Accum = 0.0;
+    for (size_t i = 0; i < size; ++i) {
+        Accum += double(a[i]) * double(b[i]);
+    }
+    return static_cast<f32>(Accum);
+}
+
+// Neumaier's variant of Kahan summation: the compensation also captures the
+// error when the new term is larger than the running sum
+static void NeumaierAdd(f32& sum, f32& compensation, f32 x) {
+    f32 t = sum + x;
+    if (std::fabs(sum) >= std::fabs(x)) {
+        compensation += (sum - t) + x;
+    } else {
+        compensation += (x - t) + sum;
+    }
+    sum = t;
+}
+
+static f32 SumNeumaierScalar(const f32* values, size_t size) {
+    f32 sum = 0.0f, compensation = 0.0f;
+    for (size_t i = 0; i < size; ++i) {
+        NeumaierAdd(sum, compensation, values[i]);
+    }
+    return sum + compensation;
+}
+
+static f32 DotNeumaierScalar(const f32* a, const f32* b, size_t size) {
+    f32 sum = 0.0f, compensation = 0.0f;
+    for (size_t i = 0; i < size; ++i) {
+        f32 product = a[i] * b[i];
+        compensation += std::fma(a[i], b[i], -product);
+        NeumaierAdd(sum, compensation, product);
+    }
+    return sum + compensation;
+}
+
+// Portable compact-column kernels; the decoders are out of line in
+// compact_columns.cpp
+template <f32 (*Decode)(u16)>
+static f32 SumHalfScalar(const u16* values, size_t size) {
+    f32 Accum = 0.0f;
+    for (size_t i = 0; i < size; ++i) {
+        Accum += Decode(values[i]);
+    }
+    return Accum;
+}
+
+static f32 DotLutScalar(const f32* areas, const u8* index, const f32* lut, size_t size) {
+    f32 Accum = 0.0f;
+    for (size_t i = 0; i < size; ++i) {
+        Accum += areas[i] * lut[index[i]];
+    }
+    return Accum;
+}
+
+template <f32 (*Decode)(u16)>
+static f32 DotHalfLutScalar(const u16* areas, const u8* index, const f32* lut, size_t size) {
+    f32 Accum = 0.0f;
+    for (size_t i = 0; i < size; ++i) {
+        Accum += Decode(areas[i]) * lut[index[i]];
+    }
+    return Accum;
+}
+
+static shape_moments ColumnMomentsScalar(const f32* width, const f32* height, size_t size) {
+    shape_moments Moments = {0.0f, 0.0f, 0.0f};
+    for (size_t i = 0; i < size; ++i) {
+        Moments.Product += width[i] * height[i];
+        Moments.Sum += width[i] + height[i];
+        Moments.Diagonal += std::sqrt(width[i] * width[i] + height[i] * height[i]);
+    }
+    return Moments;
+}
+
+static const simd_kernels ScalarKernels = {
+    "scalar", SumScalar, DotScalar, UnionSumScalar,
+    SumF64Scalar, DotF64Scalar, SumNeumaierScalar, DotNeumaierScalar,
+    SumHalfScalar<HalfToFloat>, SumHalfScalar<BFloat16ToFloat>,
+    DotLutScalar, DotHalfLutScalar<HalfToFloat>, DotHalfLutScalar<BFloat16ToFloat>,
+    SumScalar, DotScalar, ColumnMomentsScalar};
+
+// Optional entries the variant leaves null come from base, the next lower
+// variant the CPU supports
+static simd_kernels WithFallbacks(simd_kernels kernels, const simd_kernels& base) {
+    if (!kernels.sum_f64) kernels.sum_f64 = base.sum_f64;
+    if (!kernels.dot_f64) kernels.dot_f64 = base.dot_f64;
+    if (!kernels.sum_neumaier) kernels.sum_neumaier = base.sum_neumaier;
+    if (!kernels.dot_neumaier) kernels.dot_neumaier = base.dot_neumaier;
+    if (!kernels.sum_f16) kernels.sum_f16 = base.sum_f16;
+    if (!kernels.sum_bf16) kernels.sum_bf16 = base.sum_bf16;
+    if (!kernels.dot_lut) kernels.dot_lut = base.dot_lut;
+    if (!kernels.dot_f16_lut) kernels.dot_f16_lut = base.dot_f16_lut;
+    if (!kernels.dot_bf16_lut) kernels.dot_bf16_lut = base.dot_bf16_lut;
+    if (!kernels.column_moments) kernels.column_moments = base.column_moments;
+    // The unaligned kernels accept aligned columns, and are the faster choice
+    // over the lower variant's aligned ones
+    if (!kernels.sum_aligned) kernels.sum_aligned = kernels.sum;
+    if (!kernels.dot_aligned) kernels.dot_aligned = kernels.dot;
+    return kernels;
+}
+
+static std::atomic<size_t> PrefetchElements{DefaultPrefetchDistance};
+
+size_t PrefetchDistance() {
+    return PrefetchElements.load(std::memory_order_relaxed);
+}
+
+void SetPrefetchDistance(size_t elements) {
+    PrefetchElements.store(elements, std::memory_order_relaxed);
+}
+
+static void AddVariant(std::vector<simd_kernels>& kernels, const simd_kernels& variant) {
+    kernels.push_back(WithFallbacks(variant, kernels.empty() ? ScalarKernels : kernels.back()));
+}
+
+#if defined(SIMD_X86)
+// XCR0 state components the OS saves on a context switch: SSE and AVX
+// (YMM), and for AVX-512 also the opmask, ZMM_Hi256 and Hi16_ZMM state
+constexpr u64 XcrYmmState = 0x06;
+constexpr u64 XcrZmmState = 0xe6;
+
+// True if the OS enabled XSAVE and saves all of the state components in mask
+static bool OsSavesState(u64 mask) {
+    unsigned eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE)) {
+        return false;
+    }
+    unsigned lo, hi;
+    asm volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    const u64 xcr0 = (u64(hi) << 32) | lo;
+    return (xcr0 & mask) == mask;
+}
+#endif
+
+static std::vector<simd_kernels> DetectSimdKernels() {
+    std::vector<simd_kernels> kernels;
+#if defined(SIMD_X86)
+    // __builtin_cpu_supports only reads CPUID; whether the OS saves the YMM
+    // and ZMM registers is checked separately through XCR0. Every variant
+    // needs all the extensions its translation unit is compiled with.
+    AddVariant(kernels, *SimdKernelsSSE2());
+    const bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+                      __builtin_cpu_supports("f16c") && OsSavesState(XcrYmmState);
+    if (avx2) {
+        AddVariant(kernels, *SimdKernelsAVX2());
+    }
+    if (avx2 && __builtin_cpu_supports("avx512f") && OsSavesState(XcrZmmState)) {
+        AddVariant(kernels, *SimdKernelsAVX512());
+    }
+#elif defined(SIMD_NEON)
+    AddVariant(kernels, *SimdKernelsNEON());
+#else
+    AddVariant(kernels, ScalarKernels);
+#endif
+    return kernels;
+}
+
+static const std::vector<simd_kernels>& DetectedSimdKernels() {
+    static const std::vector<simd_kernels> kernels = DetectSimdKernels();
+    return kernels;
+}
+
+std::vector<const simd_kernels*> AvailableSimdKernels() {
+    std::vector<const simd_kernels*> kernels;
+    for (const simd_kernels& k : DetectedSimdKernels()) {
+        kernels.push_back(&k);
+    }
+    return kernels;
+}
+
+const simd_kernels& SimdKernels() {
+    static const simd_kernels& best = DetectedSimdKernels().back();
+    return best;
+}
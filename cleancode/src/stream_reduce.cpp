@@ -0,0 +1,149 @@
+#include "stream_reduce.h"
+#include "instrumentation.h"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "shape_file.h"
+#include "simd_kernels.h"
+
+namespace {
+
+// Two chunk buffers handed back and forth between the reader thread and the
+// reducing thread. A buffer is either free for the reader or full for the
+// reducer; a full buffer with no rows marks the end of the stream.
+class chunk_pipeline {
+public:
+    chunk_pipeline(const shape_chunk_source& SourceInit, size_t ChunkSize, bool Weighted) : Source(SourceInit) {
+        for (chunk& c : chunks) {
+            c.areas.resize(ChunkSize);
+            if (Weighted) {
+                c.weights.resize(ChunkSize);
+            }
+        }
+        reader = std::thread([this] { produce(); });
+    }
+
+    ~chunk_pipeline() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        changed.notify_all();
+        reader.join();
+    }
+
+    // Calls reduce(areas, weights, count) for every chunk in stream order
+    template <class Reduce>
+    void consume(const Reduce& reduce) {
+        for (size_t next = 0;; next ^= 1) {
+            chunk& c = chunks[next];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return c.full; });
+            }
+            if (c.count == 0) {
+                return;
+            }
+            reduce(c.areas.data(), c.weights.empty() ? nullptr : c.weights.data(), c.count);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                c.full = false;
+            }
+            changed.notify_all();
+        }
+    }
+
+private:
+    struct chunk {
+        std::vector<f32> areas;
+        std::vector<f32> weights;
+        size_t count = 0;
+        bool full = false;
+    };
+
+    void produce() {
+        for (size_t next = 0;; next ^= 1) {
+            chunk& c = chunks[next];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return stopping || !c.full; });
+                if (stopping) {
+                    return;
+                }
+            }
+            c.count = Source(c.areas.data(), c.weights.empty() ? nullptr : c.weights.data(), c.areas.size());
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                c.full = true;
+            }
+            changed.notify_all();
+            if (c.count == 0) {
+                return;
+            }
+        }
+    }
+
+    const shape_chunk_source& Source;
+    chunk chunks[2];
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool stopping = false;
+    std::thread reader;
+};
+
+}
+
+f32 TotalAreaStream(const shape_chunk_source& source, size_t chunk_size) {
+    const simd_kernels& kernels = SimdKernels();
+    double Accum = 0.0;
+    chunk_pipeline pipeline(source, std::max<size_t>(1, chunk_size), false);
+    pipeline.consume([&](const f32* areas, const f32*, size_t count) {
+        INSTRUMENT_SCOPE("TotalAreaStream/chunk", count, count * sizeof(f32));
+        Accum += kernels.sum(areas, count);
+    });
+    return static_cast<f32>(Accum);
+}
+
+f32 CornerAreaStream(const shape_chunk_source& source, size_t chunk_size) {
+    const simd_kernels& kernels = SimdKernels();
+    double Accum = 0.0;
+    chunk_pipeline pipeline(source, std::max<size_t>(1, chunk_size), true);
+    pipeline.consume([&](const f32* areas, const f32* weights, size_t count) {
+        INSTRUMENT_SCOPE("CornerAreaStream/chunk", count, count * 2 * sizeof(f32));
+        Accum += kernels.dot(areas, weights, count);
+    });
+    return static_cast<f32>(Accum);
+}
+
+// reduce(begin, count) per chunk, with the paging hints around it
+template <class Reduce>
+static f32 MappedStream(const MappedCollector& collector, size_t chunk_size, const Reduce& reduce) {
+    chunk_size = std::max<size_t>(1, chunk_size);
+    collector.adviseSequential();
+    collector.willNeed(0, chunk_size);
+    double Accum = 0.0;
+    for (size_t begin = 0; begin < collector.size(); begin += chunk_size) {
+        size_t count = std::min(chunk_size, collector.size() - begin);
+        collector.willNeed(begin + chunk_size, chunk_size);
+        Accum += reduce(begin, count);
+        collector.dontNeed(begin, count);
+    }
+    return static_cast<f32>(Accum);
+}
+
+f32 TotalAreaStream(const MappedCollector& collector, size_t chunk_size) {
+    INSTRUMENT_SCOPE("TotalAreaStream/mapped", collector.size(), collector.size() * sizeof(f32));
+    const simd_kernels& kernels = SimdKernels();
+    return MappedStream(collector, chunk_size,
+                        [&](size_t begin, size_t count) { return kernels.sum(collector.areas() + begin, count); });
+}
+
+f32 CornerAreaStream(const MappedCollector& collector, size_t chunk_size) {
+    INSTRUMENT_SCOPE("CornerAreaStream/mapped", collector.size(), collector.size() * 2 * sizeof(f32));
+    const simd_kernels& kernels = SimdKernels();
+    return MappedStream(collector, chunk_size, [&](size_t begin, size_t count) {
+        return kernels.dot(collector.areas() + begin, collector.weights() + begin, count);
+    });
+}
@@ -1,26 +1,47 @@
 #include "shapes.h"
+#include "instrumentation.h"
+#include "accum.h"
 
+// One case per SHAPE_LIST entry; the formulas are the shape traits, inlined
+// as constants into each case
 f32 GetAreaSwitch(const shape_union& Shape) {
     switch (Shape.Type) {
-        case Shape_Square: return Shape.Width * Shape.Width;
-        case Shape_Rectangle: return Shape.Width * Shape.Height;
-        case Shape_Triangle: return 0.5f * Shape.Width * Shape.Height;
-        case Shape_Circle: return Pi32 * Shape.Width * Shape.Width;
+#define AREA_CASE(Name, ...) case Shape_##Name: return shape_traits<Shape_##Name>::Area(Shape.Width, Shape.Height);
+        SHAPE_LIST(AREA_CASE)
+#undef AREA_CASE
         default: return 0.0f;
     }
 }
 
 u32 GetCornerCountSwitch(shape_type Type) {
     switch (Type) {
-        case Shape_Square: return 4;
-        case Shape_Rectangle: return 4;
-        case Shape_Triangle: return 3;
-        case Shape_Circle: return 0;
+#define CORNER_COUNT_CASE(Name, ...) case Shape_##Name: return shape_traits<Shape_##Name>::CornerCount;
+        SHAPE_LIST(CORNER_COUNT_CASE)
+#undef CORNER_COUNT_CASE
         default: return 0;
     }
 }
 
+f32 GetPerimeterSwitch(const shape_union& Shape) {
+    switch (Shape.Type) {
+#define PERIMETER_CASE(Name, ...) case Shape_##Name: return shape_traits<Shape_##Name>::Perimeter(Shape.Width, Shape.Height);
+        SHAPE_LIST(PERIMETER_CASE)
+#undef PERIMETER_CASE
+        default: return 0.0f;
+    }
+}
+
+shape_bounds GetBoundsSwitch(const shape_union& Shape) {
+    switch (Shape.Type) {
+#define BOUNDS_CASE(Name, ...) case Shape_##Name: return shape_traits<Shape_##Name>::Bounds(Shape.Width, Shape.Height);
+        SHAPE_LIST(BOUNDS_CASE)
+#undef BOUNDS_CASE
+        default: return {0.0f, 0.0f};
+    }
+}
+
 f32 TotalAreaSwitch(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("TotalAreaSwitch", ShapeCount, ShapeCount * sizeof(shape_union));
     f32 Accum = 0.0f;
     for (u32 i = 0; i < ShapeCount; ++i) {
         Accum += GetAreaSwitch(Shapes[i]);
@@ -28,20 +49,27 @@ f32 TotalAreaSwitch(u32 ShapeCount, shape_union* Shapes) {
     return Accum;
 }
 
+// Unrolled variants: K independent chains, any ShapeCount
+template <u32 K>
+static f32 TotalAreaSwitchK(u32 ShapeCount, shape_union* Shapes) {
+    return Accum<K>::Sum(ShapeCount, [Shapes](u32 i) { return GetAreaSwitch(Shapes[i]); });
+}
+
 f32 TotalAreaSwitch4(u32 ShapeCount, shape_union* Shapes) {
-    f32 Accum0 = 0.0f, Accum1 = 0.0f, Accum2 = 0.0f, Accum3 = 0.0f;
-    ShapeCount /= 4;
-    while (ShapeCount--) {
-        Accum0 += GetAreaSwitch(Shapes[0]);
-        Accum1 += GetAreaSwitch(Shapes[1]);
-        Accum2 += GetAreaSwitch(Shapes[2]);
-        Accum3 += GetAreaSwitch(Shapes[3]);
-        Shapes += 4;
-    }
-    return Accum0 + Accum1 + Accum2 + Accum3;
+    INSTRUMENT_SCOPE("TotalAreaSwitch4", ShapeCount, ShapeCount * sizeof(shape_union));
+    return TotalAreaSwitchK<4>(ShapeCount, Shapes);
+}
+f32 TotalAreaSwitch8(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("TotalAreaSwitch8", ShapeCount, ShapeCount * sizeof(shape_union));
+    return TotalAreaSwitchK<8>(ShapeCount, Shapes);
+}
+f32 TotalAreaSwitch16(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("TotalAreaSwitch16", ShapeCount, ShapeCount * sizeof(shape_union));
+    return TotalAreaSwitchK<16>(ShapeCount, Shapes);
 }
 
 f32 CornerAreaSwitch(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("CornerAreaSwitch", ShapeCount, ShapeCount * sizeof(shape_union));
     f32 Accum = 0.0f;
     for (u32 i = 0; i < ShapeCount; ++i) {
         Accum += (1.0f / (1.0f + (f32)GetCornerCountSwitch(Shapes[i].Type))) * GetAreaSwitch(Shapes[i]);
@@ -49,15 +77,49 @@ f32 CornerAreaSwitch(u32 ShapeCount, shape_union* Shapes) {
     return Accum;
 }
 
+template <u32 K>
+static f32 CornerAreaSwitchK(u32 ShapeCount, shape_union* Shapes) {
+    return Accum<K>::Sum(ShapeCount, [Shapes](u32 i) {
+        return (1.0f / (1.0f + (f32)GetCornerCountSwitch(Shapes[i].Type))) * GetAreaSwitch(Shapes[i]);
+    });
+}
+
 f32 CornerAreaSwitch4(u32 ShapeCount, shape_union* Shapes) {
-    f32 Accum0 = 0.0f, Accum1 = 0.0f, Accum2 = 0.0f, Accum3 = 0.0f;
-    ShapeCount /= 4;
-    while (ShapeCount--) {
-        Accum0 += (1.0f / (1.0f + (f32)GetCornerCountSwitch(Shapes[0].Type))) * GetAreaSwitch(Shapes[0]);
-        Accum1 += (1.0f / (1.0f + (f32)GetCornerCountSwitch(Shapes[1].Type))) * GetAreaSwitch(Shapes[1]);
-        Accum2 += (1.0f / (1.0f + (f32)GetCornerCountSwitch(Shapes[2].Type))) * GetAreaSwitch(Shapes[2]);
-        Accum3 += (1.0f / (1.0f + (f32)GetCornerCountSwitch(Shapes[3].Type))) * GetAreaSwitch(Shapes[3]);
-        Shapes += 4;
-    }
-    return Accum0 + Accum1 + Accum2 + Accum3;
+    INSTRUMENT_SCOPE("CornerAreaSwitch4", ShapeCount, ShapeCount * sizeof(shape_union));
+    return CornerAreaSwitchK<4>(ShapeCount, Shapes);
+}
+f32 CornerAreaSwitch8(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("CornerAreaSwitch8", ShapeCount, ShapeCount * sizeof(shape_union));
+    return CornerAreaSwitchK<8>(ShapeCount, Shapes);
+}
+f32 CornerAreaSwitch16(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("CornerAreaSwitch16", ShapeCount, ShapeCount * sizeof(shape_union));
+    return CornerAreaSwitchK<16>(ShapeCount, Shapes);
+}
+
+// One pass over the first Metrics of area, corner area and perimeter; each
+// extra metric is one more switch per shape
+template <u32 Metrics>
+static shape_totals TotalMetricsSwitchK(u32 ShapeCount, shape_union* Shapes) {
+    shape_totals Totals;
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        f32 Area = GetAreaSwitch(Shapes[i]);
+        Totals.Area += Area;
+        if (Metrics > 1) {
+            Totals.CornerArea += (1.0f / (1.0f + (f32)GetCornerCountSwitch(Shapes[i].Type))) * Area;
+        }
+        if (Metrics > 2) {
+            Totals.Perimeter += GetPerimeterSwitch(Shapes[i]);
+        }
+    }
+    return Totals;
+}
+
+shape_totals TotalMetricsSwitch(u32 ShapeCount, shape_union* Shapes, u32 Metrics) {
+    INSTRUMENT_SCOPE("TotalMetricsSwitch", ShapeCount, ShapeCount * sizeof(shape_union));
+    switch (Metrics) {
+        case 1: return TotalMetricsSwitchK<1>(ShapeCount, Shapes);
+        case 2: return TotalMetricsSwitchK<2>(ShapeCount, Shapes);
+        default: return TotalMetricsSwitchK<3>(ShapeCount, Shapes);
+    }
 }
@@ -0,0 +1,268 @@
+// Dispatch scaling benchmark: one build per DISPATCH_KINDS (K) shape kinds.
+// The K kinds are generated from one template; the switch cases, which the
+// language offers no way to expand from a pack, are written by CMake into
+// dispatch_cases.inc. Each pass draws its shapes uniformly from the first k
+// kinds, k = 2, 4, ... K, so the predictor sees a growing number of targets.
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+#include "shape_types.h"
+#include "bench_harness.h"
+
+#ifndef DISPATCH_KINDS
+#define DISPATCH_KINDS 100
+#endif
+
+constexpr u32 KindCount = DISPATCH_KINDS;
+
+// std::variant nests its alternatives recursively; beyond this many the
+// instantiation exceeds the template depth and takes minutes to compile
+#define DISPATCH_VARIANT_MAX_KINDS 256
+
+constexpr u32 N = 1000000;
+
+// Per-kind formula: every kind is Coefficient * Width * Height with its own
+// coefficient, so no two case bodies fold together
+constexpr f32 KindCoefficient(u32 Kind) { return 0.25f + 0.125f * f32(Kind % 29) + 0.001f * f32(Kind); }
+
+// Flat record for the switch, table and variant engines
+struct kind_union {
+    u32 Kind;
+    f32 Width;
+    f32 Height;
+};
+
+class kind_base {
+public:
+    kind_base(f32 WidthInit, f32 HeightInit) : Width(WidthInit), Height(HeightInit) { }
+    virtual ~kind_base() { }
+    virtual f32 Area() { return 0.0f; }
+    virtual u32 Kind() const = 0;
+    // Devirtualized sum over ShapeCount objects of the dynamic type of *this
+    virtual f32 AreaBatch(u32 ShapeCount, kind_base** Shapes) = 0;
+
+protected:
+    f32 Width, Height;
+};
+
+template <u32 I>
+class kind final : public kind_base {
+public:
+    kind(f32 WidthInit, f32 HeightInit) : kind_base(WidthInit, HeightInit) { }
+    static f32 Formula(f32 Width, f32 Height) { return KindCoefficient(I) * Width * Height; }
+    f32 Area() override { return Formula(Width, Height); }
+    u32 Kind() const override { return I; }
+    f32 AreaBatch(u32 ShapeCount, kind_base** Shapes) override {
+        f32 Accum = 0.0f;
+        for (u32 i = 0; i < ShapeCount; ++i) {
+            Accum += static_cast<kind*>(Shapes[i])->kind::Area();
+        }
+        return Accum;
+    }
+
+    // Non-virtual entry for std::visit
+    f32 ValueArea() const { return Formula(Width, Height); }
+};
+
+static f32 AreaSwitch(const kind_union& Shape) {
+    switch (Shape.Kind) {
+#include "dispatch_cases.inc"
+        default: return 0.0f;
+    }
+}
+
+using kind_formula = f32 (*)(f32 Width, f32 Height);
+using kind_factory = kind_base* (*)(f32 Width, f32 Height);
+
+template <u32 I>
+static kind_base* NewKind(f32 Width, f32 Height) { return new kind<I>(Width, Height); }
+
+template <std::size_t... I>
+static const kind_formula* FormulaTableOf(std::index_sequence<I...>) {
+    static const kind_formula Table[] = {&kind<I>::Formula...};
+    return Table;
+}
+
+template <std::size_t... I>
+static const kind_factory* FactoryTableOf(std::index_sequence<I...>) {
+    static const kind_factory Table[] = {&NewKind<I>...};
+    return Table;
+}
+
+static const kind_formula* const FormulaTable = FormulaTableOf(std::make_index_sequence<KindCount>());
+static const kind_factory* const FactoryTable = FactoryTableOf(std::make_index_sequence<KindCount>());
+
+// Virtual dispatch, one call per object
+static f32 TotalAreaVirtual(u32 ShapeCount, kind_base** Shapes) {
+    f32 Accum = 0.0f;
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        Accum += Shapes[i]->Area();
+    }
+    return Accum;
+}
+
+static f32 TotalAreaSwitch(u32 ShapeCount, const kind_union* Shapes) {
+    f32 Accum = 0.0f;
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        Accum += AreaSwitch(Shapes[i]);
+    }
+    return Accum;
+}
+
+// Indirect call through a table indexed by the kind tag
+static f32 TotalAreaFunctionTable(u32 ShapeCount, const kind_union* Shapes) {
+    f32 Accum = 0.0f;
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        Accum += FormulaTable[Shapes[i].Kind](Shapes[i].Width, Shapes[i].Height);
+    }
+    return Accum;
+}
+
+// Objects grouped by kind once; one virtual call per kind run
+struct kind_batches {
+    struct run {
+        u32 Begin;
+        u32 Count;
+    };
+
+    kind_batches(u32 ShapeCount, kind_base** Shapes) : shapes(Shapes, Shapes + ShapeCount) {
+        std::stable_sort(shapes.begin(), shapes.end(),
+                         [](const kind_base* a, const kind_base* b) { return a->Kind() < b->Kind(); });
+        for (u32 i = 0; i < ShapeCount; ++i) {
+            if (runs.empty() || shapes[i]->Kind() != shapes[runs.back().Begin]->Kind()) {
+                runs.push_back({i, 0});
+            }
+            ++runs.back().Count;
+        }
+    }
+
+    std::vector<kind_base*> shapes;
+    std::vector<run> runs;
+};
+
+static f32 TotalAreaBatched(kind_batches& Batches) {
+    f32 Accum = 0.0f;
+    for (const kind_batches::run& r : Batches.runs) {
+        kind_base** Run = Batches.shapes.data() + r.Begin;
+        Accum += Run[0]->AreaBatch(r.Count, Run);
+    }
+    return Accum;
+}
+
+#if DISPATCH_KINDS <= DISPATCH_VARIANT_MAX_KINDS
+template <class Seq>
+struct kind_variant_of;
+
+template <std::size_t... I>
+struct kind_variant_of<std::index_sequence<I...>> {
+    using type = std::variant<kind<I>...>;
+
+    static type Make(const kind_union& Shape) {
+        static const decltype(&MakeKind<0>) Table[] = {&MakeKind<I>...};
+        return Table[Shape.Kind](Shape.Width, Shape.Height);
+    }
+
+    template <std::size_t K>
+    static type MakeKind(f32 Width, f32 Height) {
+        return type(std::in_place_index<K>, Width, Height);
+    }
+};
+
+using kind_variants = kind_variant_of<std::make_index_sequence<KindCount>>;
+using kind_variant = kind_variants::type;
+
+static f32 TotalAreaVariant(u32 ShapeCount, const kind_variant* Shapes) {
+    f32 Accum = 0.0f;
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        Accum += std::visit([](const auto& Shape) { return Shape.ValueArea(); }, Shapes[i]);
+    }
+    return Accum;
+}
+#endif
+
+static BenchHarness harness;
+
+// Median time, and branch misses per shape when the counters are available
+static void Report(const char* engine, u32 active, const bench_stats& stats, f32 result) {
+    std::cout << "k=" << active << " " << engine << ": median " << stats.median_ms << " ms, "
+              << stats.median_ms * 1e6 / N << " ns/shape";
+    if (stats.has_counters) {
+        std::cout << ", " << stats.counters.branch_misses / N << " branch misses/shape";
+    }
+    std::cout << ", result = " << result << std::endl;
+}
+
+template <class F>
+static void Run(const char* engine, u32 active, F&& fn) {
+    f32 result = 0.0f;
+    bench_stats stats = harness.measure(fn, result);
+    Report(engine, active, stats, result);
+}
+
+int main(int argc, char** argv) {
+    bench_options options;
+    options.samples = 50;
+    options.warmup = 3;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.rfind("--samples=", 0) == 0) {
+            options.samples = std::max(1, std::atoi(arg.c_str() + 10));
+        } else if (arg.rfind("--pin=", 0) == 0) {
+            options.cpu = std::atoi(arg.c_str() + 6);
+        } else if (arg == "--counters") {
+            options.counters = true;
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--samples=N] [--pin=CPU] [--counters]" << std::endl;
+            return 1;
+        }
+    }
+    harness.configure(options);
+
+    std::cout << "Dispatch over " << KindCount << " kinds, " << N << " shapes per pass" << std::endl;
+
+    std::vector<u32> active_counts;
+    for (u32 k = 2; k < KindCount; k *= 2) {
+        active_counts.push_back(k);
+    }
+    active_counts.push_back(KindCount);
+
+    for (u32 active : active_counts) {
+        // Fixed seed, so every engine and every build sees the same sequence
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<f32> dimension(1.0f, 4.0f);
+        std::vector<kind_union> flat(N);
+        for (kind_union& shape : flat) {
+            shape = {static_cast<u32>(rng() % active), dimension(rng), dimension(rng)};
+        }
+
+        std::vector<std::unique_ptr<kind_base>> owned;
+        std::vector<kind_base*> objects;
+        owned.reserve(N);
+        objects.reserve(N);
+        for (const kind_union& shape : flat) {
+            owned.emplace_back(FactoryTable[shape.Kind](shape.Width, shape.Height));
+            objects.push_back(owned.back().get());
+        }
+        kind_batches batches(N, objects.data());
+
+        Run("virtual", active, [&] { return TotalAreaVirtual(N, objects.data()); });
+        Run("switch", active, [&] { return TotalAreaSwitch(N, flat.data()); });
+        Run("function table", active, [&] { return TotalAreaFunctionTable(N, flat.data()); });
+#if DISPATCH_KINDS <= DISPATCH_VARIANT_MAX_KINDS
+        std::vector<kind_variant> variants;
+        variants.reserve(N);
+        for (const kind_union& shape : flat) {
+            variants.push_back(kind_variants::Make(shape));
+        }
+        Run("variant", active, [&] { return TotalAreaVariant(N, variants.data()); });
+#endif
+        Run("sorted batches", active, [&] { return TotalAreaBatched(batches); });
+    }
+    return 0;
+}
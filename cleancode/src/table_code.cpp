@@ -1,13 +1,16 @@
 #include "shapes.h"
+#include "instrumentation.h"
+#include "accum.h"
+#include "simd_kernels.h"
+#include "type_aggregates.h"
 
-// Table-driven coefficients for area and corner-weighted area
-static const f32 AreaCTable[Shape_Count] = {1.0f, 1.0f, 0.5f, Pi32};
-static const f32 CornerAreaCTable[Shape_Count] = {
-    1.0f / (1.0f + 4.0f), // Square
-    1.0f / (1.0f + 4.0f), // Rectangle
-    0.5f / (1.0f + 3.0f), // Triangle
-    Pi32 // Circle (corner count is 0, so just Pi32)
-};
+// Table-driven coefficients for area and corner-weighted area, generated
+// from the shape traits
+static constexpr const f32* AreaCTable = ShapeAreaCoefficients;
+static constexpr const f32* CornerAreaCTable = ShapeCornerAreaCoefficients;
+static constexpr const f32* PerimeterCTable = ShapePerimeterCoefficients;
+static constexpr const f32* DiagonalCTable = ShapeDiagonalCoefficients;
+static constexpr const f32* BoundsCTable = ShapeBoundsCoefficients;
 
 f32 GetAreaUnion(const shape_union& Shape) {
     return AreaCTable[Shape.Type] * Shape.Width * Shape.Height;
@@ -17,7 +20,19 @@ f32 GetCornerAreaUnion(const shape_union& Shape) {
     return CornerAreaCTable[Shape.Type] * Shape.Width * Shape.Height;
 }
 
+// Branch-free, so the diagonal is computed for every type and weighted by
+// zero where it does not count
+f32 GetPerimeterUnion(const shape_union& Shape) {
+    return PerimeterCTable[Shape.Type] * (Shape.Width + Shape.Height) +
+           DiagonalCTable[Shape.Type] * std::sqrt(Shape.Width * Shape.Width + Shape.Height * Shape.Height);
+}
+
+shape_bounds GetBoundsUnion(const shape_union& Shape) {
+    return {BoundsCTable[Shape.Type] * Shape.Width, BoundsCTable[Shape.Type] * Shape.Height};
+}
+
 f32 TotalAreaUnion(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("TotalAreaUnion", ShapeCount, ShapeCount * sizeof(shape_union));
     f32 Accum = 0.0f;
     for (u32 i = 0; i < ShapeCount; ++i) {
         Accum += GetAreaUnion(Shapes[i]);
@@ -25,20 +40,27 @@ f32 TotalAreaUnion(u32 ShapeCount, shape_union* Shapes) {
     return Accum;
 }
 
+// Unrolled variants: K independent chains, any ShapeCount
+template <u32 K>
+static f32 TotalAreaUnionK(u32 ShapeCount, shape_union* Shapes) {
+    return Accum<K>::Sum(ShapeCount, [Shapes](u32 i) { return GetAreaUnion(Shapes[i]); });
+}
+
 f32 TotalAreaUnion4(u32 ShapeCount, shape_union* Shapes) {
-    f32 Accum0 = 0.0f, Accum1 = 0.0f, Accum2 = 0.0f, Accum3 = 0.0f;
-    ShapeCount /= 4;
-    while (ShapeCount--) {
-        Accum0 += GetAreaUnion(Shapes[0]);
-        Accum1 += GetAreaUnion(Shapes[1]);
-        Accum2 += GetAreaUnion(Shapes[2]);
-        Accum3 += GetAreaUnion(Shapes[3]);
-        Shapes += 4;
-    }
-    return Accum0 + Accum1 + Accum2 + Accum3;
+    INSTRUMENT_SCOPE("TotalAreaUnion4", ShapeCount, ShapeCount * sizeof(shape_union));
+    return TotalAreaUnionK<4>(ShapeCount, Shapes);
+}
+f32 TotalAreaUnion8(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("TotalAreaUnion8", ShapeCount, ShapeCount * sizeof(shape_union));
+    return TotalAreaUnionK<8>(ShapeCount, Shapes);
+}
+f32 TotalAreaUnion16(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("TotalAreaUnion16", ShapeCount, ShapeCount * sizeof(shape_union));
+    return TotalAreaUnionK<16>(ShapeCount, Shapes);
 }
 
 f32 CornerAreaUnion(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("CornerAreaUnion", ShapeCount, ShapeCount * sizeof(shape_union));
     f32 Accum = 0.0f;
     for (u32 i = 0; i < ShapeCount; ++i) {
         Accum += GetCornerAreaUnion(Shapes[i]);
@@ -46,15 +68,72 @@ f32 CornerAreaUnion(u32 ShapeCount, shape_union* Shapes) {
     return Accum;
 }
 
+template <u32 K>
+static f32 CornerAreaUnionK(u32 ShapeCount, shape_union* Shapes) {
+    return Accum<K>::Sum(ShapeCount, [Shapes](u32 i) { return GetCornerAreaUnion(Shapes[i]); });
+}
+
 f32 CornerAreaUnion4(u32 ShapeCount, shape_union* Shapes) {
-    f32 Accum0 = 0.0f, Accum1 = 0.0f, Accum2 = 0.0f, Accum3 = 0.0f;
-    ShapeCount /= 4;
-    while (ShapeCount--) {
-        Accum0 += GetCornerAreaUnion(Shapes[0]);
-        Accum1 += GetCornerAreaUnion(Shapes[1]);
-        Accum2 += GetCornerAreaUnion(Shapes[2]);
-        Accum3 += GetCornerAreaUnion(Shapes[3]);
-        Shapes += 4;
+    INSTRUMENT_SCOPE("CornerAreaUnion4", ShapeCount, ShapeCount * sizeof(shape_union));
+    return CornerAreaUnionK<4>(ShapeCount, Shapes);
+}
+f32 CornerAreaUnion8(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("CornerAreaUnion8", ShapeCount, ShapeCount * sizeof(shape_union));
+    return CornerAreaUnionK<8>(ShapeCount, Shapes);
+}
+f32 CornerAreaUnion16(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("CornerAreaUnion16", ShapeCount, ShapeCount * sizeof(shape_union));
+    return CornerAreaUnionK<16>(ShapeCount, Shapes);
+}
+
+// Vectorized table lookup straight over the AoS array, no precomputation
+f32 TotalAreaUnionSIMD(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("TotalAreaUnionSIMD", ShapeCount, ShapeCount * sizeof(shape_union));
+    return SimdKernels().union_sum(Shapes, ShapeCount, AreaCTable);
+}
+
+f32 CornerAreaUnionSIMD(u32 ShapeCount, shape_union* Shapes) {
+    INSTRUMENT_SCOPE("CornerAreaUnionSIMD", ShapeCount, ShapeCount * sizeof(shape_union));
+    return SimdKernels().union_sum(Shapes, ShapeCount, CornerAreaCTable);
+}
+
+// One pass over the first Metrics of area, corner area and perimeter; each
+// extra metric is one more set of table lookups per shape
+template <u32 Metrics>
+static shape_totals TotalMetricsUnionK(u32 ShapeCount, shape_union* Shapes) {
+    shape_totals Totals;
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        Totals.Area += GetAreaUnion(Shapes[i]);
+        if (Metrics > 1) {
+            Totals.CornerArea += GetCornerAreaUnion(Shapes[i]);
+        }
+        if (Metrics > 2) {
+            Totals.Perimeter += GetPerimeterUnion(Shapes[i]);
+        }
+    }
+    return Totals;
+}
+
+shape_totals TotalMetricsUnion(u32 ShapeCount, shape_union* Shapes, u32 Metrics) {
+    INSTRUMENT_SCOPE("TotalMetricsUnion", ShapeCount, ShapeCount * sizeof(shape_union));
+    switch (Metrics) {
+        case 1: return TotalMetricsUnionK<1>(ShapeCount, Shapes);
+        case 2: return TotalMetricsUnionK<2>(ShapeCount, Shapes);
+        default: return TotalMetricsUnionK<3>(ShapeCount, Shapes);
     }
-    return Accum0 + Accum1 + Accum2 + Accum3;
 }
+
+// Per-type aggregates: Shape_Count multiply-adds, whatever the shape count
+f32 TotalAreaUnion(const TypeAggregates& aggregates) {
+    INSTRUMENT_SCOPE("TotalAreaUnion/aggregates", Shape_Count, sizeof(TypeAggregates));
+    return aggregates.metric(AreaCTable);
+}
+
+f32 CornerAreaUnion(const TypeAggregates& aggregates) {
+    INSTRUMENT_SCOPE("CornerAreaUnion/aggregates", Shape_Count, sizeof(TypeAggregates));
+    return aggregates.metric(CornerAreaCTable);
+}
+
+// Coefficient tables for benchmarking individual kernel variants
+const f32* AreaCoefficients() { return AreaCTable; }
+const f32* CornerAreaCoefficients() { return CornerAreaCTable; }
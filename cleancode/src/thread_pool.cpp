@@ -0,0 +1,137 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <memory>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+// Best effort: without the call the worker runs wherever the scheduler puts it
+static void BindToCpus(const std::vector<int>& cpus) {
+#if defined(__linux__)
+    if (cpus.empty()) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : cpus) {
+        CPU_SET(cpu, &set);
+    }
+    sched_setaffinity(0, sizeof(set), &set);
+#else
+    (void)cpus;
+#endif
+}
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+    start(threadCount, {});
+}
+
+ThreadPool::ThreadPool(unsigned threadCount, const std::vector<int>& cpus) {
+    start(threadCount, cpus);
+}
+
+void ThreadPool::start(unsigned threadCount, const std::vector<int>& cpus) {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    workers.reserve(threadCount - 1);
+    for (unsigned i = 1; i < threadCount; ++i) {
+        workers.emplace_back([this, cpus] {
+            BindToCpus(cpus);
+            workerLoop();
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    if (workers.empty()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (stopping && tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+namespace {
+
+// Shared between the caller and the helper tasks. Helpers that are picked up
+// after the loop finished only touch 'next', so keeping the job alive through
+// a shared_ptr is enough to make late wake-ups harmless.
+struct parallel_job {
+    const std::function<void(size_t)>* fn;
+    size_t count;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    void drain() {
+        size_t completed = 0;
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            (*fn)(i);
+            ++completed;
+        }
+        if (completed && done.fetch_add(completed) + completed == count) {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.notify_all();
+        }
+    }
+};
+
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    if (workers.empty() || count == 1) {
+        for (size_t i = 0; i < count; ++i) {
+            fn(i);
+        }
+        return;
+    }
+
+    auto job = std::make_shared<parallel_job>();
+    job->fn = &fn;
+    job->count = count;
+
+    size_t helpers = std::min(workers.size(), count - 1);
+    for (size_t i = 0; i < helpers; ++i) {
+        submit([job] { job->drain(); });
+    }
+    job->drain();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->finished.wait(lock, [&] { return job->done.load() == count; });
+}
@@ -0,0 +1,70 @@
+#include "static_shapes.h"
+#include "instrumentation.h"
+#include "accum.h"
+
+shape_variant MakeShapeVariant(const shape_union& Shape) {
+    switch (Shape.Type) {
+        case Shape_Square: return square(Shape.Width);
+        case Shape_Rectangle: return rectangle(Shape.Width, Shape.Height);
+        case Shape_Triangle: return triangle(Shape.Width, Shape.Height);
+        default: return circle(Shape.Width);
+    }
+}
+
+// Qualified calls on the concrete alternative: no vtable load, inlined
+struct area_visitor {
+    template <class T>
+    f32 operator()(T& Shape) const { return Shape.T::Area(); }
+};
+
+struct corner_area_visitor {
+    template <class T>
+    f32 operator()(T& Shape) const { return shape_traits_of<T>::CornerWeight * Shape.T::Area(); }
+};
+
+f32 TotalAreaVariant(u32 ShapeCount, shape_variant* Shapes) {
+    INSTRUMENT_SCOPE("TotalAreaVariant", ShapeCount, ShapeCount * sizeof(shape_variant));
+    f32 Accum = 0.0f;
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        Accum += std::visit(area_visitor(), Shapes[i]);
+    }
+    return Accum;
+}
+
+f32 TotalAreaVariant4(u32 ShapeCount, shape_variant* Shapes) {
+    INSTRUMENT_SCOPE("TotalAreaVariant4", ShapeCount, ShapeCount * sizeof(shape_variant));
+    return Accum<4>::Sum(ShapeCount, [Shapes](u32 i) { return std::visit(area_visitor(), Shapes[i]); });
+}
+
+f32 CornerAreaVariant(u32 ShapeCount, shape_variant* Shapes) {
+    INSTRUMENT_SCOPE("CornerAreaVariant", ShapeCount, ShapeCount * sizeof(shape_variant));
+    f32 Accum = 0.0f;
+    for (u32 i = 0; i < ShapeCount; ++i) {
+        Accum += std::visit(corner_area_visitor(), Shapes[i]);
+    }
+    return Accum;
+}
+
+f32 CornerAreaVariant4(u32 ShapeCount, shape_variant* Shapes) {
+    INSTRUMENT_SCOPE("CornerAreaVariant4", ShapeCount, ShapeCount * sizeof(shape_variant));
+    return Accum<4>::Sum(ShapeCount, [Shapes](u32 i) { return std::visit(corner_area_visitor(), Shapes[i]); });
+}
+
+void AddStaticShape(StaticShapes& Set, const shape_union& Shape) {
+    switch (Shape.Type) {
+        case Shape_Square: Set.add(static_square(Shape.Width)); break;
+        case Shape_Rectangle: Set.add(static_rectangle(Shape.Width, Shape.Height)); break;
+        case Shape_Triangle: Set.add(static_triangle(Shape.Width, Shape.Height)); break;
+        default: Set.add(static_circle(Shape.Width)); break;
+    }
+}
+
+f32 TotalAreaStatic(const StaticShapes& Set) {
+    INSTRUMENT_SCOPE("TotalAreaStatic", Set.size(), 0);
+    return Set.TotalArea();
+}
+
+f32 CornerAreaStatic(const StaticShapes& Set) {
+    INSTRUMENT_SCOPE("CornerAreaStatic", Set.size(), 0);
+    return Set.CornerArea();
+}